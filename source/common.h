@@ -153,6 +153,8 @@ typedef uint32_t FIXED16_16;  // Q16.16 fixed-point
 #include "stats.h"
 
 #include "sha1.h"
+#include "movie.h"
+#include "trace.h"
 
 // - - - CROSS-PLATFORM TYPE DEFINITIONS - - -
 
@@ -293,6 +295,13 @@ bool ReGBA_IsRenderingNextFrame(void);
  */
 void ReGBA_DisplayFPS(void);
 
+/*
+ * Returns the time, in nanoseconds, according to the most precise monotonic
+ * clock available to the port being compiled. Only the difference between
+ * two return values is meaningful.
+ */
+uint64_t ReGBA_GetMonotonicTime(void);
+
 /*
  * Loads the given memory buffer with real-time clock data from the clock most
  * appropriate for the port being compiled.
@@ -528,6 +537,31 @@ uint8_t* ReGBA_AllocateROM(size_t Size);
  */
 size_t ReGBA_AllocateOnDemandBuffer(void** Buffer);
 
+/*
+ * Allocates a buffer to hold the native code generated by the recompiler for
+ * one of the code caches. This function is called once for each code cache,
+ * by init_translater, before any code is translated.
+ * Input:
+ *   Region: The code cache to allocate.
+ *   Size: Pointer to the size requested by the core, which is the port's
+ *   READONLY_CODE_CACHE_SIZE or WRITABLE_CODE_CACHE_SIZE.
+ * Output:
+ *   Size: Updated with the size actually allocated, which may be larger or
+ *   smaller than requested if the port is configured to do so. It must stay
+ *   larger than TRANSLATION_CACHE_LIMIT_THRESHOLD.
+ * Returns:
+ *   A pointer to the first byte of the buffer, which is kept for the
+ *   lifetime of the process.
+ * Output assertions:
+ *   The return value is non-NULL. If it isn't, then this is a fatal error.
+ *   The buffer is readable, writable and executable, and aligned to at least
+ *   32 bytes.
+ *   The emitter's direct jumps and calls must be able to reach the core's and
+ *   the port's native code from anywhere in the buffer. On MIPS, this means
+ *   the buffer lies in the same 256 MiB segment as the executable's code.
+ */
+uint8_t* ReGBA_AllocateCodeCache(TRANSLATION_REGION_TYPE Region, size_t* Size);
+
 /*
  * Frees the last allocation of memory made without a backing file by the port
  * being compiled. This allocation was made by either ReGBA_AllocateROM or
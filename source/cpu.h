@@ -171,9 +171,11 @@ uint8_t* block_lookup_address_dual(uint32_t pc);
 uint8_t* translate_block_arm(uint32_t pc);
 uint8_t* translate_block_thumb(uint32_t pc);
 
-extern uint8_t  readonly_code_cache[READONLY_CODE_CACHE_SIZE];
+extern uint8_t* readonly_code_cache;
+extern size_t   readonly_code_cache_size;
 extern uint8_t* readonly_next_code;
-extern uint8_t  writable_code_cache[WRITABLE_CODE_CACHE_SIZE];
+extern uint8_t* writable_code_cache;
+extern size_t   writable_code_cache_size;
 extern uint8_t* writable_next_code;
 
 #define MAX_IDLE_LOOPS 8
@@ -192,7 +194,10 @@ extern uint32_t in_interrupt;
 // extern uint32_t bios_mode;
 
 #define ROM_BRANCH_HASH_SIZE 65536 /* Must be a power of 2, 2 <= n <= 65536 */
-#define WRITABLE_HASH_SIZE 65536 /* Must be a power of 2, 2 <= n <= 65536 */
+#define WRITABLE_HASH_SIZE 65536 /* Must be a power of 2, n >= 4 */
+/* Number of live reuse headers after which the writable code cache is flushed
+ * to keep probe sequences in the reuse index short. (3/4 load factor) */
+#define WRITABLE_HASH_LIMIT (WRITABLE_HASH_SIZE / 4 * 3)
 
 void partial_clear_metadata(uint32_t address);
 void flush_translation_cache(TRANSLATION_REGION_TYPE translation_region,
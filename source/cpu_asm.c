@@ -72,32 +72,42 @@ uint32_t output_field = 0;
 uint32_t last_instruction = 0;
 
 struct ReuseHeader {
-	struct ReuseHeader* Next;
+	/* GBA PC at the start of the block. Bit 0 is set for Thumb code. */
 	uint32_t PC;
 	uint32_t GBACodeSize;
 };
 
-/* These represent code caches. */
-FULLY_UNINITIALIZED(uint8_t readonly_code_cache[READONLY_CODE_CACHE_SIZE])
-  __attribute__((aligned(CODE_ALIGN_SIZE)));
-uint8_t* readonly_next_code = readonly_code_cache;
+/* These represent code caches. They are allocated by the port in
+ * init_translater. */
+uint8_t* readonly_code_cache = NULL;
+size_t   readonly_code_cache_size = 0;
+uint8_t* readonly_next_code = NULL;
 
-FULLY_UNINITIALIZED(uint8_t writable_code_cache[WRITABLE_CODE_CACHE_SIZE])
-  __attribute__((aligned(CODE_ALIGN_SIZE)));
-uint8_t* writable_next_code = writable_code_cache;
+uint8_t* writable_code_cache = NULL;
+size_t   writable_code_cache_size = 0;
+uint8_t* writable_next_code = NULL;
 
 /* These represent Metadata Areas. */
 FULLY_UNINITIALIZED(uint32_t *rom_branch_hash[ROM_BRANCH_HASH_SIZE]);
-FULLY_UNINITIALIZED(struct ReuseHeader* writable_checksum_hash[WRITABLE_HASH_SIZE]);
-
-FULLY_UNINITIALIZED(uint8_t *iwram_block_ptrs[MAX_TAG_IWRAM + 1]);
+/* The Writable Area Cache's reuse index is an open-addressing hashtable keyed
+ * by the 64-bit hash of a block's GBA code. The low bits of the hash select
+ * the first slot to probe, and each slot keeps the upper 32 bits as a tag to
+ * skip most non-matching headers without reading them; a match is confirmed
+ * by comparing the code itself. A slot is free if its header pointer is NULL;
+ * its tag is only meaningful if it is not. */
+FULLY_UNINITIALIZED(uint32_t writable_reuse_tag[WRITABLE_HASH_SIZE]);
+FULLY_UNINITIALIZED(struct ReuseHeader* writable_reuse_header[WRITABLE_HASH_SIZE]);
+uint32_t writable_reuse_count = 0;
+
+/* The arrays indexed by tags are allocated when their first tag is. */
+uint8_t **iwram_block_ptrs = NULL;
 uint32_t iwram_block_tag_top = MIN_TAG;
-FULLY_UNINITIALIZED(uint8_t *ewram_block_ptrs[MAX_TAG_EWRAM + 1]);
+uint8_t **ewram_block_ptrs = NULL;
 uint32_t ewram_block_tag_top = MIN_TAG;
-FULLY_UNINITIALIZED(uint8_t *vram_block_ptrs[MAX_TAG_VRAM + 1]);
+uint8_t **vram_block_ptrs = NULL;
 uint32_t vram_block_tag_top = MIN_TAG;
 
-FULLY_UNINITIALIZED(uint8_t *bios_block_ptrs[MAX_TAG_BIOS + 1]);
+uint8_t **bios_block_ptrs = NULL;
 uint32_t bios_block_tag_top = MIN_TAG;
 
 uint32_t iwram_code_min = 0xFFFFFFFF;
@@ -272,42 +282,56 @@ extern void call_bios_hle(void* func);
       pc_address_block = load_gamepak_page(pc_region & 0x3FF);                \
   }                                                                           \
 
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 static inline void StatsAddARMOpcode()
 {
-	Stats.ARMOpcodesDecoded++;
+	if (unlikely(PerformanceCounters))
+		Stats.ARMOpcodesDecoded++;
 }
 
 static inline void StatsAddThumbOpcode()
 {
-	Stats.ThumbOpcodesDecoded++;
+	if (unlikely(PerformanceCounters))
+		Stats.ThumbOpcodesDecoded++;
 }
 
 static inline void StatsAddWritableReuse(uint32_t Opcodes)
 {
-	Stats.BlockReuseCount++;
-	Stats.OpcodeReuseCount += Opcodes;
+	if (unlikely(PerformanceCounters))
+	{
+		Stats.BlockReuseCount++;
+		Stats.OpcodeReuseCount += Opcodes;
+	}
 }
 
 static inline void StatsAddWritableRecompilation(uint32_t Opcodes)
 {
-	Stats.BlockRecompilationCount++;
-	Stats.OpcodeRecompilationCount += Opcodes;
+	if (unlikely(PerformanceCounters))
+	{
+		Stats.BlockRecompilationCount++;
+		Stats.OpcodeRecompilationCount += Opcodes;
+	}
 }
-#else
-static inline void StatsAddARMOpcode() {}
-
-static inline void StatsAddThumbOpcode() {}
 
-static inline void StatsAddWritableReuse(uint32_t Opcodes) {}
+// In flag_data, bit 12 marks instructions that read C as an operand (ADC,
+// SBC, RSC, RRX) and bit 13 those that set the flags lazily. Any other
+// instruction that sets flags computes them one by one, so it needs them in
+// s4-s7 as bits first; so do the readers of C.
 
-static inline void StatsAddWritableRecompilation(uint32_t Opcodes) {}
-#endif
+#define generate_flags_for_instruction()                                      \
+  if((flag_status & 0x1000) ||                                                \
+   ((flag_status & 0x0F) && !(flag_status & 0x2000)))                         \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+  }                                                                           \
 
 #define translate_arm_instruction()                                           \
+  flag_status = block_data.arm[block_data_position].flag_data;                \
   opcode = opcodes.arm[block_data_position];                                  \
   condition = block_data.arm[block_data_position].condition;                  \
   uint32_t has_condition_header = 0;                                          \
+  uint32_t skipped_flag_cache_state = FLAGS_UNKNOWN;                          \
+                                                                              \
+  generate_flags_for_instruction();                                           \
                                                                               \
   if((condition != 0x0E) || (condition >= 0x20))                              \
   {                                                                           \
@@ -317,6 +341,7 @@ static inline void StatsAddWritableRecompilation(uint32_t Opcodes) {}
     {                                                                         \
       arm_conditional_block_header();                                         \
       has_condition_header = 1;                                               \
+      skipped_flag_cache_state = flag_cache_state;                            \
     }                                                                         \
   }                                                                           \
                                                                               \
@@ -1693,12 +1718,163 @@ static inline void StatsAddWritableRecompilation(uint32_t Opcodes) {}
   if(has_condition_header)                                                    \
   {                                                                           \
     generate_branch_patch_conditional(backpatch_address, translation_ptr);    \
+    /* The flags may be in either form if the instruction was skipped */      \
+    if(flag_cache_state != skipped_flag_cache_state)                          \
+      flag_cache_state = FLAGS_UNKNOWN;                                       \
   }                                                                           \
                                                                               \
   pc += 4                                                                     \
 
+#define arm_flag_modifies_all()                                               \
+  flag_status |= 0xFF                                                         \
+
+#define arm_flag_modifies_all_lazily()                                        \
+  flag_status |= 0x20FF                                                       \
+
+#define arm_flag_modifies_zn()                                                \
+  flag_status |= 0xCC                                                         \
+
+#define arm_flag_modifies_zn_maybe_c()                                        \
+  flag_status |= 0xCE                                                         \
+
+#define arm_flag_requires_c()                                                 \
+  flag_status |= 0x1200                                                       \
+
+#define arm_flag_requires_all()                                               \
+  flag_status |= 0xF00                                                        \
+
+#define arm_flag_data_proc()                                                  \
+  switch((opcode >> 21) & 0x0F)                                               \
+  {                                                                           \
+    /* ADC, SBC, RSC */                                                       \
+    case 0x5 ... 0x7:                                                         \
+      arm_flag_requires_c();                                                  \
+      break;                                                                  \
+  }                                                                           \
+  if(opcode & 0x00100000)                                                     \
+  {                                                                           \
+    switch((opcode >> 21) & 0x0F)                                             \
+    {                                                                         \
+      /* SUBS, RSBS, ADDS, CMP, CMN */                                        \
+      case 0x2 ... 0x4:                                                       \
+      case 0xA ... 0xB:                                                       \
+        arm_flag_modifies_all_lazily();                                       \
+        break;                                                                \
+                                                                              \
+      /* ADCS, SBCS, RSCS */                                                  \
+      case 0x5 ... 0x7:                                                       \
+        arm_flag_modifies_all();                                              \
+        break;                                                                \
+                                                                              \
+      /* ANDS, EORS, TST, TEQ, ORRS, MOVS, BICS, MVNS: the shifter carry-out  \
+         may leave C alone, so C is never a sure write */                     \
+      default:                                                                \
+        arm_flag_modifies_zn_maybe_c();                                       \
+        break;                                                                \
+    }                                                                         \
+  }                                                                           \
+  /* Writing to the PC exits the block */                                     \
+  if(((opcode >> 12) & 0x0F) == 0x0F)                                         \
+  {                                                                           \
+    arm_flag_requires_all();                                                  \
+  }                                                                           \
+
+// The flags read by each condition, as N = 0x8, Z = 0x4, C = 0x2, V = 0x1.
+// NV is never used on the GBA and is taken to need everything.
+static const uint8_t arm_condition_flags[16] = {
+  /* EQ   NE   CS   CC   MI   PL   VS   VC */
+    0x4, 0x4, 0x2, 0x2, 0x8, 0x8, 0x1, 0x1,
+  /* HI   LS   GE   LT   GT   LE   AL   NV */
+    0x6, 0x6, 0x9, 0x9, 0xD, 0xD, 0x0, 0xF
+};
+
+// Same encoding as thumb_flag_status. ARM instructions are conditional, so
+// an instruction whose condition is not AL may be skipped at run time: it
+// cannot be trusted to overwrite any flag, and it reads the flags tested by
+// its condition.
 static void arm_flag_status(block_data_arm_type* block_data, uint32_t opcode)
 {
+  uint16_t flag_status = 0;
+  uint32_t condition = opcode >> 28;
+
+  switch((opcode >> 25) & 0x07)
+  {
+    /* Data processing with a register operand, multiply, PSR transfer, BX,
+       SWP, halfword transfer */
+    case 0x00:
+      if(((opcode & 0x0FBF0FFF) == 0x010F0000) ||
+       ((opcode & 0x0FB0F000) == 0x0120F000) ||
+       ((opcode & 0x0FFFFFF0) == 0x012FFF10))
+      {
+        /* MRS rd, psr; MSR psr, rm; BX rm */
+        arm_flag_requires_all();
+      }
+      else if((opcode & 0x90) == 0x90)
+      {
+        /* MULS, MLAS and the long multiplies set N and Z. SWP and the
+           halfword transfers leave the flags alone. */
+        if(((opcode & 0x0F1000F0) == 0x00100090))
+          arm_flag_modifies_zn();
+        if((opcode & 0x0010F000) == 0x0010F000)
+          arm_flag_requires_all();
+      }
+      else
+      {
+        /* ROR #0 is RRX, which shifts C in */
+        if((opcode & 0xFF0) == 0x060)
+          arm_flag_requires_c();
+        arm_flag_data_proc();
+      }
+      break;
+
+    /* Data processing with an immediate operand, MSR psr, imm */
+    case 0x01:
+      if((opcode & 0x0FB0F000) == 0x0320F000)
+      {
+        arm_flag_requires_all();
+      }
+      else
+      {
+        arm_flag_data_proc();
+      }
+      break;
+
+    /* LDR, STR with a register offset */
+    case 0x03:
+      if((opcode & 0xFF0) == 0x060)
+        arm_flag_requires_c();
+      /* fall through */
+
+    /* LDR, STR with an immediate offset */
+    case 0x02:
+      /* LDR pc exits the block */
+      if((opcode & 0x0010F000) == 0x0010F000)
+        arm_flag_requires_all();
+      break;
+
+    /* LDM, STM */
+    case 0x04:
+      /* LDM {..., pc} exits the block */
+      if((opcode & 0x00108000) == 0x00108000)
+        arm_flag_requires_all();
+      break;
+
+    /* B, BL */
+    case 0x05:
+    /* SWI (and coprocessor instructions, which the GBA doesn't have) */
+    case 0x06:
+    case 0x07:
+      arm_flag_requires_all();
+      break;
+  }
+
+  if(condition != 0x0E)
+  {
+    flag_status &= ~0xF0;
+    flag_status |= arm_condition_flags[condition] << 8;
+  }
+
+  block_data->flag_data = flag_status;
 }
 
 #define translate_thumb_instruction()                                         \
@@ -1706,6 +1882,7 @@ static void arm_flag_status(block_data_arm_type* block_data, uint32_t opcode)
   last_opcode = opcode;                                                       \
   opcode = opcodes.thumb[block_data_position];                                \
                                                                               \
+  generate_flags_for_instruction();                                           \
   StatsAddThumbOpcode();                                                      \
                                                                               \
   switch((opcode >> 8) & 0xFF)                                                \
@@ -2149,6 +2326,9 @@ static void arm_flag_status(block_data_arm_type* block_data, uint32_t opcode)
 #define thumb_flag_modifies_all()                                             \
   flag_status |= 0xFF                                                         \
 
+#define thumb_flag_modifies_all_lazily()                                      \
+  flag_status |= 0x20FF                                                       \
+
 #define thumb_flag_modifies_zn()                                              \
   flag_status |= 0xCC                                                         \
 
@@ -2162,7 +2342,7 @@ static void arm_flag_status(block_data_arm_type* block_data, uint32_t opcode)
   flag_status |= 0x22                                                         \
 
 #define thumb_flag_requires_c()                                               \
-  flag_status |= 0x200                                                        \
+  flag_status |= 0x1200                                                       \
 
 #define thumb_flag_requires_all()                                             \
   flag_status |= 0xF00                                                        \
@@ -2192,7 +2372,7 @@ static void thumb_flag_status(block_data_thumb_type* block_data, uint16_t opcode
     case 0x28 ... 0x3F:
     case 0x45:
       /* CMP rd, rs */
-      thumb_flag_modifies_all();
+      thumb_flag_modifies_all_lazily();
       break;
 
     /* mov reg, imm */
@@ -2246,7 +2426,7 @@ static void thumb_flag_status(block_data_thumb_type* block_data, uint16_t opcode
       if((opcode >> 6) & 0x03)
       {
         /* NEG, CMP, CMN */
-        thumb_flag_modifies_all();
+        thumb_flag_modifies_all_lazily();
       }
       else
       {
@@ -2295,11 +2475,33 @@ static void thumb_flag_status(block_data_thumb_type* block_data, uint16_t opcode
 #define vram_max_tag  MAX_TAG_VRAM
 #define bios_max_tag  MAX_TAG_BIOS
 
+#define block_lookup_allocate_ptrs(metadata_area)                             \
+  if (metadata_area##_block_ptrs == NULL)                                     \
+  {                                                                           \
+    metadata_area##_block_ptrs =                                              \
+     malloc((metadata_area##_max_tag + 1) * sizeof(uint8_t *));               \
+    if (metadata_area##_block_ptrs == NULL)                                   \
+    {                                                                         \
+      ReGBA_Trace("E: Out of memory for the block pointer array");            \
+      exit(1);                                                                \
+    }                                                                         \
+  }                                                                           \
+
 #define block_lookup_translate_arm()                                          \
-  translation_result = translate_block_arm(pc)                                \
+  {                                                                           \
+    enum FrameTimeCategory previous_time_category =                           \
+     StatsEnterFrameTime(FRAME_TIME_TRANSLATION);                             \
+    translation_result = translate_block_arm(pc);                             \
+    StatsEnterFrameTime(previous_time_category);                              \
+  }                                                                           \
 
 #define block_lookup_translate_thumb()                                        \
-  translation_result = translate_block_thumb(pc)                              \
+  {                                                                           \
+    enum FrameTimeCategory previous_time_category =                           \
+     StatsEnterFrameTime(FRAME_TIME_TRANSLATION);                             \
+    translation_result = translate_block_thumb(pc);                           \
+    StatsEnterFrameTime(previous_time_category);                              \
+  }                                                                           \
 
 /*
  * MIN_TAG is the smallest tag that can be used. 0xFFFF is off-limits because
@@ -2356,6 +2558,7 @@ static void thumb_flag_status(block_data_thumb_type* block_data, uint16_t opcode
       clear_metadata_area(metadata_area##_metadata_area,                      \
         CLEAR_REASON_LAST_TAG);                                               \
     }                                                                         \
+    block_lookup_allocate_ptrs(metadata_area);                                \
                                                                               \
     translation_recursion_level++;                                            \
     block_lookup_translate_##instruction_type();                              \
@@ -2406,6 +2609,7 @@ static void thumb_flag_status(block_data_thumb_type* block_data, uint16_t opcode
       clear_metadata_area(metadata_area##_metadata_area,                      \
         CLEAR_REASON_LAST_TAG);                                               \
     }                                                                         \
+    block_lookup_allocate_ptrs(metadata_area);                                \
                                                                               \
     translation_recursion_level++;                                            \
     block_address = mem_type##_next_code + block_prologue_size;               \
@@ -2483,22 +2687,22 @@ static inline void AdjustTranslationBufferPeak(TRANSLATION_REGION_TYPE translati
       break;                                                                  \
                                                                               \
     case 0x2:                                                                 \
-      location = ewram_metadata + (pc & 0x3FFFC);                             \
+      location = METADATA_ENTRY_WRITE(ewram, pc & 0x3FFFC);                   \
       block_lookup_translate(type, writable, ewram);                          \
       AdjustTranslationBufferPeak(TRANSLATION_REGION_WRITABLE);               \
       break;                                                                  \
                                                                               \
     case 0x3:                                                                 \
-      location = iwram_metadata + (pc & 0x7FFC);                              \
+      location = METADATA_ENTRY_WRITE(iwram, pc & 0x7FFC);                    \
       block_lookup_translate(type, writable, iwram);                          \
       AdjustTranslationBufferPeak(TRANSLATION_REGION_WRITABLE);               \
       break;                                                                  \
                                                                               \
     case 0x6:                                                                 \
       if (pc & 0x10000)                                                       \
-        location = vram_metadata + (pc & 0x17FFC);                            \
+        location = METADATA_ENTRY_WRITE(vram, pc & 0x17FFC);                  \
       else                                                                    \
-        location = vram_metadata + (pc & 0xFFFC);                             \
+        location = METADATA_ENTRY_WRITE(vram, pc & 0xFFFC);                   \
       block_lookup_translate(type, writable, vram);                           \
       AdjustTranslationBufferPeak(TRANSLATION_REGION_WRITABLE);               \
       break;                                                                  \
@@ -2701,6 +2905,7 @@ uint8_t *block_lookup_address_dual(uint32_t pc)
   translation_target = block_lookup_address_arm(branch_target)                \
 
 #define arm_instruction_width 4
+#define arm_reuse_pc_bit 0
 #define arm_instruction_nibbles 8
 #define arm_instruction_type uint32_t
 
@@ -2713,11 +2918,28 @@ uint8_t *block_lookup_address_dual(uint32_t pc)
   cycle_count += cpu_waitstate_cycles_seq[1][pc >> 24]                        \
 
 #endif
-// For now this just sets a variable that says flags should always be
-// computed.
+// Same liveness analysis as thumb_dead_flag_eliminate (see below), except
+// that all flags are taken to be needed after the last instruction, because
+// a block may also end by falling into the next one.
+//
+// Both passes keep bits 12 and 13 of each instruction's flag_data for
+// generate_flags_for_instruction.
 
 #define arm_dead_flag_eliminate()                                             \
-  flag_status = 0xF                                                           \
+{                                                                             \
+  uint32_t needed_mask = 0x0F;                                                \
+                                                                              \
+  block_data_position--;                                                      \
+  while(block_data_position >= 0)                                             \
+  {                                                                           \
+    flag_status = block_data.arm[block_data_position].flag_data;              \
+    block_data.arm[block_data_position].flag_data =                           \
+     (flag_status & (needed_mask | 0x3000));                                  \
+    needed_mask &= ~((flag_status >> 4) & 0x0F);                              \
+    needed_mask |= (flag_status >> 8) & 0x0F;                                 \
+    block_data_position--;                                                    \
+  }                                                                           \
+}                                                                             \
 
 // The following Thumb instructions can exit:
 // b, bl, bx, swi, pop {... pc}, and mov pc, ..., the latter being a hireg
@@ -2785,6 +3007,7 @@ uint8_t *block_lookup_address_dual(uint32_t pc)
     translation_target = block_lookup_address_arm(branch_target)              \
 
 #define thumb_instruction_width 2
+#define thumb_reuse_pc_bit 1
 #define thumb_instruction_nibbles 4
 #define thumb_instruction_type uint16_t
 
@@ -2828,16 +3051,16 @@ uint8_t *block_lookup_address_dual(uint32_t pc)
 #define thumb_dead_flag_eliminate()                                           \
 {                                                                             \
   uint32_t needed_mask;                                                       \
-  needed_mask = block_data.thumb[block_data_position].flag_data >> 8;         \
+  needed_mask = (block_data.thumb[block_data_position].flag_data >> 8) & 0x0F;\
                                                                               \
   block_data_position--;                                                      \
   while(block_data_position >= 0)                                             \
   {                                                                           \
     flag_status = block_data.thumb[block_data_position].flag_data;            \
     block_data.thumb[block_data_position].flag_data =                         \
-     (flag_status & needed_mask);                                             \
+     (flag_status & (needed_mask | 0x3000));                                  \
     needed_mask &= ~((flag_status >> 4) & 0x0F);                              \
-    needed_mask |= flag_status >> 8;                                          \
+    needed_mask |= (flag_status >> 8) & 0x0F;                                 \
     block_data_position--;                                                    \
   }                                                                           \
 }                                                                             \
@@ -2862,16 +3085,16 @@ FULLY_UNINITIALIZED(opcode_data_type opcodes);
   switch (block_end_pc >> 24)                                                 \
   {                                                                           \
     case 0x02: /* EWRAM */                                                    \
-      ewram_metadata[(block_end_pc & 0x3FFFC) | 3] |= 0x2;                    \
+      METADATA_ENTRY_WRITE(ewram, block_end_pc & 0x3FFFC)[3] |= 0x2;          \
       break;                                                                  \
     case 0x03: /* IWRAM */                                                    \
-      iwram_metadata[(block_end_pc & 0x7FFC) | 3] |= 0x2;                     \
+      METADATA_ENTRY_WRITE(iwram, block_end_pc & 0x7FFC)[3] |= 0x2;           \
       break;                                                                  \
     case 0x06: /* VRAM */                                                     \
       if (block_end_pc & 0x10000)                                             \
-        vram_metadata[(block_end_pc & 0x17FFC) | 3] |= 0x2;                   \
+        METADATA_ENTRY_WRITE(vram, block_end_pc & 0x17FFC)[3] |= 0x2;         \
       else                                                                    \
-        vram_metadata[(block_end_pc & 0xFFFC) | 3] |= 0x2;                    \
+        METADATA_ENTRY_WRITE(vram, block_end_pc & 0xFFFC)[3] |= 0x2;          \
       break;                                                                  \
   }                                                                           \
 
@@ -2879,16 +3102,16 @@ FULLY_UNINITIALIZED(opcode_data_type opcodes);
   switch (block_end_pc >> 24)                                                 \
   {                                                                           \
     case 0x02: /* EWRAM */                                                    \
-      ewram_metadata[(block_end_pc & 0x3FFFC) | 3] |= 0x1;                    \
+      METADATA_ENTRY_WRITE(ewram, block_end_pc & 0x3FFFC)[3] |= 0x1;          \
       break;                                                                  \
     case 0x03: /* IWRAM */                                                    \
-      iwram_metadata[(block_end_pc & 0x7FFC) | 3] |= 0x1;                     \
+      METADATA_ENTRY_WRITE(iwram, block_end_pc & 0x7FFC)[3] |= 0x1;           \
       break;                                                                  \
     case 0x06: /* VRAM */                                                     \
       if (block_end_pc & 0x10000)                                             \
-        vram_metadata[(block_end_pc & 0x17FFC) | 3] |= 0x1;                   \
+        METADATA_ENTRY_WRITE(vram, block_end_pc & 0x17FFC)[3] |= 0x1;         \
       else                                                                    \
-        vram_metadata[(block_end_pc & 0xFFFC) | 3] |= 0x1;                    \
+        METADATA_ENTRY_WRITE(vram, block_end_pc & 0xFFFC)[3] |= 0x1;          \
       break;                                                                  \
   }                                                                           \
 
@@ -2902,16 +3125,16 @@ FULLY_UNINITIALIZED(opcode_data_type opcodes);
     switch (previous_pc >> 24)                                                \
     {                                                                         \
       case 0x02: /* EWRAM */                                                  \
-        ewram_metadata[(previous_pc & 0x3FFFC) | 3] |= 0x8;                   \
+        METADATA_ENTRY_WRITE(ewram, previous_pc & 0x3FFFC)[3] |= 0x8;         \
         break;                                                                \
       case 0x03: /* IWRAM */                                                  \
-        iwram_metadata[(previous_pc & 0x7FFC) | 3] |= 0x8;                    \
+        METADATA_ENTRY_WRITE(iwram, previous_pc & 0x7FFC)[3] |= 0x8;          \
         break;                                                                \
       case 0x06: /* VRAM */                                                   \
         if (previous_pc & 0x10000)                                            \
-          vram_metadata[(previous_pc & 0x17FFC) | 3] |= 0x8;                  \
+          METADATA_ENTRY_WRITE(vram, previous_pc & 0x17FFC)[3] |= 0x8;        \
         else                                                                  \
-          vram_metadata[(previous_pc & 0xFFFC) | 3] |= 0x8;                   \
+          METADATA_ENTRY_WRITE(vram, previous_pc & 0xFFFC)[3] |= 0x8;         \
         break;                                                                \
     }                                                                         \
   }                                                                           \
@@ -2923,16 +3146,16 @@ FULLY_UNINITIALIZED(opcode_data_type opcodes);
     switch (previous_pc >> 24)                                                \
     {                                                                         \
       case 0x02: /* EWRAM */                                                  \
-        ewram_metadata[(previous_pc & 0x3FFFC) | 3] |= 0x4;                   \
+        METADATA_ENTRY_WRITE(ewram, previous_pc & 0x3FFFC)[3] |= 0x4;         \
         break;                                                                \
       case 0x03: /* IWRAM */                                                  \
-        iwram_metadata[(previous_pc & 0x7FFC) | 3] |= 0x4;                    \
+        METADATA_ENTRY_WRITE(iwram, previous_pc & 0x7FFC)[3] |= 0x4;          \
         break;                                                                \
       case 0x06: /* VRAM */                                                   \
         if (previous_pc & 0x10000)                                            \
-          vram_metadata[(previous_pc & 0x17FFC) | 3] |= 0x4;                  \
+          METADATA_ENTRY_WRITE(vram, previous_pc & 0x17FFC)[3] |= 0x4;        \
         else                                                                  \
-          vram_metadata[(previous_pc & 0xFFFC) | 3] |= 0x4;                   \
+          METADATA_ENTRY_WRITE(vram, previous_pc & 0xFFFC)[3] |= 0x4;         \
         break;                                                                \
     }                                                                         \
   }                                                                           \
@@ -3040,59 +3263,22 @@ FULLY_UNINITIALIZED(opcode_data_type opcodes);
 #define thumb_fix_pc()                                                        \
   pc &= ~0x01                                                                 \
 
-#if defined TRACE || defined TRACE_RECOMPILATION
+/* Events recorded in the trace ring (see trace.h) for each type of block. */
+#define arm_translate_event   TRACE_EVENT_TRANSLATE_ARM
+#define thumb_translate_event TRACE_EVENT_TRANSLATE_THUMB
+#define arm_reuse_event       TRACE_EVENT_REUSE_ARM
+#define thumb_reuse_event     TRACE_EVENT_REUSE_THUMB
 
 #define trace_recompilation(type)                                             \
-    ReGBA_Trace("T: At %08X, block size %u, checksum %04X",                   \
-     block_start_pc, block_end_pc - block_start_pc, checksum);                \
-    char Line[80], Element[10];                                               \
-    Line[0] = ' '; Line[1] = '\0';                                            \
-    uint32_t pc_itr;                                                          \
-    for (pc_itr = block_start_pc; pc_itr < block_end_pc;                      \
-         pc_itr += type##_instruction_width)                                  \
-    {                                                                         \
-      sprintf(Element, "%0" EXPAND_AS_STRING(type##_instruction_nibbles) "X ",\
-       opcodes.type[(pc_itr - block_start_pc) / type##_instruction_width]);   \
-      strcat(Line, Element);                                                  \
-      if (strlen(Line) >= 59)                                                 \
-      {                                                                       \
-        ReGBA_Trace(Line);                                                    \
-        Line[0] = ' '; Line[1] = '\0';                                        \
-      }                                                                       \
-    }                                                                         \
-    if (Line[1] != '\0')                                                      \
-    {                                                                         \
-      ReGBA_Trace(Line);                                                      \
-    }                                                                         \
-
-#else
-
-#define trace_recompilation(type)
-
-#endif
-
-#if defined TRACE || defined TRACE_REUSE
+  trace_event(type##_translate_event, block_start_pc,                         \
+   block_end_pc - block_start_pc, (uint32_t) hash)                            \
 
-#define trace_reuse()                                                         \
-        ReGBA_Trace("T: At %08X, block size %u, checksum %04X, \"reused\"",      \
-        block_start_pc, block_end_pc - block_start_pc, checksum);             \
-
-#else
-
-#define trace_reuse()
-
-#endif
-
-#if defined TRACE || defined TRACE_TRANSLATION_REQUESTS
+#define trace_reuse(type)                                                     \
+  trace_event(type##_reuse_event, block_start_pc,                             \
+   block_end_pc - block_start_pc, (uint32_t) hash)                            \
 
 #define trace_translation_request()                                           \
-  ReGBA_Trace("T: At %08X, translation requested", pc);                       \
-
-#else
-
-#define trace_translation_request()
-
-#endif
+  trace_event(TRACE_EVENT_TRANSLATION_REQUEST, pc, 0, 0)                      \
 
 #define translate_block_builder(type)                                         \
 uint8_t* translate_block_##type(uint32_t pc)                                  \
@@ -3116,6 +3302,7 @@ uint8_t* translate_block_##type(uint32_t pc)                                  \
   uint8_t *translation_cache_limit = NULL;                                    \
   int32_t i;                                                                  \
   uint32_t flag_status;                                                       \
+  uint32_t flag_cache_state = FLAGS_UNKNOWN;                                  \
   block_exit_type block_exits[MAX_EXITS];                                     \
                                                                               \
   generate_block_extra_vars_##type();                                         \
@@ -3147,12 +3334,12 @@ uint8_t* translate_block_##type(uint32_t pc)                                  \
   {                                                                           \
     case TRANSLATION_REGION_READONLY:                                         \
       translation_ptr = readonly_next_code;                                   \
-      translation_cache_limit = readonly_code_cache + READONLY_CODE_CACHE_SIZE\
+      translation_cache_limit = readonly_code_cache + readonly_code_cache_size\
        - TRANSLATION_CACHE_LIMIT_THRESHOLD;                                   \
       break;                                                                  \
     case TRANSLATION_REGION_WRITABLE:                                         \
       translation_ptr = writable_next_code;                                   \
-      translation_cache_limit = writable_code_cache + WRITABLE_CODE_CACHE_SIZE\
+      translation_cache_limit = writable_code_cache + writable_code_cache_size\
        - TRANSLATION_CACHE_LIMIT_THRESHOLD;                                   \
       break;                                                                  \
     default:                                                                  \
@@ -3171,24 +3358,25 @@ uint8_t* translate_block_##type(uint32_t pc)                                  \
   {                                                                           \
     scan_block(type, yes);                                                    \
                                                                               \
-    /* Is a block with this checksum available? */                            \
-    uint16_t checksum = block_checksum_##type(block_data_position);           \
+    /* Is a block with this hash available? */                                \
+    uint32_t reuse_pc = block_start_pc | type##_reuse_pc_bit;                 \
+    uint64_t hash = block_hash(reuse_pc, block_end_pc - block_start_pc);      \
+    uint32_t tag = (uint32_t) (hash >> 32);                                   \
                                                                               \
-    /* Where can we modify the address of the current header for linking? */  \
-    struct ReuseHeader** HeaderAddr =                                         \
-     &writable_checksum_hash[checksum & (WRITABLE_HASH_SIZE - 1)];            \
-    /* Where is the current header? */                                        \
-    struct ReuseHeader* Header = *HeaderAddr;                                 \
-    while (Header != NULL)                                                    \
+    /* Probe the reuse index until a matching header or a free slot. */       \
+    uint32_t Slot = (uint32_t) hash & (WRITABLE_HASH_SIZE - 1);               \
+    struct ReuseHeader* Header;                                               \
+    while ((Header = writable_reuse_header[Slot]) != NULL)                    \
     {                                                                         \
-      if (Header->PC == block_start_pc                                        \
+      if (writable_reuse_tag[Slot] == tag                                     \
+       && Header->PC == reuse_pc                                              \
        && Header->GBACodeSize == (block_end_pc - block_start_pc)              \
        && memcmp(opcodes.type, Header + 1, Header->GBACodeSize) == 0)         \
       {                                                                       \
         /* The code has been determined to be identical. Yay! */              \
         StatsAddWritableReuse((block_end_pc - block_start_pc) /               \
          type##_instruction_width);                                           \
-        trace_reuse();                                                        \
+        trace_reuse(type);                                                    \
                                                                               \
         uint8_t* NativeCode = (uint8_t *) (Header + 1) + Header->GBACodeSize; \
         if ((((unsigned int) NativeCode) & (CODE_ALIGN_SIZE - 1)) != 0)       \
@@ -3211,8 +3399,7 @@ uint8_t* translate_block_##type(uint32_t pc)                                  \
         return NativeCode;                                                    \
       }                                                                       \
                                                                               \
-      HeaderAddr = &Header->Next;                                             \
-      Header = *HeaderAddr;                                                   \
+      Slot = (Slot + 1) & (WRITABLE_HASH_SIZE - 1);                           \
     }                                                                         \
                                                                               \
     /* If we get here, we could not reuse code. */                            \
@@ -3224,10 +3411,11 @@ uint8_t* translate_block_##type(uint32_t pc)                                  \
                                                                               \
     if (translation_ptr + sizeof(struct ReuseHeader)                          \
      + (block_end_pc - block_start_pc) + Alignment                            \
-     > translation_cache_limit)                                               \
+     > translation_cache_limit                                                \
+     || writable_reuse_count >= WRITABLE_HASH_LIMIT)                          \
     {                                                                         \
-      /* We ran out of space for what would come before the native code.      \
-       * Get out. */                                                          \
+      /* We ran out of space for what would come before the native code,      \
+       * or the reuse index is as full as we let it get. Get out. */          \
       translation_flush_count++;                                              \
                                                                               \
       flush_translation_cache(TRANSLATION_REGION_WRITABLE,                    \
@@ -3240,12 +3428,13 @@ uint8_t* translate_block_##type(uint32_t pc)                                  \
      type##_instruction_width);                                               \
     trace_recompilation(type);                                                \
                                                                               \
-    /* Fill the reuse header and link it to the linked list at HeaderAddr. */ \
+    /* Fill the reuse header and enter it into the free slot at Slot. */      \
     Header = (struct ReuseHeader*) translation_ptr;                           \
-    *HeaderAddr = Header;                                                     \
+    writable_reuse_header[Slot] = Header;                                     \
+    writable_reuse_tag[Slot] = tag;                                           \
+    writable_reuse_count++;                                                   \
                                                                               \
-    Header->PC = block_start_pc;                                              \
-    Header->Next = NULL;                                                      \
+    Header->PC = reuse_pc;                                                    \
     Header->GBACodeSize = block_end_pc - block_start_pc;                      \
                                                                               \
     translation_ptr += sizeof(struct ReuseHeader);                            \
@@ -3292,10 +3481,12 @@ uint8_t* translate_block_##type(uint32_t pc)                                  \
     }                                                                         \
                                                                               \
     /* If the next instruction is a block entry point update the              \
-       cycle counter and update */                                            \
+       cycle counter and update. It can be reached with the flags in any      \
+       form. */                                                               \
     if(block_data.type[block_data_position].update_cycles)                    \
     {                                                                         \
       generate_cycle_update();                                                \
+      flag_cache_state = FLAGS_UNKNOWN;                                       \
     }                                                                         \
   }                                                                           \
                                                                               \
@@ -3371,8 +3562,7 @@ uint8_t* translate_block_##type(uint32_t pc)                                  \
   return update_trampoline;                                                   \
 }                                                                             \
 
-static uint16_t block_checksum_arm(uint32_t block_data_count);
-static uint16_t block_checksum_thumb(uint32_t block_data_count);
+static uint64_t block_hash(uint32_t reuse_pc, uint32_t size);
 
 static void update_metadata_area_start(uint32_t pc);
 static void update_metadata_area_end(uint32_t pc);
@@ -3380,35 +3570,50 @@ static void update_metadata_area_end(uint32_t pc);
 translate_block_builder(arm)
 translate_block_builder(thumb)
 
-static uint16_t block_checksum_arm(uint32_t opcode_count)
+#define BLOCK_HASH_PRIME64_1 UINT64_C(0x9E3779B185EBCA87)
+#define BLOCK_HASH_PRIME64_2 UINT64_C(0xC2B2AE3D27D4EB4F)
+#define BLOCK_HASH_PRIME64_3 UINT64_C(0x165667B19E3779F9)
+#define BLOCK_HASH_PRIME64_4 UINT64_C(0x85EBCA77C2B2AE63)
+#define BLOCK_HASH_PRIME64_5 UINT64_C(0x27D4EB2F165667C5)
+
+#define block_hash_rotl64(value, shift)                                       \
+  (((value) << (shift)) | ((value) >> (64 - (shift))))                        \
+
+/*
+ * Hashes the GBA code gathered into 'opcodes' by scan_block, using the
+ * short-input path of XXH64 with the block's reuse PC as the seed. The size
+ * is mixed in as well, so blocks that are prefixes of each other differ.
+ * Input:
+ *   reuse_pc: The GBA PC of the start of the block, with bit 0 set for Thumb
+ *   code so that ARM and Thumb blocks never share a hash.
+ *   size: The size of the block's GBA code, in bytes (a multiple of 2).
+ */
+static uint64_t block_hash(uint32_t reuse_pc, uint32_t size)
 {
-	// Init: Checksum = NOT Opcodes[0]
-	// assert opcode_count > 0;
-	uint32_t result = ~opcodes.arm[0], i;
-	for (i = 1; i < opcode_count; i++)
+	const uint8_t* data = (const uint8_t*) &opcodes;
+	uint64_t result = reuse_pc + BLOCK_HASH_PRIME64_5 + size;
+	uint32_t word;
+
+	for (; size >= 4; data += 4, size -= 4)
 	{
-		// Step: Checksum = Checksum XOR (Opcodes[N] SHR (N AND 7))
-		// for fewer collisions if instructions are similar at different places
-		result ^= opcodes.arm[i] >> (i & 7);
+		memcpy(&word, data, 4);
+		result ^= (uint64_t) word * BLOCK_HASH_PRIME64_1;
+		result = block_hash_rotl64(result, 23) * BLOCK_HASH_PRIME64_2
+			+ BLOCK_HASH_PRIME64_3;
 	}
-	// Final: Map into bits 15..1, clear bit 0 to indicate ARM
-	return (uint16_t) (((result >> 16) ^ result) & 0xFFFE);
-}
-
-static uint16_t block_checksum_thumb(uint32_t opcode_count)
-{
-	// Init: Checksum = NOT Opcodes[0]
-	// assert opcode_count > 0;
-	uint16_t result = ~opcodes.thumb[0];
-	uint32_t i;
-	for (i = 1; i < opcode_count; i++)
+	for (; size > 0; data++, size--)
 	{
-		// Step: Checksum = Checksum XOR (Opcodes[N] SHR (N AND 7))
-		// for fewer collisions if instructions are similar at different places
-		result ^= opcodes.thumb[i] >> (i & 7);
+		result ^= (uint64_t) *data * BLOCK_HASH_PRIME64_5;
+		result = block_hash_rotl64(result, 11) * BLOCK_HASH_PRIME64_1;
 	}
-	// Final: Set bit 0 to indicate Thumb
-	return result | 0x0001;
+
+	// Final: Avalanche, so that the low bits can index the reuse index
+	result ^= result >> 33;
+	result *= BLOCK_HASH_PRIME64_2;
+	result ^= result >> 29;
+	result *= BLOCK_HASH_PRIME64_3;
+	result ^= result >> 32;
+	return result;
 }
 
 static void update_metadata_area_start(uint32_t pc)
@@ -3453,8 +3658,12 @@ static void update_metadata_area_end(uint32_t pc)
   }
 }
 
-static void partial_clear_metadata_arm(uint16_t* metadata, uint16_t* metadata_area_start, uint16_t* metadata_area_end);
-static void partial_clear_metadata_thumb(uint16_t* metadata, uint16_t* metadata_area_start, uint16_t* metadata_area_end);
+static void partial_clear_metadata_arm(uint16_t** pages, uint32_t offset, uint32_t area_size);
+static void partial_clear_metadata_thumb(uint16_t** pages, uint32_t offset, uint32_t area_size);
+
+#define partial_clear_entry(pages, offset)                                    \
+  (pages[(offset) >> METADATA_PAGE_SHIFT]                                     \
+   + ((offset) & (METADATA_PAGE_SIZE - 1)))                                   \
 
 /*
  * Starts a Partial Clear of the Metadata Entry for the Data Word at the given
@@ -3462,71 +3671,63 @@ static void partial_clear_metadata_thumb(uint16_t* metadata, uint16_t* metadata_
  */
 void partial_clear_metadata(uint32_t address)
 {
-  // 1. Determine where the Metadata Entry for this Data Word is.
-  uint16_t *metadata;
+  // 1. Determine where the Metadata Entry for this Data Word is, and prepare
+  // for wrapping in the Metadata Area if there's code at the boundaries of
+  // the Data Area. Entries are addressed by their offset, because adjacent
+  // Metadata Pages need not be adjacent in memory.
+  uint16_t **pages;
+  uint32_t offset, area_size;
 
   switch (address >> 24)
   {
     case 0x02: /* EWRAM */
-      metadata = ewram_metadata + (address & 0x3FFFC);
+      pages = ewram_metadata_pages;
+      offset = address & 0x3FFFC;
+      area_size = 0x40000;
       break;
     case 0x03: /* IWRAM */
-      metadata = iwram_metadata + (address & 0x7FFC);
+      pages = iwram_metadata_pages;
+      offset = address & 0x7FFC;
+      area_size = 0x8000;
       break;
     case 0x06: /* VRAM */
+      pages = vram_metadata_pages;
       if (address & 0x10000)
-        metadata = vram_metadata + (address & 0x17FFC);
+        offset = address & 0x17FFC;
       else
-        metadata = vram_metadata + (address & 0xFFFC);
+        offset = address & 0xFFFC;
+      area_size = 0x18000;
       break;
     default:   /* no metadata */
       return;
   }
 
   // 2. If there was a Metadata Entry, and it's not code, the Partial Flush
-  // is done.
-  if ((metadata[3] & 0x3) == 0)
+  // is done. Entries in metadata_zero_page are never code, so only
+  // populated Metadata Pages are ever written below.
+  uint16_t contents = partial_clear_entry(pages, offset)[3];
+  if ((contents & 0x3) == 0)
     return;
 
   Stats.PartialFlushCount++;
 
-  // 3. Prepare for wrapping in the Metadata Area if there's code at the
-  // boundaries of the Data Area.
-  uint16_t *metadata_area, *metadata_area_end;
-  switch (address >> 24)
-  {
-    case 0x02: /* EWRAM */
-      metadata_area = ewram_metadata;
-      metadata_area_end = ewram_metadata + 0x40000;
-      break;
-    case 0x03: /* IWRAM */
-      metadata_area = iwram_metadata;
-      metadata_area_end = iwram_metadata + 0x8000;
-      break;
-    case 0x06: /* VRAM */
-      metadata_area = vram_metadata;
-      metadata_area_end = vram_metadata + 0x18000;
-      break;
-    default:
-      return;
-  }
-
-  uint16_t contents = metadata[3];
   if (contents & 0x1)
-    partial_clear_metadata_thumb(metadata, metadata_area, metadata_area_end);
+    partial_clear_metadata_thumb(pages, offset, area_size);
   if (contents & 0x2)
-    partial_clear_metadata_arm(metadata, metadata_area, metadata_area_end);
+    partial_clear_metadata_arm(pages, offset, area_size);
 }
 
-static void partial_clear_metadata_thumb(uint16_t* metadata, uint16_t* metadata_area_start, uint16_t* metadata_area_end)
+static void partial_clear_metadata_thumb(uint16_t** pages, uint32_t offset, uint32_t area_size)
 {
-  uint16_t* metadata_right = metadata; // Save this pointer to go to the right later
-  // 4. Clear tags for code to the left.
+  uint32_t offset_right = offset; // Save this offset to go to the right later
+  uint16_t* metadata;
+  // 3. Clear tags for code to the left.
   while (1)
   {
-    metadata = metadata - 4;
-    if (metadata < metadata_area_start)
-      metadata = metadata_area_end - 4; // Wrap to the end
+    if (offset == 0)
+      offset = area_size; // Wrap to the end
+    offset -= 4;
+    metadata = partial_clear_entry(pages, offset);
     if ((metadata[3] & 0x1) != 0 &&
         (metadata[3] & 0x4) == 0)
     { // code, and NOT an unconditional branch in Thumb
@@ -3537,10 +3738,11 @@ static void partial_clear_metadata_thumb(uint16_t* metadata, uint16_t* metadata_
     else break;
   }
 
-  // 5. Clear tags for code to the right.
-  metadata = metadata_right;
+  // 4. Clear tags for code to the right.
+  offset = offset_right;
   while (1)
   {
+    metadata = partial_clear_entry(pages, offset);
     uint16_t contents = metadata[3];
     if ((contents & 0x1) != 0)
     { // code
@@ -3553,21 +3755,23 @@ static void partial_clear_metadata_thumb(uint16_t* metadata, uint16_t* metadata_
       }
     }
     else break;
-    metadata = metadata + 4;
-    if (metadata == metadata_area_end)
-      metadata = metadata_area_start; // Wrap to the beginning
+    offset += 4;
+    if (offset == area_size)
+      offset = 0; // Wrap to the beginning
   }
 }
 
-static void partial_clear_metadata_arm(uint16_t* metadata, uint16_t* metadata_area_start, uint16_t* metadata_area_end)
+static void partial_clear_metadata_arm(uint16_t** pages, uint32_t offset, uint32_t area_size)
 {
-  uint16_t* metadata_right = metadata; // Save this pointer to go to the right later
-  // 4. Clear tags for code to the left.
+  uint32_t offset_right = offset; // Save this offset to go to the right later
+  uint16_t* metadata;
+  // 3. Clear tags for code to the left.
   while (1)
   {
-    metadata = metadata - 4;
-    if (metadata < metadata_area_start)
-      metadata = metadata_area_end - 4; // Wrap to the end
+    if (offset == 0)
+      offset = area_size; // Wrap to the end
+    offset -= 4;
+    metadata = partial_clear_entry(pages, offset);
     if ((metadata[3] & 0x2) != 0 &&
         (metadata[3] & 0x8) == 0)
     { // code, and NOT an unconditional branch in ARM
@@ -3577,10 +3781,11 @@ static void partial_clear_metadata_arm(uint16_t* metadata, uint16_t* metadata_ar
     else break;
   }
 
-  // 5. Clear tags for code to the right.
-  metadata = metadata_right;
+  // 4. Clear tags for code to the right.
+  offset = offset_right;
   while (1)
   {
+    metadata = partial_clear_entry(pages, offset);
     uint16_t contents = metadata[3];
     if ((contents & 0x2) != 0)
     { // code
@@ -3592,52 +3797,42 @@ static void partial_clear_metadata_arm(uint16_t* metadata, uint16_t* metadata_ar
       }
     }
     else break;
-    metadata = metadata + 4;
-    if (metadata == metadata_area_end)
-      metadata = metadata_area_start; // Wrap to the beginning
+    offset += 4;
+    if (offset == area_size)
+      offset = 0; // Wrap to the beginning
   }
 }
 
-#if defined TRACE || defined TRACE_FLUSHING
-
-static char* METADATA_AREA_NAMES[] = {
-	"BIOS", "EWRAM", "IWRAM", "VRAM", "ROM"
-};
-static char* CODE_CACHE_NAMES[] = {
-	"read-only", "writable"
-};
-
-static char* CLEAR_REASON_NAMES[] = {
-	"Initialising",
-	"Loading a new ROM",
-	"Invalidating native branches",
-	"Code cache full",
-	"Last tag reached",
-	"Loading a saved state"
-};
-static char* FLUSH_REASON_NAMES[] = {
-	"Initialising",
-	"Loading a new ROM",
-	"Invalidating native branches",
-	"Code cache full"
-};
-
-#endif
+/*
+ * Zeroes the Metadata Entries from offset 'start' to offset 'end', exclusive,
+ * in the Metadata Area whose page directory is 'pages'. Metadata Pages that
+ * are still metadata_zero_page are skipped.
+ */
+static void clear_metadata_pages(uint16_t** pages, uint32_t start, uint32_t end)
+{
+  while (start < end)
+  {
+    uint32_t page_end = (start | (METADATA_PAGE_SIZE - 1)) + 1;
+    if (page_end > end)
+      page_end = end;
+    uint16_t* page = pages[start >> METADATA_PAGE_SHIFT];
+    if (page != metadata_zero_page)
+      memset(page + (start & (METADATA_PAGE_SIZE - 1)), 0,
+        (page_end - start) * sizeof(uint16_t));
+    start = page_end;
+  }
+}
 
 void clear_metadata_area(METADATA_AREA_TYPE metadata_area,
   METADATA_CLEAR_REASON_TYPE clear_reason)
 {
-#if defined TRACE || defined TRACE_FLUSHING
-	ReGBA_Trace("Clearing %s metadata: %s",
-		METADATA_AREA_NAMES[metadata_area],
-		CLEAR_REASON_NAMES[clear_reason]);
-#endif
+	trace_event(TRACE_EVENT_METADATA_CLEAR, metadata_area, clear_reason, 0);
 	Stats.MetadataClearCount[metadata_area][clear_reason]++;
 	switch (metadata_area)
 	{
 		case METADATA_AREA_IWRAM:
 			if (clear_reason == CLEAR_REASON_INITIALIZING)
-				memset(iwram_metadata, 0, sizeof(iwram_metadata));
+				clear_metadata_pages(iwram_metadata_pages, 0, 0x8000);
 			else
 			{
 				iwram_block_tag_top = MIN_TAG;
@@ -3649,7 +3844,7 @@ void clear_metadata_area(METADATA_AREA_TYPE metadata_area,
 					if (iwram_code_max & 2)
 						// Catch the last Metadata Entry for a 4-byte-aligned Thumb instruction
 						iwram_code_max += 2;
-					memset(iwram_metadata + iwram_code_min, 0, (iwram_code_max - iwram_code_min) * sizeof(uint16_t));
+					clear_metadata_pages(iwram_metadata_pages, iwram_code_min, iwram_code_max);
 					iwram_code_min = 0xFFFFFFFF;
 					iwram_code_max = 0xFFFFFFFF;
 				}
@@ -3657,7 +3852,7 @@ void clear_metadata_area(METADATA_AREA_TYPE metadata_area,
 			break;
 		case METADATA_AREA_EWRAM:
 			if (clear_reason == CLEAR_REASON_INITIALIZING)
-				memset(ewram_metadata, 0, sizeof(ewram_metadata));
+				clear_metadata_pages(ewram_metadata_pages, 0, 0x40000);
 			else
 			{
 				ewram_block_tag_top = MIN_TAG;
@@ -3669,7 +3864,7 @@ void clear_metadata_area(METADATA_AREA_TYPE metadata_area,
 					if (ewram_code_max & 2)
 						// Catch the last Metadata Entry for a 4-byte-aligned Thumb instruction
 						ewram_code_max += 2;
-					memset(ewram_metadata + ewram_code_min, 0, (ewram_code_max - ewram_code_min) * sizeof(uint16_t));
+					clear_metadata_pages(ewram_metadata_pages, ewram_code_min, ewram_code_max);
 					ewram_code_min = 0xFFFFFFFF;
 					ewram_code_max = 0xFFFFFFFF;
 				}
@@ -3677,13 +3872,13 @@ void clear_metadata_area(METADATA_AREA_TYPE metadata_area,
 			break;
 		case METADATA_AREA_VRAM:
 			if (clear_reason == CLEAR_REASON_INITIALIZING)
-				memset(vram_metadata, 0, sizeof(vram_metadata));
+				clear_metadata_pages(vram_metadata_pages, 0, 0x18000);
 			else
 			{
 				vram_block_tag_top = MIN_TAG;
 
 				// TODO [Opt] Handle the mirroring in this area
-				memset(vram_metadata, 0, sizeof(vram_metadata));
+				clear_metadata_pages(vram_metadata_pages, 0, 0x18000);
 			}
 			break;
 		case METADATA_AREA_ROM:
@@ -3699,11 +3894,10 @@ void clear_metadata_area(METADATA_AREA_TYPE metadata_area,
 void flush_translation_cache(TRANSLATION_REGION_TYPE translation_region,
   CACHE_FLUSH_REASON_TYPE flush_reason)
 {
-#if defined TRACE || defined TRACE_FLUSHING
-	ReGBA_Trace("Flushing %s code cache: %s",
-		CODE_CACHE_NAMES[translation_region],
-		FLUSH_REASON_NAMES[flush_reason]);
-#endif
+	trace_event(TRACE_EVENT_CODE_CACHE_FLUSH, translation_region, flush_reason,
+		translation_region == TRANSLATION_REGION_READONLY
+		? readonly_next_code - readonly_code_cache
+		: writable_next_code - writable_code_cache);
 	Stats.TranslationFlushCount[translation_region][flush_reason]++;
 	switch (translation_region)
 	{
@@ -3736,7 +3930,8 @@ void flush_translation_cache(TRANSLATION_REGION_TYPE translation_region,
 			Stats.TranslationBytesFlushed[translation_region] +=
 				writable_next_code - writable_code_cache;
 			writable_next_code = writable_code_cache;
-			memset(writable_checksum_hash, 0, sizeof(writable_checksum_hash));
+			memset(writable_reuse_header, 0, sizeof(writable_reuse_header));
+			writable_reuse_count = 0;
 			switch (flush_reason)
 			{
 				case FLUSH_REASON_INITIALIZING:
@@ -3762,8 +3957,8 @@ void flush_translation_cache(TRANSLATION_REGION_TYPE translation_region,
 	}
 }
 
-uint8_t* last_readonly = readonly_code_cache;
-uint8_t* last_writable = writable_code_cache;
+uint8_t* last_readonly = NULL;
+uint8_t* last_writable = NULL;
 void dump_translation_cache()
 {
 //  FILE_OPEN(FILE *fp, "fat:/ram_cache.bin", WRITE);
@@ -3790,6 +3985,22 @@ void dump_translation_cache()
   printf("RO:%08X R/W:%08X\n", readonly_next_code - readonly_code_cache, writable_next_code - writable_code_cache);
 }
 
+void init_translater()
+{
+	readonly_code_cache_size = READONLY_CODE_CACHE_SIZE;
+	readonly_code_cache = ReGBA_AllocateCodeCache(TRANSLATION_REGION_READONLY,
+		&readonly_code_cache_size);
+	readonly_next_code = readonly_code_cache;
+
+	writable_code_cache_size = WRITABLE_CODE_CACHE_SIZE;
+	writable_code_cache = ReGBA_AllocateCodeCache(TRANSLATION_REGION_WRITABLE,
+		&writable_code_cache_size);
+	writable_next_code = writable_code_cache;
+
+	last_readonly = readonly_code_cache;
+	last_writable = writable_code_cache;
+}
+
 void init_cpu(uint32_t BootFromBIOS)
 {
   uint32_t i;
@@ -91,6 +91,9 @@ void raise_interrupt(IRQ_TYPE irq_raised)
   // and it must be on in the flags.
   io_registers[REG_IF] |= irq_raised;
 
+  trace_event(TRACE_EVENT_IRQ, irq_raised, io_registers[REG_IE],
+   io_registers[REG_IF]);
+
   if((io_registers[REG_IME] & 0x01) && (io_registers[REG_IE] & io_registers[REG_IF]) && ((reg[REG_CPSR] & 0x80) == 0))
   {
     bios_read_protect = 0xe55ec002;
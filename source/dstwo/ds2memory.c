@@ -69,6 +69,27 @@ size_t ReGBA_AllocateOnDemandBuffer(void** Buffer)
 	return Size;
 }
 
+/* The DSTwo has no virtual memory to speak of, so the code caches are
+ * statically allocated at the sizes given in port.h. */
+FULLY_UNINITIALIZED(static uint8_t ReadonlyCodeCache[READONLY_CODE_CACHE_SIZE])
+  __attribute__((aligned(32)));
+FULLY_UNINITIALIZED(static uint8_t WritableCodeCache[WRITABLE_CODE_CACHE_SIZE])
+  __attribute__((aligned(32)));
+
+uint8_t* ReGBA_AllocateCodeCache(TRANSLATION_REGION_TYPE Region, size_t* Size)
+{
+	switch (Region)
+	{
+		case TRANSLATION_REGION_READONLY:
+			*Size = sizeof(ReadonlyCodeCache);
+			return ReadonlyCodeCache;
+		case TRANSLATION_REGION_WRITABLE:
+		default:
+			*Size = sizeof(WritableCodeCache);
+			return WritableCodeCache;
+	}
+}
+
 void ReGBA_DeallocateROM(void* Buffer)
 {
 	free(Buffer);
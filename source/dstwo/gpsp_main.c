@@ -130,6 +130,7 @@ void init_main()
 
   if (!caches_inited)
   {
+    init_translater();
     flush_translation_cache(TRANSLATION_REGION_READONLY, FLUSH_REASON_INITIALIZING);
     flush_translation_cache(TRANSLATION_REGION_WRITABLE, FLUSH_REASON_INITIALIZING);
   }
@@ -203,6 +204,7 @@ uint32_t update_gba()
 {
   // TODO このあたりのログをとる必要があるかも
   IRQ_TYPE irq_raised = IRQ_NONE;
+  StatsEnterFrameTime(FRAME_TIME_OTHER);
 
   do
     {
@@ -332,12 +334,16 @@ uint32_t update_gba()
 #endif
 
           update_gbc_sound(cpu_ticks);
+          movie_frame_end();
 
           vcount = 0; // TODO vcountを0にするタイミングを検討
 
             Stats.EmulatedFrames++;
             Stats.TotalEmulatedFrames++;
             ReGBA_RenderScreen();
+            trace_event(TRACE_EVENT_FRAME_END, Stats.TotalEmulatedFrames,
+              Stats.TotalRenderedFrames, 0);
+            StatsFrameEnd();
         } //(vcount == 228)
 
         // vcountによる割込
@@ -370,6 +376,7 @@ uint32_t update_gba()
     CHECK_TIMER(2);
     CHECK_TIMER(3);
   } while(reg[CPU_HALT_STATE] != CPU_ACTIVE);
+  StatsEnterFrameTime(FRAME_TIME_CPU);
   return execute_cycles;
 }
 
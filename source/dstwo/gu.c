@@ -54,6 +54,7 @@ void ReGBA_RenderScreen(void)
 			BorderUpdateCount--;
 			DS2_FlipMainScreen();
 			DS2_FillScreen(DS_ENGINE_MAIN, COLOR_BLACK);
+			invalidate_scanline_records();
 		} else {
 			DS2_FlipMainScreenPart((DS_SCREEN_HEIGHT - GBA_SCREEN_HEIGHT) / 2,
 				(DS_SCREEN_HEIGHT - GBA_SCREEN_HEIGHT) / 2 + GBA_SCREEN_HEIGHT);
@@ -86,6 +87,7 @@ void clear_gba_screen(uint16_t color)
 	DS2_FlipMainScreen();
 
 	set_gba_screen();
+	invalidate_scanline_records();
 }
 
 void copy_screen(uint16_t *buffer)
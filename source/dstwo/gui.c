@@ -34,6 +34,7 @@
 #include "input.h"
 #include "draw.h"
 #include "cheats.h"
+#include "romindex.h"
 
 // Program arguments.
 char argv[2][PATH_MAX];
@@ -408,6 +409,13 @@ int32_t load_file(const char **exts, char *result_name, char *dir)
 		DIR* cur_dir_handle = NULL;
 		size_t count = 1, capacity = 4 /* initially */;
 		size_t name_count = 3, name_capacity = 256 /* initially */;
+		size_t file_count = 0;
+		struct RomIndex rom_index;
+
+		/* Files are listed from the ROM index of the directory, which
+		 * keeps them sorted between visits. Only directories are added to
+		 * 'entries' while reading the directory. */
+		rom_index_load(&rom_index, cur_dir);
 
 		entries = malloc(capacity * sizeof(struct selector_entry));
 		if (entries == NULL) {
@@ -460,7 +468,7 @@ int32_t load_file(const char **exts, char *result_name, char *dir)
 				show_icon(DS2_GetSubScreen(), &ICON_TITLE, 0, 0);
 				show_icon(DS2_GetSubScreen(), &ICON_TITLEICON, TITLE_ICON_X, TITLE_ICON_Y);
 				char line[384];
-				sprintf(line, "%s (%" PRIu32 ")", msg[MSG_FILE_MENU_LOADING_LIST], count);
+				sprintf(line, "%s (%" PRIu32 ")", msg[MSG_FILE_MENU_LOADING_LIST], count + file_count);
 				PRINT_STRING_BG(DS2_GetSubScreen(), line, COLOR_WHITE, COLOR_TRANS, 49, 10);
 				DS2_UpdateScreenPart(DS_ENGINE_SUB, 10, 10 + BDF_GetFontHeight());
 			}
@@ -489,6 +497,16 @@ int32_t load_file(const char **exts, char *result_name, char *dir)
 				}
 			}
 
+			if (add && !S_ISDIR(st.st_mode)) {
+				if (rom_index_update(&rom_index, name, st.st_size, st.st_mtime) == NULL) {
+					ret = -2;
+					continue_dir = false;
+					goto cleanup;
+				}
+				file_count++;
+				add = false;
+			}
+
 			if (add) {
 				// Ensure we have enough capacity in the selector_entry array.
 				if (count == capacity) {
@@ -547,6 +565,41 @@ int32_t load_file(const char **exts, char *result_name, char *dir)
 
 		/* skip the first entry when sorting, which is always ".." */
 		qsort(&entries[1], count - 1, sizeof(struct selector_entry), name_sort);
+
+		/* Drop the ROMs that are gone from the index, sort in the new ones,
+		 * then merge the files into the sorted directories. */
+		if (!rom_index_finish(&rom_index)) {
+			ret = -2;
+			continue_dir = false;
+			goto cleanup;
+		}
+
+		{
+			struct selector_entry* merged = malloc((count + rom_index.Count) * sizeof(struct selector_entry));
+			size_t dir_index = 1, file_index = 0, merged_count = 1;
+
+			if (merged == NULL) {
+				ret = -2;
+				continue_dir = false;
+				goto cleanup;
+			}
+
+			merged[0] = entries[0];
+			while (dir_index < count || file_index < rom_index.Count) {
+				if (file_index >= rom_index.Count
+				 || (dir_index < count && strcasecmp(entries[dir_index].name, rom_index.Entries[file_index].Name) <= 0)) {
+					merged[merged_count++] = entries[dir_index++];
+				} else {
+					merged[merged_count].name = rom_index.Entries[file_index++].Name;
+					merged[merged_count].is_dir = false;
+					merged_count++;
+				}
+			}
+
+			free(entries);
+			entries = merged;
+			count = merged_count;
+		}
 		DS2_AwaitScreenUpdate(DS_ENGINE_SUB);
 		LowFrequencyCPU();
 
@@ -797,6 +850,7 @@ cleanup:
 
 		free(entries);
 		free(names);
+		rom_index_free(&rom_index);
 	} // end while
 
 	return ret;
@@ -1202,6 +1256,7 @@ bool LoadGameAndItsData(const char* filename)
 	load_game_config_file();
 
 	reorder_latest_file(filename);
+	rom_index_note_played(filename);
 	get_savestate_filelist(filename);
 
 	game_fast_forward = 0;
@@ -2800,20 +2855,18 @@ struct Menu GameMappings = {
 
 extern struct Menu CodeSize;
 extern struct Menu MetadataClears;
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 extern struct Menu CodeReuse;
-#endif
 extern struct Menu ExecutionStats;
 extern struct Menu ROMInformation;
 
 const char* TextDebugging = "Performance and debugging";
 const char* TextCodeSize = "Native code size...";
 const char* TextMetadataClears = "Metadata clear count...";
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 const char* TextCodeReuse = "Code reuse...";
-#endif
 const char* TextExecutionStats = "Execution statistics...";
 const char* TextROMInformation = "ROM information...";
+const char* TextDetailedStatistics = "Detailed statistics";
+const char* TextDeferredRendering = "Render whole frames at once";
 
 static struct Entry Debugging_CodeSize = {
 	ENTRY_SUBMENU(&TextCodeSize, &CodeSize)
@@ -2827,23 +2880,31 @@ static struct Entry Debugging_ExecutionStats = {
 	ENTRY_SUBMENU(&TextExecutionStats, &ExecutionStats)
 };
 
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 static struct Entry Debugging_CodeReuse = {
 	ENTRY_SUBMENU(&TextCodeReuse, &CodeReuse)
 };
-#endif
 
 static struct Entry Debugging_ROMInformation = {
 	ENTRY_SUBMENU(&TextROMInformation, &ROMInformation)
 };
 
+static struct Entry Debugging_DetailedStatistics = {
+	ENTRY_OPTION(&TextDetailedStatistics, &PerformanceCounters, 2),
+	.Choices = { &msg[MSG_GENERAL_OFF], &msg[MSG_GENERAL_ON] }
+};
+
+static struct Entry Debugging_DeferredRendering = {
+	ENTRY_OPTION(&TextDeferredRendering, &deferred_rendering, 2),
+	.Choices = { &msg[MSG_GENERAL_OFF], &msg[MSG_GENERAL_ON] }
+};
+
 struct Menu Debugging = {
 	.Parent = &Tools, .Title = &TextDebugging,
 	.Entries = { &Back, &Debugging_CodeSize, &Debugging_MetadataClears,
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 		&Debugging_CodeReuse,
-#endif
-		&Debugging_ExecutionStats, &Debugging_ROMInformation, NULL },
+		&Debugging_ExecutionStats, &Debugging_DetailedStatistics,
+		&Debugging_DeferredRendering,
+		&Debugging_ROMInformation, NULL },
 	.ActiveEntryIndex = 1  /* Start out after Back */
 };
 
@@ -2927,7 +2988,6 @@ struct Menu MetadataClears = {
 	.DisplayData = MetadataClearsDisplayData
 };
 
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 
 /* --- Main Menu > Tools > Debugging > CODE REUSE --- */
 
@@ -2957,19 +3017,16 @@ struct Menu CodeReuse = {
 	.Entries = { &Back, &CodeReuse_BlocksRecompiled, &CodeReuse_OpcodesRecompiled, &CodeReuse_BlocksReused, &CodeReuse_OpcodesReused, NULL }
 };
 
-#endif
 
 /* --- Main Menu > Tools > Debugging > EXECUTION STATS --- */
 
 const char* TextBufferUnderruns = "Sound buffer underruns";
 const char* TextFramesEmulated = "Frames emulated";
 const char* TextFramesRendered = "Frames rendered";
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 const char* TextARMOpcodes = "ARM opcodes decoded";
 const char* TextThumbOpcodes = "Thumb opcodes decoded";
 const char* TextThumbROMConstants = "Thumb ROM constants";
 const char* TextWrongAddressLines = "Memory accessors patched";
-#endif
 
 static struct Entry ExecutionStats_BufferUnderruns = {
 	ENTRY_DISPLAY(&TextBufferUnderruns, &Stats.SoundBufferUnderrunCount, TYPE_UINT64)
@@ -2983,7 +3040,6 @@ static struct Entry ExecutionStats_FramesRendered = {
 	ENTRY_DISPLAY(&TextFramesRendered, &Stats.TotalRenderedFrames, TYPE_UINT64)
 };
 
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 static struct Entry ExecutionStats_ARMOpcodes = {
 	ENTRY_DISPLAY(&TextARMOpcodes, &Stats.ARMOpcodesDecoded, TYPE_UINT64)
 };
@@ -2999,14 +3055,11 @@ static struct Entry ExecutionStats_ThumbROMConstants = {
 static struct Entry ExecutionStats_WrongAddressLines = {
 	ENTRY_DISPLAY(&TextWrongAddressLines, &Stats.WrongAddressLineCount, TYPE_UINT32)
 };
-#endif
 
 struct Menu ExecutionStats = {
 	.Parent = &Debugging, .Title = &TextExecutionStats,
 	.Entries = { &Back, &ExecutionStats_BufferUnderruns, &ExecutionStats_FramesEmulated, &ExecutionStats_FramesRendered,
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 		&ExecutionStats_ARMOpcodes, &ExecutionStats_ThumbOpcodes, &ExecutionStats_ThumbROMConstants, &ExecutionStats_WrongAddressLines,
-#endif
 		NULL }
 };
 
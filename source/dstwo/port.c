@@ -119,6 +119,11 @@ void ReGBA_DisplayFPS(void)
 	}
 }
 
+uint64_t ReGBA_GetMonotonicTime(void)
+{
+	return (uint64_t) clock() * 1000000000 / CLOCKS_PER_SEC;
+}
+
 void ReGBA_OnGameLoaded(const char* GamePath)
 {
 	char tempPath[PATH_MAX];
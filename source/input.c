@@ -49,6 +49,19 @@ void trigger_key(uint32_t key)
 uint32_t key = 0;
 
 uint32_t rapidfire_flag = 1;
+
+// Gives the GBA the keys for a frame, after a movie has seen them.
+static void set_keys(enum ReGBA_Buttons new_key)
+{
+	new_key = movie_update_keys(new_key);
+
+	if((new_key | key) != key)
+		trigger_key(new_key);
+
+	key = new_key;
+	io_registers[REG_P1] = (~key) & 0x3FF;
+}
+
 // 仿真过程输入
 
 uint32_t update_input()
@@ -57,7 +70,14 @@ uint32_t update_input()
 	
 	if (new_key & REGBA_BUTTON_MENU)
 	{
-		return ReGBA_Menu(REGBA_MENU_ENTRY_REASON_MENU_KEY);
+		uint32_t MenuResult;
+		// The frame is still emulated, so a movie must see it too. The keys
+		// held before the menu was opened stay held.
+		set_keys(key);
+		StatsPauseFrameTime();
+		MenuResult = ReGBA_Menu(REGBA_MENU_ENTRY_REASON_MENU_KEY);
+		StatsResumeFrameTime();
+		return MenuResult;
 	}
 
 	bool RapidFireUsed = false;
@@ -83,11 +103,7 @@ uint32_t update_input()
 		rapidfire_flag = !rapidfire_flag;
 	}
 
-	if((new_key | key) != key)
-		trigger_key(new_key);
-
-	key = new_key;
-	io_registers[REG_P1] = (~key) & 0x3FF;
+	set_keys(new_key);
 
 	return 0;
 }
@@ -53,6 +53,9 @@ enum ReGBA_MenuEntryReason
 	REGBA_MENU_ENTRY_REASON_SUSPENDED,
 };
 
+// These are the last keys pressed, in the GBA bitfield format.
+extern uint32_t key;
+
 uint32_t update_input();
 void input_read_mem_savestate();
 void input_write_mem_savestate();
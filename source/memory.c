@@ -73,7 +73,7 @@ uint32_t save_backup();
 int32_t parse_config_line(char *current_line, char *current_variable, char *current_value);
 int32_t load_game_config(char *gamepak_title, char *gamepak_code, char *gamepak_maker);
 char *skip_spaces(char *line_ptr);
-static int32_t load_gamepak_raw(const char* name);
+static ssize_t load_gamepak_raw(const char* name);
 uint32_t evict_gamepak_page();
 void init_memory_gamepak();
 
@@ -182,19 +182,46 @@ uint8_t  gamepak_backup[0x20000];
 
 #ifndef USE_C_CORE
 /*
- * These are Metadata Areas corresponding to the Data Areas above. They
- * contain information about the native code compilation status of each
- * Data Word in that Data Area. For more information about these, see
- * "doc/partial flushing of RAM code.txt" in your source tree.
+ * These are the page directories of the Metadata Areas corresponding to the
+ * Data Areas above. They contain information about the native code
+ * compilation status of each Data Word in that Data Area. For more
+ * information about these, see "doc/partial flushing of RAM code.txt" in
+ * your source tree.
+ * Each populated Metadata Page takes 8 KiB; at most, that is:
  */
+const uint16_t metadata_zero_page[METADATA_PAGE_SIZE] = { 0 };
 // Internal Working RAM code metadata      64 KiB
-FULLY_UNINITIALIZED(uint16_t iwram_metadata[ 0x8000]);
+uint16_t* iwram_metadata_pages[ 0x8000 >> METADATA_PAGE_SHIFT] =
+  { [0 ... ( 0x8000 >> METADATA_PAGE_SHIFT) - 1] = (uint16_t*) metadata_zero_page };
 // External Working RAM code metadata     512 KiB
-FULLY_UNINITIALIZED(uint16_t ewram_metadata[0x40000]);
+uint16_t* ewram_metadata_pages[0x40000 >> METADATA_PAGE_SHIFT] =
+  { [0 ... (0x40000 >> METADATA_PAGE_SHIFT) - 1] = (uint16_t*) metadata_zero_page };
 // Video RAM code metadata                192 KiB
-FULLY_UNINITIALIZED(uint16_t vram_metadata [0x18000]);
+uint16_t* vram_metadata_pages [0x18000 >> METADATA_PAGE_SHIFT] =
+  { [0 ... (0x18000 >> METADATA_PAGE_SHIFT) - 1] = (uint16_t*) metadata_zero_page };
 // ----------------------------------------------
 // Total                                  768 KiB
+
+/*
+ * Returns the address of the Metadata Entry at the given offset into the
+ * Metadata Area whose page directory is 'pages', after giving its Metadata
+ * Page its own memory if it was still metadata_zero_page.
+ */
+uint16_t* populate_metadata_page(uint16_t** pages, uint32_t offset)
+{
+  uint16_t** page = &pages[offset >> METADATA_PAGE_SHIFT];
+  if (*page == metadata_zero_page)
+  {
+    uint16_t* new_page = calloc(METADATA_PAGE_SIZE, sizeof(uint16_t));
+    if (new_page == NULL)
+    {
+      ReGBA_Trace("E: Out of memory for a Metadata Page");
+      exit(1);
+    }
+    *page = new_page;
+  }
+  return *page + (offset & (METADATA_PAGE_SIZE - 1));
+}
 #endif
 
 uint32_t flash_bank_offset = 0;
@@ -251,6 +278,12 @@ char main_path[MAX_PATH + 1];
 // If OAM is written to:
 uint32_t oam_update = 1;
 
+// If VRAM is written to:
+uint32_t vram_update = 1;
+
+// If palette RAM is written to:
+uint32_t palette_update = 1;
+
 // If GBC audio is written to:
 uint32_t gbc_sound_update = 0;
 
@@ -881,805 +914,483 @@ uint32_t read_eeprom()
    (ADDRESS16(io_registers, 0x204) & 0x8000) | (value & 0x7FFF);              \
 }                                                                             \
 
-#define access_register8_high(address)                                        \
-  value = (value << 8) | (ADDRESS8(io_registers, address))                    \
+// I/O register writes go through io_write_handlers, which holds one handler
+// per 16-bit register. 8-bit writes are merged with the other byte of their
+// register, and 32-bit writes are split in two, except for the few registers
+// whose bytes or words act on their own.
 
-#define access_register8_low(address)                                         \
-  value = ((ADDRESS8(io_registers, address + 1)) << 8) | value                \
+typedef CPU_ALERT_TYPE (*IO_WRITE_HANDLER)(uint32_t address, uint32_t value);
 
-#define access_register16_high(address)                                       \
-  value = (value << 16) | (ADDRESS16(io_registers, address))                  \
-
-#define access_register16_low(address)                                        \
-  value = ((ADDRESS16(io_registers, address + 2)) << 16) | value              \
-
-CPU_ALERT_TYPE write_io_register8(uint32_t address, uint32_t value)
+static CPU_ALERT_TYPE io_write_latch(uint32_t address, uint32_t value)
 {
-  switch(address)
-  {
-    case 0x00:
-      {
-        uint32_t dispcnt = io_registers[REG_DISPCNT];
-
-        if((value & 0x07) != (dispcnt & 0x07))
-          oam_update = 1;
-
-        ADDRESS8(io_registers, 0x00) = value;
-      }
-      break;
-
-    // DISPSTAT (lower byte)
-    case 0x04:
-      ADDRESS8(io_registers, 0x04) =
-       (ADDRESS8(io_registers, 0x04) & 0x07) | (value & ~0x07);
-      break;
-
-    // VCOUNT
-    case 0x06:
-    case 0x07:
-      break;
-
-    // BG2 reference X
-    case 0x28:
-      access_register8_low(0x28);
-      access_register16_low(0x28);
-      affine_reference_x[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x28) = value;
-      break;
-
-    case 0x29:
-      access_register8_high(0x28);
-      access_register16_low(0x28);
-      affine_reference_x[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x28) = value;
-      break;
-
-    case 0x2A:
-      access_register8_low(0x2A);
-      access_register16_high(0x28);
-      affine_reference_x[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x28) = value;
-      break;
-
-    case 0x2B:
-      access_register8_high(0x2A);
-      access_register16_high(0x28);
-      affine_reference_x[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x28) = value;
-      break;
-
-    // BG2 reference Y
-    case 0x2C:
-      access_register8_low(0x2C);
-      access_register16_low(0x2C);
-      affine_reference_y[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x2C) = value;
-      break;
-
-    case 0x2D:
-      access_register8_high(0x2C);
-      access_register16_low(0x2C);
-      affine_reference_y[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x2C) = value;
-      break;
-
-    case 0x2E:
-      access_register8_low(0x2E);
-      access_register16_high(0x2C);
-      affine_reference_y[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x2C) = value;
-      break;
-
-    case 0x2F:
-      access_register8_high(0x2E);
-      access_register16_high(0x2C);
-      affine_reference_y[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x2C) = value;
-      break;
-
-    // BG3 reference X
-    case 0x38:
-      access_register8_low(0x38);
-      access_register16_low(0x38);
-      affine_reference_x[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x38) = value;
-      break;
-
-    case 0x39:
-      access_register8_high(0x38);
-      access_register16_low(0x38);
-      affine_reference_x[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x38) = value;
-      break;
-
-    case 0x3A:
-      access_register8_low(0x3A);
-      access_register16_high(0x38);
-      affine_reference_x[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x38) = value;
-      break;
-
-    case 0x3B:
-      access_register8_high(0x3A);
-      access_register16_high(0x38);
-      affine_reference_x[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x38) = value;
-      break;
-
-    // BG3 reference Y
-    case 0x3C:
-      access_register8_low(0x3C);
-      access_register16_low(0x3C);
-      affine_reference_y[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x3C) = value;
-      break;
-
-    case 0x3D:
-      access_register8_high(0x3C);
-      access_register16_low(0x3C);
-      affine_reference_y[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x3C) = value;
-      break;
-
-    case 0x3E:
-      access_register8_low(0x3E);
-      access_register16_high(0x3C);
-      affine_reference_y[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x3C) = value;
-      break;
-
-    case 0x3F:
-      access_register8_high(0x3E);
-      access_register16_high(0x3C);
-      affine_reference_y[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x3C) = value;
-      break;
-
-    // Sound 1 control sweep
-    case 0x60:
-      access_register8_low(0x60);
-      GBC_SOUND_TONE_CONTROL_SWEEP();
-      break;
-
-    case 0x61:
-      access_register8_low(0x60);
-      GBC_SOUND_TONE_CONTROL_SWEEP();
-      break;
-
-    // Sound 1 control duty/length/envelope
-    case 0x62:
-      access_register8_low(0x62);
-      GBC_SOUND_TONE_CONTROL_LOW(0, 0x62);
-      break;
-
-    case 0x63:
-      access_register8_high(0x62);
-      GBC_SOUND_TONE_CONTROL_LOW(0, 0x62);
-      break;
-
-    // Sound 1 control frequency
-    case 0x64:
-      access_register8_low(0x64);
-      GBC_SOUND_TONE_CONTROL_HIGH(0, 0x64);
-      break;
-
-    case 0x65:
-      access_register8_high(0x64);
-      GBC_SOUND_TONE_CONTROL_HIGH(0, 0x64);
-      break;
-
-    // Sound 2 control duty/length/envelope
-    case 0x68:
-      access_register8_low(0x68);
-      GBC_SOUND_TONE_CONTROL_LOW(1, 0x68);
-      break;
-
-    case 0x69:
-      access_register8_high(0x68);
-      GBC_SOUND_TONE_CONTROL_LOW(1, 0x68);
-      break;
-
-    // Sound 2 control frequency
-    case 0x6C:
-      access_register8_low(0x6C);
-      GBC_SOUND_TONE_CONTROL_HIGH(1, 0x6C);
-      break;
-
-    case 0x6D:
-      access_register8_high(0x6C);
-      GBC_SOUND_TONE_CONTROL_HIGH(1, 0x6C);
-      break;
-
-    // Sound 3 control wave
-    case 0x70:
-      access_register8_low(0x70);
-      GBC_SOUND_WAVE_CONTROL();
-      break;
-
-    case 0x71:
-      access_register8_high(0x70);
-      GBC_SOUND_WAVE_CONTROL();
-      break;
+  ADDRESS16(io_registers, address) = value;
+  return CPU_ALERT_NONE;
+}
 
-    // Sound 3 control length/volume
-    case 0x72:
-      access_register8_low(0x72);
-      GBC_SOUND_TONE_CONTROL_LOW_WAVE();
-      break;
+static CPU_ALERT_TYPE io_write_read_only(uint32_t address, uint32_t value)
+{
+  return CPU_ALERT_NONE;
+}
 
-    case 0x73:
-      access_register8_high(0x72);
-      GBC_SOUND_TONE_CONTROL_LOW_WAVE();
-      break;
+// DISPCNT
+static CPU_ALERT_TYPE io_write_dispcnt(uint32_t address, uint32_t value)
+{
+  uint32_t dispcnt = io_registers[REG_DISPCNT];
+  if((value & 0x07) != (dispcnt & 0x07))
+    oam_update = 1;
 
-    // Sound 3 control frequency
-    case 0x74:
-      access_register8_low(0x74);
-      GBC_SOUND_TONE_CONTROL_HIGH_WAVE();
-      break;
+  ADDRESS16(io_registers, 0x00) = value;
+  return CPU_ALERT_NONE;
+}
 
-    case 0x75:
-      access_register8_high(0x74);
-      GBC_SOUND_TONE_CONTROL_HIGH_WAVE();
-      break;
+// DISPSTAT
+static CPU_ALERT_TYPE io_write_dispstat(uint32_t address, uint32_t value)
+{
+  ADDRESS16(io_registers, 0x04) =
+   (ADDRESS16(io_registers, 0x04) & 0x07) | (value & ~0x07);
+  return CPU_ALERT_NONE;
+}
 
-    // Sound 4 control length/envelope
-    case 0x78:
-      access_register8_low(0x78);
-      GBC_SOUND_TONE_CONTROL_LOW(3, 0x78);
-      break;
+// BG2/BG3 reference X/Y
+#define io_write_affine_reference(name, coordinate, bg, base)                 \
+static CPU_ALERT_TYPE io_write_##name(uint32_t address, uint32_t value)       \
+{                                                                             \
+  ADDRESS16(io_registers, address) = value;                                   \
+  affine_reference_##coordinate[bg] =                                         \
+   (int32_t)(ADDRESS32(io_registers, base) << 4) >> 4;                        \
+  return CPU_ALERT_NONE;                                                      \
+}                                                                             \
 
-    case 0x79:
-      access_register8_high(0x78);
-      GBC_SOUND_TONE_CONTROL_LOW(3, 0x78);
-      break;
+io_write_affine_reference(bg2x, x, 0, 0x28)
+io_write_affine_reference(bg2y, y, 0, 0x2C)
+io_write_affine_reference(bg3x, x, 1, 0x38)
+io_write_affine_reference(bg3y, y, 1, 0x3C)
 
-    // Sound 4 control frequency
-    case 0x7C:
-      access_register8_low(0x7C);
-      GBC_SOUND_NOISE_CONTROL();
-      break;
+// Sound 1 control sweep
+static CPU_ALERT_TYPE io_write_sound1cnt_l(uint32_t address, uint32_t value)
+{
+  GBC_SOUND_TONE_CONTROL_SWEEP();
+  return CPU_ALERT_NONE;
+}
 
-    case 0x7D:
-      access_register8_high(0x7C);
-      GBC_SOUND_NOISE_CONTROL();
-      break;
+// Sound 1 control duty/length/envelope
+static CPU_ALERT_TYPE io_write_sound1cnt_h(uint32_t address, uint32_t value)
+{
+  GBC_SOUND_TONE_CONTROL_LOW(0, 0x62);
+  return CPU_ALERT_NONE;
+}
 
-    // Sound control L
-    case 0x80:
-      access_register8_low(0x80);
-      GBC_TRIGGER_SOUND();
-      break;
+// Sound 1 control frequency
+static CPU_ALERT_TYPE io_write_sound1cnt_x(uint32_t address, uint32_t value)
+{
+  GBC_SOUND_TONE_CONTROL_HIGH(0, 0x64);
+  return CPU_ALERT_NONE;
+}
 
-    case 0x81:
-      access_register8_high(0x80);
-      GBC_TRIGGER_SOUND();
-      break;
+// Sound 2 control duty/length/envelope
+static CPU_ALERT_TYPE io_write_sound2cnt_l(uint32_t address, uint32_t value)
+{
+  GBC_SOUND_TONE_CONTROL_LOW(1, 0x68);
+  return CPU_ALERT_NONE;
+}
 
-    // Sound control H
-    case 0x82:
-      access_register8_low(0x82);
-      TRIGGER_SOUND();
-      break;
+// Sound 2 control frequency
+static CPU_ALERT_TYPE io_write_sound2cnt_h(uint32_t address, uint32_t value)
+{
+  GBC_SOUND_TONE_CONTROL_HIGH(1, 0x6C);
+  return CPU_ALERT_NONE;
+}
 
-    case 0x83:
-      access_register8_high(0x82);
-      TRIGGER_SOUND();
-      break;
+// Sound 3 control wave
+static CPU_ALERT_TYPE io_write_sound3cnt_l(uint32_t address, uint32_t value)
+{
+  GBC_SOUND_WAVE_CONTROL();
+  return CPU_ALERT_NONE;
+}
 
-    // Sound control X
-    case 0x84:
-      SOUND_ON();
-      break;
+// Sound 3 control length/volume
+static CPU_ALERT_TYPE io_write_sound3cnt_h(uint32_t address, uint32_t value)
+{
+  GBC_SOUND_TONE_CONTROL_LOW_WAVE();
+  return CPU_ALERT_NONE;
+}
 
-    // Sound wave RAM
-    case 0x90 ... 0x9F:
-      gbc_sound_wave_update = 1;
-      ADDRESS8(io_registers, address) = value;
-      break;
+// Sound 3 control frequency
+static CPU_ALERT_TYPE io_write_sound3cnt_x(uint32_t address, uint32_t value)
+{
+  GBC_SOUND_TONE_CONTROL_HIGH_WAVE();
+  return CPU_ALERT_NONE;
+}
 
-    // Sound FIFO A
-    case 0xA0 ... 0xA3:
-      ADDRESS8(io_registers, address) = value;
-      sound_timer_queue32(0);
-      break;
+// Sound 4 control length/envelope
+static CPU_ALERT_TYPE io_write_sound4cnt_l(uint32_t address, uint32_t value)
+{
+  GBC_SOUND_TONE_CONTROL_LOW(3, 0x78);
+  return CPU_ALERT_NONE;
+}
 
-    // Sound FIFO B
-    case 0xA4 ... 0xA7:
-      ADDRESS8(io_registers, address) = value;
-      sound_timer_queue32(1);
-      break;
+// Sound 4 control frequency
+static CPU_ALERT_TYPE io_write_sound4cnt_h(uint32_t address, uint32_t value)
+{
+  GBC_SOUND_NOISE_CONTROL();
+  return CPU_ALERT_NONE;
+}
 
-    // DMA control (trigger byte)
-    case 0xBB:  // DMA channel 0
-    case 0xC7:  // DMA channel 1
-    case 0xD3:  // DMA channel 2
-    case 0xDF:  // DMA channel 3
-      access_register8_high(address - 1);
-      trigger_dma((address - 0xBB) / 12);
-      break;
+// Sound control L
+static CPU_ALERT_TYPE io_write_soundcnt_l(uint32_t address, uint32_t value)
+{
+  GBC_TRIGGER_SOUND();
+  return CPU_ALERT_NONE;
+}
 
-    // Timer counts
-    case 0x100:
-      access_register8_low(0x100);
-      COUNT_TIMER(0);
-      break;
+// Sound control H
+static CPU_ALERT_TYPE io_write_soundcnt_h(uint32_t address, uint32_t value)
+{
+  TRIGGER_SOUND();
+  return CPU_ALERT_NONE;
+}
 
-    case 0x101:
-      access_register8_high(0x100);
-      COUNT_TIMER(0);
-      break;
+// Sound control X
+static CPU_ALERT_TYPE io_write_soundcnt_x(uint32_t address, uint32_t value)
+{
+  SOUND_ON();
+  return CPU_ALERT_NONE;
+}
 
-    case 0x104:
-      access_register8_low(0x104);
-      COUNT_TIMER(1);
-      break;
+// Sound wave RAM
+static CPU_ALERT_TYPE io_write_wave_ram(uint32_t address, uint32_t value)
+{
+  gbc_sound_wave_update = 1;
+  ADDRESS16(io_registers, address) = value;
+  return CPU_ALERT_NONE;
+}
 
-    case 0x105:
-      access_register8_high(0x104);
-      COUNT_TIMER(1);
-      break;
+// Sound FIFO A
+static CPU_ALERT_TYPE io_write_fifo_a(uint32_t address, uint32_t value)
+{
+  ADDRESS16(io_registers, address) = value;
+  sound_timer_queue32(0);
+  return CPU_ALERT_NONE;
+}
 
-    case 0x108:
-      access_register8_low(0x108);
-      COUNT_TIMER(2);
-      break;
+// Sound FIFO B
+static CPU_ALERT_TYPE io_write_fifo_b(uint32_t address, uint32_t value)
+{
+  ADDRESS16(io_registers, address) = value;
+  sound_timer_queue32(1);
+  return CPU_ALERT_NONE;
+}
 
-    case 0x109:
-      access_register8_high(0x108);
-      COUNT_TIMER(2);
-      break;
+// DMA control
+#define io_write_dma_control(dma_number)                                      \
+static CPU_ALERT_TYPE io_write_dma##dma_number##cnt_h(uint32_t address,       \
+ uint32_t value)                                                              \
+{                                                                             \
+  trigger_dma(dma_number);                                                    \
+  return CPU_ALERT_NONE;                                                      \
+}                                                                             \
 
-    case 0x10C:
-      access_register8_low(0x10C);
-      COUNT_TIMER(3);
-      break;
+io_write_dma_control(0)
+io_write_dma_control(1)
+io_write_dma_control(2)
+io_write_dma_control(3)
 
-    case 0x10D:
-      access_register8_high(0x10C);
-      COUNT_TIMER(3);
-      break;
+// Timer counts and control
+#define io_write_timer(timer_number)                                          \
+static CPU_ALERT_TYPE io_write_tm##timer_number##cnt_l(uint32_t address,      \
+ uint32_t value)                                                              \
+{                                                                             \
+  COUNT_TIMER(timer_number);                                                  \
+  return CPU_ALERT_NONE;                                                      \
+}                                                                             \
+                                                                              \
+static CPU_ALERT_TYPE io_write_tm##timer_number##cnt_h(uint32_t address,      \
+ uint32_t value)                                                              \
+{                                                                             \
+  TRIGGER_TIMER(timer_number);                                                \
+  return CPU_ALERT_NONE;                                                      \
+}                                                                             \
 
-    // Timer control (trigger byte)
-    case 0x103:  // Timer 0
-    case 0x107:  // Timer 1
-    case 0x10B:  // Timer 2
-    case 0x10F:  // Timer 3
-      access_register8_high(address - 1);
-      TRIGGER_TIMER((address - 0x103) / 4);
-      break;
+io_write_timer(0)
+io_write_timer(1)
+io_write_timer(2)
+io_write_timer(3)
 
-    case 0x128:
 #ifdef USE_ADHOC
-      if(g_adhoc_link_flag == NO)
-        ADDRESS8(io_registers, 0x128) |= 0x0C;
-#endif
-      break;
+// SIOCNT
+//      Bit   Expl.
+//      0-1   Baud Rate          (0-3: 9600,38400,57600,115200 bps)
+//      2     SI-Terminal        (0=Parent, 1=Child)                  (Read Only)
+//      3     SD-Terminal        (0=Bad connection, 1=All GBAs Ready) (Read Only)
 
-    case 0x129:
-    case 0x134:
-    case 0x135:
-    // P1
-    case 0x130:
-    case 0x131:
-      /* Read only */
-      break;
+//      4-5   Multi-Player ID    (0=Parent, 1-3=1st-3rd child)        (Read Only)
+//      6     Multi-Player Error (0=Normal, 1=Error)                  (Read Only)
+//      7     Start/Busy Bit     (0=Inactive, 1=Start/Busy) (Read Only for Slaves)
 
-      // IE
-      case 0x200:
-        ADDRESS8(io_registers, 0x200) = value;
-        break;
+//      8-11  Not used           (R/W, should be 0)
 
-      case 0x201:
-        ADDRESS8(io_registers, 0x201) = value;
+//      12    Must be "0" for Multi-Player mode
+//      13    Must be "1" for Multi-Player mode
+//      14    IRQ Enable         (0=Disable, 1=Want IRQ upon completion)
+//      15    Not used           (Read only, always 0)
+static CPU_ALERT_TYPE io_write_siocnt(uint32_t address, uint32_t value)
+{
+  if(g_adhoc_link_flag == NO)
+    ADDRESS16(io_registers, 0x128) |= 0x0C;
+  else
+  {
+    switch(get_sio_mode(value, ADDRESS16(io_registers, 0x134)))
+    {
+      case SIO_MULTIPLAYER: // マルチプレイヤーモード
+        if(value & 0x80) // bit7(start bit)が1の時 転送開始命令
+        {
+          if(!g_multi_id)  // 親モードの時 g_multi_id = 0
+          {
+            if(!g_adhoc_transfer_flag) // g_adhoc_transfer_flag == 0 転送中で無いとき
+            {
+              g_multi_mode = MULTI_START; // データの送信
+            } // 転送中の時
+            value |= (g_adhoc_transfer_flag != 0)<<7;
+          }
+        }
+        if(g_multi_id)
+        {
+          value &= 0xf00b;
+          value |= 0x8;
+          value |= g_multi_id << 4;
+          ADDRESS16(io_registers, 0x128) = value;
+          ADDRESS16(io_registers, 0x134) = 7; // 親と子で0x134の設定値を変える
+        }
+        else
+        {
+          value &= 0xf00f;
+          value |= 0xc;
+          value |= g_multi_id << 4;
+          ADDRESS16(io_registers, 0x128) = value;
+          ADDRESS16(io_registers, 0x134) = 3;
+        }
         break;
-
-    // IF
-    case 0x202:
-      ADDRESS8(io_registers, 0x202) &= ~value;
-      break;
-
-    case 0x203:
-      ADDRESS8(io_registers, 0x203) &= ~value;
-      break;
-
-    // WAITCNT
-    case 0x204:
-#ifndef OLD_COUNT
-      access_register8_low(0x204);
-      waitstate_control();
-#endif
-      break;
-
-    case 0x205:
-#ifndef OLD_COUNT
-      access_register8_high(0x204);
-      waitstate_control();
-#endif
-      break;
-
-    // Halt
-    case 0x301:
-      if(value & 0x80)
-        reg[CPU_HALT_STATE] = CPU_STOP;
-      else
-        reg[CPU_HALT_STATE] = CPU_HALT;
-      return CPU_ALERT_HALT;
-
-    default:
-      ADDRESS8(io_registers, address) = value;
-      break;
+    }
   }
 
+  // SIOMLT_SEND also receives the value, as it always has
+  ADDRESS16(io_registers, 0x12A) = value;
   return CPU_ALERT_NONE;
 }
 
-CPU_ALERT_TYPE write_io_register16(uint32_t address, uint32_t value)
+// RCNT
+static CPU_ALERT_TYPE io_write_rcnt(uint32_t address, uint32_t value)
 {
-  switch(address)
+  if(!value) // 0の場合
   {
-    case 0x00:
-    {
-      uint32_t dispcnt = io_registers[REG_DISPCNT];
-      if((value & 0x07) != (dispcnt & 0x07))
-        oam_update = 1;
-
-      ADDRESS16(io_registers, 0x00) = value;
-      break;
-    }
-
-    // DISPSTAT
-    case 0x04:
-      ADDRESS16(io_registers, 0x04) =
-       (ADDRESS16(io_registers, 0x04) & 0x07) | (value & ~0x07);
-      break;
-
-    // VCOUNT
-    case 0x06:
-      break;
-
-    // BG2 reference X
-    case 0x28:
-      access_register16_low(0x28);
-      affine_reference_x[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x28) = value;
-      break;
-
-    case 0x2A:
-      access_register16_high(0x28);
-      affine_reference_x[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x28) = value;
-      break;
-
-    // BG2 reference Y
-    case 0x2C:
-      access_register16_low(0x2C);
-      affine_reference_y[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x2C) = value;
-      break;
-
-    case 0x2E:
-      access_register16_high(0x2C);
-      affine_reference_y[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x2C) = value;
-      break;
-
-    // BG3 reference X
-
-    case 0x38:
-      access_register16_low(0x38);
-      affine_reference_x[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x38) = value;
-      break;
-
-    case 0x3A:
-      access_register16_high(0x38);
-      affine_reference_x[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x38) = value;
-      break;
-
-    // BG3 reference Y
-    case 0x3C:
-      access_register16_low(0x3C);
-      affine_reference_y[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x3C) = value;
-      break;
-
-    case 0x3E:
-      access_register16_high(0x3C);
-      affine_reference_y[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x3C) = value;
-      break;
-
-    // Sound 1 control sweep
-    case 0x60:
-      GBC_SOUND_TONE_CONTROL_SWEEP();
-      break;
-
-    // Sound 1 control duty/length/envelope
-    case 0x62:
-      GBC_SOUND_TONE_CONTROL_LOW(0, 0x62);
-      break;
-
-    // Sound 1 control frequency
-    case 0x64:
-      GBC_SOUND_TONE_CONTROL_HIGH(0, 0x64);
-      break;
-
-    // Sound 2 control duty/length/envelope
-    case 0x68:
-      GBC_SOUND_TONE_CONTROL_LOW(1, 0x68);
-      break;
-
-    // Sound 2 control frequency
-    case 0x6C:
-      GBC_SOUND_TONE_CONTROL_HIGH(1, 0x6C);
-      break;
-
-    // Sound 3 control wave
-    case 0x70:
-      GBC_SOUND_WAVE_CONTROL();
-      break;
-
-    // Sound 3 control length/volume
-    case 0x72:
-      GBC_SOUND_TONE_CONTROL_LOW_WAVE();
-      break;
-
-    // Sound 3 control frequency
-    case 0x74:
-      GBC_SOUND_TONE_CONTROL_HIGH_WAVE();
-      break;
-
-    // Sound 4 control length/envelope
-    case 0x78:
-      GBC_SOUND_TONE_CONTROL_LOW(3, 0x78);
-      break;
-
-    // Sound 4 control frequency
-    case 0x7C:
-      GBC_SOUND_NOISE_CONTROL();
-      break;
-
-    // Sound control L
-    case 0x80:
-      GBC_TRIGGER_SOUND();
-      break;
-
-    // Sound control H
-    case 0x82:
-      TRIGGER_SOUND();
-      break;
-
-    // Sound control X
-    case 0x84:
-      SOUND_ON();
-      break;
-
-    // Sound wave RAM
-    case 0x90 ... 0x9E:
-      gbc_sound_wave_update = 1;
-      ADDRESS16(io_registers, address) = value;
+    ADDRESS16(io_registers, 0x134) = 0;
+    return CPU_ALERT_NONE;
+  }
+  switch(get_sio_mode(ADDRESS16(io_registers, 0x128), value))
+  {
+    case SIO_MULTIPLAYER:
+      value &= 0xc0f0;
+      value |= 3;
+      if(g_multi_id) value |= 4;
+      ADDRESS16(io_registers, 0x134) = value;
+      ADDRESS16(io_registers, 0x128) = ((ADDRESS16(io_registers, 0x128)&0xff8b)|(g_multi_id ? 0xc : 8)|(g_multi_id<<4));
       break;
 
-    // Sound FIFO A
-    case 0xA0:
-    case 0xA2:
-      ADDRESS16(io_registers, address) = value;
-      sound_timer_queue32(0);
+    default:
+      ADDRESS16(io_registers, 0x134) = value;
       break;
+  }
+  return CPU_ALERT_NONE;
+}
+#else
+static CPU_ALERT_TYPE io_write_siocnt(uint32_t address, uint32_t value)
+{
+  ADDRESS16(io_registers, 0x128) |= 0x0C;
+  return CPU_ALERT_NONE;
+}
 
-    // Sound FIFO B
-    case 0xA4:
-    case 0xA6:
-      ADDRESS16(io_registers, address) = value;
-      sound_timer_queue32(1);
-      break;
+#define io_write_rcnt io_write_latch
+#endif
 
-    // DMA control
-    case 0xBA:  // DMA channel 0
-    case 0xC6:  // DMA channel 1
-    case 0xD2:  // DMA channel 2
-    case 0xDE:  // DMA channel 3
-      trigger_dma((address - 0xBA) / 12);
-      break;
+// Interrupt flag
+static CPU_ALERT_TYPE io_write_if(uint32_t address, uint32_t value)
+{
+  ADDRESS16(io_registers, 0x202) &= ~value;
+  return CPU_ALERT_NONE;
+}
 
-    // Timer counts
-    case 0x100:
-    case 0x104:
-    case 0x108:
-    case 0x10C:
-      COUNT_TIMER((address - 0x100) / 4);
-      break;
+// WAITCNT
+static CPU_ALERT_TYPE io_write_waitcnt(uint32_t address, uint32_t value)
+{
+#ifndef OLD_COUNT
+  waitstate_control();
+#endif
+  return CPU_ALERT_NONE;
+}
 
-    // Timer control
-    case 0x102:  // Timer 0
-    case 0x106:  // Timer 1
-    case 0x10A:  // Timer 2
-    case 0x10E:  // Timer 3
-      TRIGGER_TIMER((address - 0x102) / 4);
-      break;
+// Halt
+static CPU_ALERT_TYPE io_write_haltcnt(uint32_t address, uint32_t value)
+{
+  if(value & 0x8000)
+    reg[CPU_HALT_STATE] = CPU_STOP;
+  else
+    reg[CPU_HALT_STATE] = CPU_HALT;
 
-#ifdef USE_ADHOC
-// SIOCNT
-//      Bit   Expl.
-//      0-1   Baud Rate          (0-3: 9600,38400,57600,115200 bps)
-//      2     SI-Terminal        (0=Parent, 1=Child)                  (Read Only)
-//      3     SD-Terminal        (0=Bad connection, 1=All GBAs Ready) (Read Only)
+  return CPU_ALERT_HALT;
+}
 
-//      4-5   Multi-Player ID    (0=Parent, 1-3=1st-3rd child)        (Read Only)
-//      6     Multi-Player Error (0=Normal, 1=Error)                  (Read Only)
-//      7     Start/Busy Bit     (0=Inactive, 1=Start/Busy) (Read Only for Slaves)
+#define io_write_entry(address, handler)                                      \
+  [(address) >> 1] = handler                                                  \
 
-//      8-11  Not used           (R/W, should be 0)
+static const IO_WRITE_HANDLER io_write_handlers[0x400 >> 1] =
+{
+  [0 ... (0x3FE >> 1)] = io_write_latch,
+  io_write_entry(0x000, io_write_dispcnt),
+  io_write_entry(0x004, io_write_dispstat),
+  io_write_entry(0x006, io_write_read_only),  // VCOUNT
+  io_write_entry(0x028, io_write_bg2x),
+  io_write_entry(0x02A, io_write_bg2x),
+  io_write_entry(0x02C, io_write_bg2y),
+  io_write_entry(0x02E, io_write_bg2y),
+  io_write_entry(0x038, io_write_bg3x),
+  io_write_entry(0x03A, io_write_bg3x),
+  io_write_entry(0x03C, io_write_bg3y),
+  io_write_entry(0x03E, io_write_bg3y),
+  io_write_entry(0x060, io_write_sound1cnt_l),
+  io_write_entry(0x062, io_write_sound1cnt_h),
+  io_write_entry(0x064, io_write_sound1cnt_x),
+  io_write_entry(0x068, io_write_sound2cnt_l),
+  io_write_entry(0x06C, io_write_sound2cnt_h),
+  io_write_entry(0x070, io_write_sound3cnt_l),
+  io_write_entry(0x072, io_write_sound3cnt_h),
+  io_write_entry(0x074, io_write_sound3cnt_x),
+  io_write_entry(0x078, io_write_sound4cnt_l),
+  io_write_entry(0x07C, io_write_sound4cnt_h),
+  io_write_entry(0x080, io_write_soundcnt_l),
+  io_write_entry(0x082, io_write_soundcnt_h),
+  io_write_entry(0x084, io_write_soundcnt_x),
+  [(0x090 >> 1) ... (0x09E >> 1)] = io_write_wave_ram,
+  io_write_entry(0x0A0, io_write_fifo_a),
+  io_write_entry(0x0A2, io_write_fifo_a),
+  io_write_entry(0x0A4, io_write_fifo_b),
+  io_write_entry(0x0A6, io_write_fifo_b),
+  io_write_entry(0x0BA, io_write_dma0cnt_h),
+  io_write_entry(0x0C6, io_write_dma1cnt_h),
+  io_write_entry(0x0D2, io_write_dma2cnt_h),
+  io_write_entry(0x0DE, io_write_dma3cnt_h),
+  io_write_entry(0x100, io_write_tm0cnt_l),
+  io_write_entry(0x102, io_write_tm0cnt_h),
+  io_write_entry(0x104, io_write_tm1cnt_l),
+  io_write_entry(0x106, io_write_tm1cnt_h),
+  io_write_entry(0x108, io_write_tm2cnt_l),
+  io_write_entry(0x10A, io_write_tm2cnt_h),
+  io_write_entry(0x10C, io_write_tm3cnt_l),
+  io_write_entry(0x10E, io_write_tm3cnt_h),
+  io_write_entry(0x128, io_write_siocnt),
+  io_write_entry(0x130, io_write_read_only),  // KEYINPUT
+  io_write_entry(0x134, io_write_rcnt),
+  io_write_entry(0x202, io_write_if),
+  io_write_entry(0x204, io_write_waitcnt),
+  io_write_entry(0x300, io_write_haltcnt)
+};
 
-//      12    Must be "0" for Multi-Player mode
-//      13    Must be "1" for Multi-Player mode
-//      14    IRQ Enable         (0=Disable, 1=Want IRQ upon completion)
-//      15    Not used           (Read only, always 0)
-    case 0x128:
-      if(g_adhoc_link_flag == NO)
-        ADDRESS16(io_registers, 0x128) |= 0x0C;
-      else
-      {
-        switch(get_sio_mode(value, ADDRESS16(io_registers, 0x134)))
-        {
-          case SIO_MULTIPLAYER: // マルチプレイヤーモード
-            if(value & 0x80) // bit7(start bit)が1の時 転送開始命令
-            {
-              if(!g_multi_id)  // 親モードの時 g_multi_id = 0
-              {
-                if(!g_adhoc_transfer_flag) // g_adhoc_transfer_flag == 0 転送中で無いとき
-                {
-                  g_multi_mode = MULTI_START; // データの送信
-                } // 転送中の時
-                value |= (g_adhoc_transfer_flag != 0)<<7;
-              }
-            }
-            if(g_multi_id)
-            {
-              value &= 0xf00b;
-              value |= 0x8;
-              value |= g_multi_id << 4;
-              ADDRESS16(io_registers, 0x128) = value;
-              ADDRESS16(io_registers, 0x134) = 7; // 親と子で0x134の設定値を変える
-            }
-            else
-            {
-              value &= 0xf00f;
-              value |= 0xc;
-              value |= g_multi_id << 4;
-              ADDRESS16(io_registers, 0x128) = value;
-              ADDRESS16(io_registers, 0x134) = 3;
-            }
-            break;
-        }
-      }
+// Byte writes are merged with the other half of their register and go to
+// its handler, except for the bytes below, which keep the behaviour they had
+// before the handler table. Merging deliberately changed two things: a write
+// to the low byte of TMxCNT_H starts or stops the timer (before, only a
+// write to its unused high byte did), and a write to the high byte of
+// SOUND1CNT_L is no longer taken for a write to its low byte.
+// tools/iowritecheck.c checks both, and the bytes kept as they were.
+CPU_ALERT_TYPE write_io_register8(uint32_t address, uint32_t value)
+{
+  switch(address)
+  {
+    // Sound FIFOs (each byte queues the whole 32-bit register)
+    case 0xA0 ... 0xA3:
+      ADDRESS8(io_registers, address) = value;
+      sound_timer_queue32(0);
+      return CPU_ALERT_NONE;
 
-    // SIOMLT_SEND
-    case 0x12A:
-      ADDRESS16(io_registers, 0x12A) = value;
-      break;
+    case 0xA4 ... 0xA7:
+      ADDRESS8(io_registers, address) = value;
+      sound_timer_queue32(1);
+      return CPU_ALERT_NONE;
 
-    // RCNT
-    case 0x134:
-      if(!value) // 0の場合
-      {
-        ADDRESS16(io_registers, 0x134) = 0;
-        return CPU_ALERT_NONE;
-      }
-      switch(get_sio_mode(ADDRESS16(io_registers, 0x128), value))
-      {
-        case SIO_MULTIPLAYER:
-          value &= 0xc0f0;
-          value |= 3;
-          if(g_multi_id) value |= 4;
-          ADDRESS16(io_registers, 0x134) = value;
-          ADDRESS16(io_registers, 0x128) = ((ADDRESS16(io_registers, 0x128)&0xff8b)|(g_multi_id ? 0xc : 8)|(g_multi_id<<4));
-          break;
+    // DMA control (the low byte doesn't start a transfer)
+    case 0xBA:
+    case 0xC6:
+    case 0xD2:
+    case 0xDE:
+      ADDRESS8(io_registers, address) = value;
+      return CPU_ALERT_NONE;
 
-        default:
-          ADDRESS16(io_registers, 0x134) = value;
-          break;
-      }
-      break;
-#else
+    // SIOCNT (byte writes don't start a transfer)
     case 0x128:
-      ADDRESS16(io_registers, 0x128) |= 0x0C;
-      break;
+#ifdef USE_ADHOC
+      if(g_adhoc_link_flag == NO)
+        ADDRESS8(io_registers, 0x128) |= 0x0C;
 #endif
+      return CPU_ALERT_NONE;
 
-    // IE
-    case 0x200:
-      ADDRESS16(io_registers, 0x200) = value;
-      break;
+    // SIOCNT high byte, RCNT
+    case 0x129:
+    case 0x134:
+    case 0x135:
+      return CPU_ALERT_NONE;
 
-    // Interrupt flag
+    // IF
     case 0x202:
-      ADDRESS16(io_registers, 0x202) &= ~value;
-      break;
-
-    // WAITCNT
-    case 0x204:
-#ifndef OLD_COUNT
-      waitstate_control();
-#endif
-      break;
+    case 0x203:
+      ADDRESS8(io_registers, address) &= ~value;
+      return CPU_ALERT_NONE;
 
-    // Halt
+    // POSTFLG
     case 0x300:
-      if(value & 0x8000)
-        reg[CPU_HALT_STATE] = CPU_STOP;
-      else
-        reg[CPU_HALT_STATE] = CPU_HALT;
+      ADDRESS8(io_registers, 0x300) = value;
+      return CPU_ALERT_NONE;
 
-      return CPU_ALERT_HALT;
-
-    default:
-      ADDRESS16(io_registers, address) = value;
-      break;
+    // Halt
+    case 0x301:
+      return io_write_haltcnt(0x300, value << 8);
   }
 
-  return CPU_ALERT_NONE;
+  if(address & 0x01)
+    value = (value << 8) | ADDRESS8(io_registers, address - 1);
+  else
+    value = (ADDRESS8(io_registers, address + 1) << 8) | value;
+
+  return io_write_handlers[address >> 1](address & ~0x01, value);
 }
 
+CPU_ALERT_TYPE write_io_register16(uint32_t address, uint32_t value)
+{
+  return io_write_handlers[address >> 1](address, value);
+}
 
 CPU_ALERT_TYPE write_io_register32(uint32_t address, uint32_t value)
 {
   switch(address)
   {
-    // BG2 reference X
-    case 0x28:
-      affine_reference_x[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x28) = value;
-      break;
-
-    // BG2 reference Y
-    case 0x2C:
-      affine_reference_y[0] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x2C) = value;
-      break;
-
-    // BG3 reference X
-    case 0x38:
-      affine_reference_x[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x38) = value;
-      break;
-
-    // BG3 reference Y
-    case 0x3C:
-      affine_reference_y[1] = (int32_t)(value << 4) >> 4;
-      ADDRESS32(io_registers, 0x3C) = value;
-      break;
-
     // Sound FIFO A
     case 0xA0:
       ADDRESS32(io_registers, 0xA0) = value;
       sound_timer_queue32(0);
-      break;
+      return CPU_ALERT_NONE;
 
     // Sound FIFO B
     case 0xA4:
       ADDRESS32(io_registers, 0xA4) = value;
       sound_timer_queue32(1);
-      break;
-
-    default:
-    {
-      CPU_ALERT_TYPE alert_low =
-        write_io_register16(address, value & 0xFFFF);
-
-      CPU_ALERT_TYPE alert_high =
-        write_io_register16(address + 2, value >> 16);
+      return CPU_ALERT_NONE;
+  }
 
-//      if(alert_high)
-//        return alert_high;
+  CPU_ALERT_TYPE alert_low =
+   io_write_handlers[address >> 1](address, value & 0xFFFF);
 
-      return alert_high | alert_low;
-    }
-  }
+  CPU_ALERT_TYPE alert_high =
+   io_write_handlers[(address + 2) >> 1](address + 2, value >> 16);
 
-  return CPU_ALERT_NONE;
+  return alert_high | alert_low;
 }
 
 #define write_palette8(address, value)                                        \
@@ -2136,16 +1847,21 @@ void write_rtc(uint32_t address, uint32_t value)
                                                                               \
     case 0x05:                                                                \
       /* palette RAM */                                                       \
+      prepare_video_memory_write();                                           \
+      palette_update = 1;                                                     \
       write_palette##type(address & 0x3FF, value);                            \
       break;                                                                  \
                                                                               \
     case 0x06:                                                                \
       /* VRAM */                                                              \
+      prepare_video_memory_write();                                           \
+      vram_update = 1;                                                        \
       write_vram##type();                                                     \
       break;                                                                  \
                                                                               \
     case 0x07:                                                                \
       /* OAM RAM */                                                           \
+      prepare_video_memory_write();                                           \
       write_oam_ram##type();                                                  \
       break;                                                                  \
                                                                               \
@@ -2253,9 +1969,14 @@ CPU_ALERT_TYPE write_memory32(uint32_t address, uint32_t value)
 
 char backup_filename[MAX_FILE];
 
+// Set if the backup memory was replaced by load_backup_from_memory since the
+// backup file was loaded, so that it is not written to that file.
+static bool backup_from_memory = false;
+
 uint32_t load_backup()
 {
 	char BackupFilename[MAX_PATH + 1];
+	backup_from_memory = false;
 	if (!ReGBA_GetBackupFilename(BackupFilename, CurrentGamePath))
 	{
 		ReGBA_Trace("W: Failed to get the name of the saved data file for '%s'", CurrentGamePath);
@@ -2317,9 +2038,43 @@ uint32_t load_backup()
   return 0;
 }
 
+// Returns the number of bytes of gamepak_backup used by the current type and
+// size of backup, or 0 if the type is not known yet.
+static uint32_t get_backup_size()
+{
+  switch(backup_type)
+  {
+    case BACKUP_SRAM:
+      if(sram_size == SRAM_SIZE_32KB)
+        return 0x8000;
+      else
+        return 0x10000;
+
+    case BACKUP_FLASH:
+      if(flash_size == FLASH_SIZE_64KB)
+        return 0x10000;
+      else
+        return 0x20000;
+
+    case BACKUP_EEPROM:
+      if(eeprom_size == EEPROM_512_BYTE)
+        return 0x200;
+      else
+        return 0x2000;
+
+    default:
+      return 0;
+  }
+}
+
 uint32_t save_backup()
 {
 	char BackupFilename[MAX_PATH + 1];
+
+	// Backup memory loaded from a movie is not the player's to keep.
+	if (backup_from_memory)
+		return 0;
+
 	if (!ReGBA_GetBackupFilename(BackupFilename, CurrentGamePath))
 	{
 		ReGBA_Trace("W: Failed to get the name of the saved data file for '%s'", CurrentGamePath);
@@ -2335,36 +2090,7 @@ uint32_t save_backup()
 
     if(FILE_CHECK_VALID(backup_file))
     {
-      uint32_t backup_size = 0x8000;
-
-      switch(backup_type)
-      {
-        case BACKUP_SRAM:
-          if(sram_size == SRAM_SIZE_32KB)
-            backup_size = 0x8000;
-          else
-            backup_size = 0x10000;
-          break;
-
-        case BACKUP_FLASH:
-          if(flash_size == FLASH_SIZE_64KB)
-            backup_size = 0x10000;
-          else
-            backup_size = 0x20000;
-          break;
-
-        case BACKUP_EEPROM:
-          if(eeprom_size == EEPROM_512_BYTE)
-            backup_size = 0x200;
-          else
-            backup_size = 0x2000;
-          break;
-
-        default:
-          break;
-      }
-
-      FILE_WRITE(backup_file, gamepak_backup, backup_size);
+      FILE_WRITE(backup_file, gamepak_backup, get_backup_size());
       FILE_CLOSE(backup_file);
 	  ReGBA_ProgressUpdate(1, 1);
 	  ReGBA_ProgressFinalise();
@@ -2375,6 +2101,68 @@ uint32_t save_backup()
   return 0;
 }
 
+/*
+ * The backup memory as a movie stores it: the type of backup, the sizes of
+ * SRAM, flash and EEPROM, then the bytes of the backup in use.
+ */
+struct BackupMemoryHeader {
+	uint32_t Type;
+	uint32_t SRAMSize;
+	uint32_t FlashSize;
+	uint32_t EEPROMSize;
+} __attribute__((packed));
+
+size_t save_backup_to_memory(uint8_t* Buffer)
+{
+	struct BackupMemoryHeader Header;
+	uint32_t Size = get_backup_size();
+
+	Header.Type = backup_type;
+	Header.SRAMSize = sram_size;
+	Header.FlashSize = flash_size;
+	Header.EEPROMSize = eeprom_size;
+	memcpy(Buffer, &Header, sizeof(Header));
+	memcpy(Buffer + sizeof(Header), gamepak_backup, Size);
+	return sizeof(Header) + Size;
+}
+
+bool load_backup_from_memory(const uint8_t* Buffer, size_t Length)
+{
+	struct BackupMemoryHeader Header, Old;
+	uint32_t Size;
+
+	if (Length < sizeof(Header))
+		return false;
+	memcpy(&Header, Buffer, sizeof(Header));
+	if (Header.Type > BACKUP_NONE || Header.SRAMSize > SRAM_SIZE_64KB
+	 || Header.FlashSize > FLASH_SIZE_128KB || Header.EEPROMSize > EEPROM_8_KBYTE)
+		return false;
+
+	Old.Type = backup_type;
+	Old.SRAMSize = sram_size;
+	Old.FlashSize = flash_size;
+	Old.EEPROMSize = eeprom_size;
+	backup_type = Header.Type;
+	sram_size = Header.SRAMSize;
+	flash_size = Header.FlashSize;
+	eeprom_size = Header.EEPROMSize;
+	Size = get_backup_size();
+	if (Length != sizeof(Header) + Size)
+	{
+		backup_type = Old.Type;
+		sram_size = Old.SRAMSize;
+		flash_size = Old.FlashSize;
+		eeprom_size = Old.EEPROMSize;
+		return false;
+	}
+
+	// As in load_backup, memory past the backup in use reads as erased.
+	memset(gamepak_backup, 0xFF, sizeof(gamepak_backup));
+	memcpy(gamepak_backup, Buffer + sizeof(Header), Size);
+	backup_from_memory = true;
+	return true;
+}
+
 void update_backup()
 {
   if(backup_update != (write_backup_delay + 1))
@@ -2624,6 +2412,8 @@ ssize_t load_gamepak(const char* file_path)
 	FILE_TAG_TYPE fd;
 	if (IsGameLoaded) {
 		update_backup_force();
+		// A movie is only valid for the game it was started with.
+		movie_stop();
 		if(FILE_CHECK_VALID(gamepak_file_large))
 		{
 			FILE_CLOSE(gamepak_file_large);
@@ -2827,14 +2617,29 @@ static void dma_adjust_reg_reload(DMA_TRANSFER_TYPE* DMA, uint32_t GBAAddress)
 #define dma_vars_iwram(type)                                                  \
   dma_smc_vars_##type()                                                       \
 
+#define dma_vram_src()                                                        \
+
+#define dma_vram_dest()                                                       \
+  prepare_video_memory_write();                                               \
+  vram_update = 1                                                             \
+
 #define dma_vars_vram(type)                                                   \
   dma_smc_vars_##type();                                                      \
+  dma_vram_##type()                                                           \
+
+#define dma_palette_ram_src()                                                 \
+
+#define dma_palette_ram_dest()                                                \
+  prepare_video_memory_write();                                               \
+  palette_update = 1                                                          \
 
 #define dma_vars_palette_ram(type)                                            \
+  dma_palette_ram_##type()                                                    \
 
 #define dma_oam_ram_src()                                                     \
 
 #define dma_oam_ram_dest()                                                    \
+  prepare_video_memory_write();                                               \
   oam_update = 1                                                              \
 
 #define dma_vars_oam_ram(type)                                                \
@@ -2918,7 +2723,7 @@ static void dma_adjust_reg_reload(DMA_TRANSFER_TYPE* DMA, uint32_t GBAAddress)
   {                                                                           \
     /* Get the Metadata Entry's [3], bits 0-1, to see if there's code at this \
      * location. See "doc/partial flushing of RAM code.txt" for more info. */ \
-    uint16_t smc = iwram_metadata[(type##_ptr & 0x7FFC) | 3] & 0x3;           \
+    uint16_t smc = METADATA_ENTRY(iwram, type##_ptr & 0x7FFC)[3] & 0x3;       \
     if (smc) {                                                                \
       partial_clear_metadata(type##_ptr);                                     \
     }                                                                         \
@@ -2935,9 +2740,9 @@ static void dma_adjust_reg_reload(DMA_TRANSFER_TYPE* DMA, uint32_t GBAAddress)
      * location. See "doc/partial flushing of RAM code.txt" for more info. */ \
     uint16_t smc;                                                             \
     if (type##_ptr & 0x10000)                                                 \
-      smc = vram_metadata[(type##_ptr & 0x17FFC) | 3] & 0x3;                  \
+      smc = METADATA_ENTRY(vram, type##_ptr & 0x17FFC)[3] & 0x3;              \
     else                                                                      \
-      smc = vram_metadata[(type##_ptr & 0xFFFC) | 3] & 0x3;                   \
+      smc = METADATA_ENTRY(vram, type##_ptr & 0xFFFC)[3] & 0x3;               \
     if (smc) {                                                                \
       partial_clear_metadata(type##_ptr);                                     \
     }                                                                         \
@@ -2961,7 +2766,7 @@ static void dma_adjust_reg_reload(DMA_TRANSFER_TYPE* DMA, uint32_t GBAAddress)
   {                                                                           \
     /* Get the Metadata Entry's [3], bits 0-1, to see if there's code at this \
      * location. See "doc/partial flushing of RAM code.txt" for more info. */ \
-    uint16_t smc = ewram_metadata[(type##_ptr & 0x3FFFC) | 3] & 0x3;          \
+    uint16_t smc = METADATA_ENTRY(ewram, type##_ptr & 0x3FFFC)[3] & 0x3;      \
     if (smc) {                                                                \
       partial_clear_metadata(type##_ptr);                                     \
     }                                                                         \
@@ -3487,6 +3292,228 @@ dma_transfer_loop_region_builder(ext, ext, 32)
     dma_transfer_loop(src_op, dest_op, transfer_size, writeback_op);          \
   }                                                                           \
 
+// Bulk transfers between plain memory. Most DMAs copy or fill a block of RAM,
+// VRAM or OAM from RAM, VRAM or ROM with an incrementing destination; for
+// those, the per-unit loops above are replaced by memmove and fill loops
+// over each host-contiguous stretch, and the metadata of code-holding
+// destinations is checked once per stretch, skipping Metadata Pages that
+// have never held code.
+
+// Returns a pointer to the host memory backing a GBA address a DMA can
+// access with plain loads and stores, or NULL if it has side effects or is
+// not mapped. *Contiguous receives the number of bytes that follow in host
+// memory before the GBA address wraps or changes pages.
+static uint8_t* dma_bulk_pointer(uint32_t address, uint32_t is_dest,
+  uint32_t* contiguous)
+{
+	uint32_t offset;
+	switch (address >> 24)
+	{
+		case 0x02:
+			offset = address & 0x3FFFF;
+			*contiguous = 0x40000 - offset;
+			return ewram_data + offset;
+
+		case 0x03:
+			offset = address & 0x7FFF;
+			*contiguous = 0x8000 - offset;
+			return iwram_data + offset;
+
+		case 0x06:
+			if (address & 0x10000)
+			{
+				offset = address & 0x17FFF;
+				*contiguous = 0x18000 - offset;
+			}
+			else
+			{
+				offset = address & 0xFFFF;
+				*contiguous = 0x10000 - offset;
+			}
+			return vram + offset;
+
+		case 0x07:
+			offset = address & 0x3FF;
+			*contiguous = 0x400 - offset;
+			return (uint8_t*) oam_ram + offset;
+
+		case 0x05:
+			// Palette writes also update the converted palette.
+			if (is_dest)
+				return NULL;
+			offset = address & 0x3FF;
+			*contiguous = 0x400 - offset;
+			return (uint8_t*) palette_ram + offset;
+
+		case 0x08 ... 0x0C:
+		{
+			if (is_dest || (address & 0x1FFFFFF) >= gamepak_size)
+				return NULL;
+			uint8_t* block = memory_map_read[address >> 15];
+			if (block == NULL)
+				block = load_gamepak_page((address >> 15) & 0x3FF);
+			offset = address & 0x7FFF;
+			*contiguous = 0x8000 - offset;
+			return block + offset;
+		}
+
+		default:
+			return NULL;
+	}
+}
+
+// Partially flushes the code found in [Offset, Offset + Bytes) of a Data
+// Area, the same way the per-unit DMA writes do for each word.
+static void dma_bulk_smc(uint16_t** pages, uint32_t address, uint32_t offset,
+  uint32_t bytes)
+{
+	uint32_t end = (offset + bytes + 3) & ~3;
+	address &= ~3;
+	offset &= ~3;
+
+	while (offset < end)
+	{
+		uint32_t page_end = (offset | (METADATA_PAGE_SIZE - 1)) + 1;
+		if (page_end > end)
+			page_end = end;
+		uint16_t* page = pages[offset >> METADATA_PAGE_SHIFT];
+		if (page == metadata_zero_page)
+		{
+			address += page_end - offset;
+			offset = page_end;
+			continue;
+		}
+		for (; offset < page_end; offset += 4, address += 4)
+		{
+			if (page[(offset & (METADATA_PAGE_SIZE - 1)) + 3] & 0x3)
+				partial_clear_metadata(address);
+		}
+	}
+}
+
+static void dma_bulk_fill(uint8_t* dest, const uint8_t* src, uint32_t bytes,
+  uint_fast8_t unit)
+{
+	if (unit == 2)
+	{
+		uint16_t value = *(const uint16_t*) src;
+		uint16_t* dest16 = (uint16_t*) dest;
+		for (bytes /= 2; bytes != 0; bytes--)
+			*dest16++ = value;
+	}
+	else
+	{
+		uint32_t value = *(const uint32_t*) src;
+		uint32_t* dest32 = (uint32_t*) dest;
+		for (bytes /= 4; bytes != 0; bytes--)
+			*dest32++ = value;
+	}
+}
+
+// Returns non-zero if the transfer was done in bulk, or zero if the caller
+// must run the per-unit loop instead (in which case nothing has been
+// transferred yet).
+static uint32_t dma_transfer_bulk(DMA_TRANSFER_TYPE* dma, uint32_t src_ptr,
+  uint32_t dest_ptr, uint32_t length, uint_fast8_t unit)
+{
+	uint32_t remaining = length * unit, src_contiguous, dest_contiguous;
+
+	if ((dma->dest_direction != DMA_INCREMENT
+	  && dma->dest_direction != DMA_RELOAD)
+	 || (dma->source_direction != DMA_INCREMENT
+	  && dma->source_direction != DMA_FIXED)
+	 || dma_bulk_pointer(dest_ptr, 1, &dest_contiguous) == NULL
+	 || dma_bulk_pointer(src_ptr, 0, &src_contiguous) == NULL)
+		return 0;
+
+	// A ROM source must not run off the end of the ROM; the per-unit loop
+	// deals with that case.
+	if ((src_ptr >> 24) >= 0x08
+	 && (src_ptr & 0x1FFFFFF) + (dma->source_direction == DMA_FIXED
+	  ? unit : remaining) > gamepak_size)
+		return 0;
+
+	// The destination must stay in the region it starts in, where
+	// dma_bulk_pointer follows its mirrors. A transfer that runs off the end
+	// of IWRAM or OAM into the next region is left to the per-unit loop.
+	if (((dest_ptr + remaining - 1) >> 24) != (dest_ptr >> 24))
+		return 0;
+
+	// Like the per-unit loop, keep reading the mirrors of the region the
+	// source started in, even if the source address leaves it.
+	uint32_t src_mask = (src_ptr >> 24) >= 0x08 ? 0xFFFFFFFF : 0x00FFFFFF;
+	uint32_t src_region = src_ptr & ~src_mask;
+
+	if ((dest_ptr >> 24) >= 0x05 && (dest_ptr >> 24) <= 0x07)
+		prepare_video_memory_write();
+	if ((dest_ptr >> 24) == 0x07)
+		oam_update = 1;
+	else if ((dest_ptr >> 24) == 0x05)
+		palette_update = 1;
+	else if ((dest_ptr >> 24) == 0x06)
+		vram_update = 1;
+
+	while (remaining != 0)
+	{
+		uint8_t* src = dma_bulk_pointer(src_region | (src_ptr & src_mask), 0,
+		  &src_contiguous);
+		uint8_t* dest = dma_bulk_pointer(dest_ptr, 1, &dest_contiguous);
+		uint32_t bytes = remaining;
+		// Both regions were checked above, so this is not expected to
+		// happen; stop rather than write through a null pointer.
+		if (src == NULL || dest == NULL)
+			break;
+		if (bytes > dest_contiguous)
+			bytes = dest_contiguous;
+
+		if (dma->source_direction == DMA_FIXED)
+			dma_bulk_fill(dest, src, bytes, unit);
+		else
+		{
+			if (bytes > src_contiguous)
+				bytes = src_contiguous;
+			if (dest > src && dest < src + bytes)
+			{
+				// The hardware copies one unit at a time, so an overlapping
+				// copy to a higher address repeats the start of the source.
+				uint32_t i;
+				if (unit == 2)
+					for (i = 0; i < bytes; i += 2)
+						*(uint16_t*) (dest + i) = *(uint16_t*) (src + i);
+				else
+					for (i = 0; i < bytes; i += 4)
+						*(uint32_t*) (dest + i) = *(uint32_t*) (src + i);
+			}
+			else
+				memmove(dest, src, bytes);
+			src_ptr += bytes;
+		}
+
+		switch (dest_ptr >> 24)
+		{
+			case 0x02:
+				dma_bulk_smc(ewram_metadata_pages, dest_ptr, dest_ptr & 0x3FFFF, bytes);
+				break;
+			case 0x03:
+				dma_bulk_smc(iwram_metadata_pages, dest_ptr, dest_ptr & 0x7FFF, bytes);
+				break;
+			case 0x06:
+				dma_bulk_smc(vram_metadata_pages, dest_ptr,
+					(dest_ptr & 0x10000) ? (dest_ptr & 0x17FFF) : (dest_ptr & 0xFFFF),
+					bytes);
+				break;
+		}
+
+		dest_ptr += bytes;
+		remaining -= bytes;
+	}
+
+	dma->source_address = src_ptr;
+	if (dma->dest_direction == DMA_INCREMENT)
+		dma->dest_address = dest_ptr;
+	return 1;
+}
+
 CPU_ALERT_TYPE dma_transfer(DMA_TRANSFER_TYPE *dma)
 {
   uint32_t length = dma->length;
@@ -3494,6 +3521,8 @@ CPU_ALERT_TYPE dma_transfer(DMA_TRANSFER_TYPE *dma)
   uint32_t dest_ptr = dma->dest_address;
   CPU_ALERT_TYPE return_value = CPU_ALERT_NONE;
 
+  trace_event(TRACE_EVENT_DMA, dma->dma_channel, src_ptr, dest_ptr);
+
   // Technically this should be done for source and destination, but
   // chances are this is only ever used (probably mistakingly!) for dest.
   // The only game I know of that requires this is Lucky Luke.
@@ -3516,13 +3545,19 @@ CPU_ALERT_TYPE dma_transfer(DMA_TRANSFER_TYPE *dma)
   {
     src_ptr &= ~0x01;
     dest_ptr &= ~0x01;
-    dma_transfer_expand(16);
+    if(!dma_transfer_bulk(dma, src_ptr, dest_ptr, length, 2))
+    {
+      dma_transfer_expand(16);
+    }
   }
   else
   {
     src_ptr &= ~0x03;
     dest_ptr &= ~0x03;
-    dma_transfer_expand(32);
+    if(!dma_transfer_bulk(dma, src_ptr, dest_ptr, length, 4))
+    {
+      dma_transfer_expand(32);
+    }
   }
 
   if((dma->repeat_type == DMA_NO_REPEAT) ||
@@ -3541,6 +3576,64 @@ CPU_ALERT_TYPE dma_transfer(DMA_TRANSFER_TYPE *dma)
   return return_value;
 }
 
+// Refills a Direct Sound FIFO for a sound DMA (channel 1 or 2 with special
+// timing). This is the same 4-word transfer to FIFO A or B that
+// dma_transfer does, but the words go straight from the source into the
+// FIFO instead of through the I/O register write handlers.
+CPU_ALERT_TYPE dma_transfer_sound(DMA_TRANSFER_TYPE *dma)
+{
+  DIRECT_SOUND_STRUCT *ds = direct_sound_channel + dma->direct_sound_channel;
+  uint32_t src_ptr = dma->source_address & ~0x03;
+  uint32_t contiguous;
+  uint8_t *src;
+  uint32_t i;
+
+  if((dma->start_type != DMA_START_SPECIAL) ||
+   ((dma->source_direction != DMA_INCREMENT) &&
+   (dma->source_direction != DMA_FIXED)) ||
+   ((src = dma_bulk_pointer(src_ptr, 0, &contiguous)) == NULL) ||
+   (contiguous < 16))
+  {
+    return dma_transfer(dma);
+  }
+
+  trace_event(TRACE_EVENT_DMA, dma->dma_channel, dma->source_address,
+   dma->dest_address);
+
+  for(i = 0; i < 16; i++)
+  {
+    if(dma->source_direction == DMA_FIXED)
+      ds->fifo[ds->fifo_top] = src[i & 0x03];
+    else
+      ds->fifo[ds->fifo_top] = src[i];
+    ds->fifo_top = (ds->fifo_top + 1) % 32;
+  }
+
+  // Leave the last word in the FIFO register, as the register writes did.
+  ADDRESS32(io_registers, 0xA0 + (dma->direct_sound_channel * 4)) =
+   (dma->source_direction == DMA_FIXED) ? ADDRESS32(src, 0) :
+   ADDRESS32(src, 12);
+
+  if(dma->source_direction == DMA_INCREMENT)
+    dma->source_address = src_ptr + 16;
+  else
+    dma->source_address = src_ptr;
+
+  if(dma->repeat_type == DMA_NO_REPEAT)
+  {
+    dma->start_type = DMA_INACTIVE;
+    ADDRESS16(io_registers, (dma->dma_channel * 12) + 0xBA) &= (~0x8000);
+  }
+
+  if(dma->irq)
+  {
+    raise_interrupt(IRQ_DMA0 << dma->dma_channel);
+    return CPU_ALERT_IRQ;
+  }
+
+  return CPU_ALERT_NONE;
+}
+
 // Be sure to do this after loading ROMs.
 
 #define map_region(type, start, end, mirror_blocks, region)                   \
@@ -3590,9 +3683,7 @@ uint32_t evict_gamepak_page()
 	memory_map_read[(0xA000000 / (32 * 1024)) + physical_index] = NULL;
 	memory_map_read[(0xC000000 / (32 * 1024)) + physical_index] = NULL;
 
-#if TRACE_MEMORY
-	ReGBA_Trace("T: Evicting virtual page %u", page_index);
-#endif
+	trace_event(TRACE_EVENT_GAMEPAK_PAGE_EVICT, page_index, physical_index, 0);
 	
 	return page_index;
 }
@@ -3601,18 +3692,13 @@ uint8_t *load_gamepak_page(uint16_t physical_index)
 {
 	if (memory_map_read[(0x08000000 / (32 * 1024)) + (uint32_t) physical_index] != NULL)
 	{
-#if TRACE_MEMORY
-		ReGBA_Trace("T: Not reloading already loaded Game Pak page %u (%08X..%08X)", (uint32_t) physical_index, 0x08000000 + physical_index * (32 * 1024), 0x08000000 + (uint32_t) physical_index * (32 * 1024) + 0x7FFF);
-#endif
 		return memory_map_read[(0x08000000 / (32 * 1024)) + (uint32_t) physical_index];
 	}
-#if TRACE_MEMORY
-	ReGBA_Trace("T: Loading Game Pak page %u (%08X..%08X)", (uint32_t) physical_index, 0x08000000 + (uint32_t) physical_index * (32 * 1024), 0x08000000 + (uint32_t) physical_index * (32 * 1024) + 0x7FFF);
-#endif
 	if((uint32_t) physical_index >= (gamepak_size >> 15))
 		return gamepak_rom;
 
 	uint16_t page_index = evict_gamepak_page();
+	trace_event(TRACE_EVENT_GAMEPAK_PAGE_LOAD, physical_index, page_index, 0);
 	uint32_t page_offset = (uint32_t) page_index * (32 * 1024);
 	uint8_t *swap_location = gamepak_rom + page_offset;
 
@@ -3721,12 +3807,15 @@ void init_memory()
   map_null(write, 0x8000000, 0xE000000);
   map_null(write, 0xE000000, 0x10000000);
 
+  prepare_video_memory_write();
   memset(io_registers, 0, sizeof(io_registers));
   memset(oam_ram, 0, sizeof(oam_ram));
   memset(palette_ram, 0, sizeof(palette_ram));
   memset(iwram_data, 0, sizeof(iwram_data));
   memset(ewram_data, 0, sizeof(ewram_data));
   memset(vram, 0, sizeof(vram));
+  vram_update = 1;
+  palette_update = 1;
 
   io_registers[REG_DISPCNT] = 0x80;
   io_registers[REG_P1] = 0x3FF;
@@ -3804,8 +3893,6 @@ void savestate_rewind(void)
 
 void loadstate_rewind(void)
 {
-	int i;
-
 	if(rewind_queue_len == 0)  // There's no rewind data
 		return;
 
@@ -3816,7 +3903,22 @@ void loadstate_rewind(void)
 	else
 		rewind_queue_wr_len--;
 
-	g_state_buffer_ptr = SAVESTATE_REWIND_MEM + rewind_queue_wr_len * SAVESTATE_REWIND_LEN;
+	load_state_from_memory(SAVESTATE_REWIND_MEM + rewind_queue_wr_len * SAVESTATE_REWIND_LEN);
+}
+
+size_t save_state_to_memory(uint8_t* Buffer)
+{
+	g_state_buffer_ptr = Buffer;
+	savestate_block(write_mem);
+	return g_state_buffer_ptr - Buffer;
+}
+
+void load_state_from_memory(uint8_t* Buffer)
+{
+	int i;
+
+	prepare_video_memory_write();
+	g_state_buffer_ptr = Buffer;
 	savestate_block(read_mem);
 
 	clear_metadata_area(METADATA_AREA_IWRAM, CLEAR_REASON_LOADING_STATE);
@@ -3824,6 +3926,8 @@ void loadstate_rewind(void)
 	clear_metadata_area(METADATA_AREA_VRAM, CLEAR_REASON_LOADING_STATE);
 
 	oam_update = 1;
+	vram_update = 1;
+	palette_update = 1;
 	gbc_sound_update = 1;
 
 	// Oops, these contain raw pointers
@@ -3883,6 +3987,7 @@ uint32_t load_state(uint32_t SlotNumber)
 
 		g_state_buffer_ptr = savestate_write_buffer + sizeof(struct ReGBA_RTC) + (240 * 160 * sizeof(uint16_t)) + 2;
 
+		prepare_video_memory_write();
 		savestate_block(read_mem);
 
 		// Perform fixups by saved-state version.
@@ -3907,6 +4012,8 @@ uint32_t load_state(uint32_t SlotNumber)
 		clear_metadata_area(METADATA_AREA_VRAM, CLEAR_REASON_LOADING_STATE);
 
 		oam_update = 1;
+		vram_update = 1;
+		palette_update = 1;
 		gbc_sound_update = 1;
 
 		// Oops, these contain raw pointers
@@ -198,6 +198,8 @@ extern uint8_t *gamepak_rom;
 extern uint8_t *gamepak_rom_resume;
 extern uint32_t gamepak_ram_buffer_size;
 extern uint32_t oam_update;
+extern uint32_t vram_update;
+extern uint32_t palette_update;
 extern uint32_t gbc_sound_update;
 extern DMA_TRANSFER_TYPE dma[4];
 extern TIMER_TYPE timer[4];
@@ -227,9 +229,39 @@ extern uint8_t  gamepak_backup[0x20000];
 
 #ifndef USE_C_CORE
 
-extern uint16_t iwram_metadata[ 0x8000];
-extern uint16_t ewram_metadata[0x40000];
-extern uint16_t vram_metadata [0x18000];
+/*
+ * Metadata Areas are split into Metadata Pages, each describing
+ * METADATA_PAGE_SIZE bytes of their Data Area, and reached through a page
+ * directory per Data Area. Pages that have never held translated code point
+ * to metadata_zero_page, which must never be written to, and get their own
+ * memory on first translation from them.
+ */
+#define METADATA_PAGE_SHIFT 12
+#define METADATA_PAGE_SIZE  (1 << METADATA_PAGE_SHIFT)
+
+extern const uint16_t metadata_zero_page[METADATA_PAGE_SIZE];
+
+extern uint16_t* iwram_metadata_pages[ 0x8000 >> METADATA_PAGE_SHIFT];
+extern uint16_t* ewram_metadata_pages[0x40000 >> METADATA_PAGE_SHIFT];
+extern uint16_t* vram_metadata_pages [0x18000 >> METADATA_PAGE_SHIFT];
+
+/*
+ * Returns the address of the Metadata Entry for the Data Word at the given
+ * offset into the Data Area of 'area' (iwram, ewram or vram), for reading.
+ * The offset must be 4-byte-aligned; entries [0] to [3] are then usable.
+ */
+#define METADATA_ENTRY(area, offset)                                          \
+  (area##_metadata_pages[(offset) >> METADATA_PAGE_SHIFT]                     \
+   + ((offset) & (METADATA_PAGE_SIZE - 1)))                                   \
+
+/*
+ * As METADATA_ENTRY, but for writing; gives the Metadata Page its own
+ * memory if it doesn't have any yet.
+ */
+#define METADATA_ENTRY_WRITE(area, offset)                                    \
+  populate_metadata_page(area##_metadata_pages, offset)                       \
+
+extern uint16_t* populate_metadata_page(uint16_t** pages, uint32_t offset);
 #endif
 
 extern uint32_t bios_read_protect;
@@ -274,6 +306,7 @@ extern CPU_ALERT_TYPE write_memory16(uint32_t address, uint16_t value);
 extern CPU_ALERT_TYPE write_memory32(uint32_t address, uint32_t value);
 
 extern CPU_ALERT_TYPE dma_transfer(DMA_TRANSFER_TYPE *dma);
+extern CPU_ALERT_TYPE dma_transfer_sound(DMA_TRANSFER_TYPE *dma);
 extern uint8_t *memory_region(uint32_t address, uint32_t *memory_limit);
 extern int32_t load_bios(const char* name);
 extern ssize_t load_gamepak(const char* file_path);
@@ -291,6 +324,38 @@ extern void init_rewind(void);
 extern void savestate_rewind(void);
 extern void loadstate_rewind(void);
 
+/*
+ * Writes the state of the emulated GBA to Buffer, in the format of the body
+ * of a saved state, and returns the number of bytes written. Buffer must be
+ * at least SAVESTATE_SIZE bytes long.
+ */
+extern size_t save_state_to_memory(uint8_t* Buffer);
+
+/*
+ * Restores the state of the emulated GBA from a buffer filled by
+ * save_state_to_memory.
+ */
+extern void load_state_from_memory(uint8_t* Buffer);
+
+/*
+ * Writes the type and size of the backup memory (SRAM, flash or EEPROM) and
+ * its contents to Buffer, and returns the number of bytes written. Buffer
+ * must be at least BACKUP_MEMORY_SIZE bytes long.
+ */
+extern size_t save_backup_to_memory(uint8_t* Buffer);
+
+/*
+ * Replaces the backup memory with Length bytes written by
+ * save_backup_to_memory. From then on until load_backup is called for the
+ * next game, the backup memory is not written to the backup file.
+ * Returns:
+ *   true on success; false if Buffer does not hold a valid backup, in which
+ *   case nothing is changed.
+ */
+extern bool load_backup_from_memory(const uint8_t* Buffer, size_t Length);
+
+#define BACKUP_MEMORY_SIZE (16 + 0x20000)
+
 extern unsigned int rewind_queue_len;
 
 #endif
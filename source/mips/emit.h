@@ -24,6 +24,9 @@
 
 uint32_t mips_update_gba(uint32_t pc);
 
+// Only to be called from translated code; it only touches $2 and s4-s7
+void mips_materialize_flags();
+
 // Although these are defined as a function, don't call them as
 // such (jump to it instead)
 void mips_indirect_branch_arm(uint32_t address);
@@ -418,6 +421,20 @@ typedef enum
 #define reg_c_cache mips_reg_s6
 #define reg_v_cache mips_reg_s7
 
+// The flags are evaluated lazily. While s4 is 0 or 1, s4-s7 hold N, Z, C
+// and V as 0 or 1. SUBS, RSBS, ADDS, CMP, CMN and NEG instead leave their
+// operands in s5 and s6 and FLAGS_LAZY_SUB or FLAGS_LAZY_ADD in s4, and the
+// flags are only computed from those (by materialize_flags in stub.S) when
+// something needs them as bits. Conditions can often test the operands
+// directly. flag_cache_state is what the translator knows about s4 at the
+// current point in the block: at block entries and branch targets it can be
+// anything, so it's FLAGS_UNKNOWN and s4 is checked at run time.
+
+#define FLAGS_EAGER    0
+#define FLAGS_LAZY_SUB 2
+#define FLAGS_LAZY_ADD 3
+#define FLAGS_UNKNOWN  4
+
 #define reg_r0      mips_reg_v1
 #define reg_r1      mips_reg_a3
 #define reg_r2      mips_reg_t0
@@ -586,6 +603,22 @@ static uint8_t* generate_load_pc_fn(uint8_t* translation_ptr, unsigned int rt, u
   mips_emit_addiu(reg_cycles, reg_cycles, -cycle_count);                      \
   cycle_count = 0                                                             \
 
+// Makes s4-s7 hold the flags as 0 or 1, for code that reads or writes them
+// individually. The check on s4 is only needed if the state is unknown.
+#define generate_materialize_flags()                                          \
+  if(flag_cache_state == FLAGS_UNKNOWN)                                       \
+  {                                                                           \
+    mips_emit_sltiu(reg_temp, reg_n_cache, FLAGS_LAZY_SUB);                   \
+    mips_emit_b(bne, reg_temp, reg_zero, 3);                                  \
+    mips_emit_nop();                                                          \
+    generate_function_call(mips_materialize_flags);                           \
+  }                                                                           \
+  else if(flag_cache_state != FLAGS_EAGER)                                    \
+  {                                                                           \
+    generate_function_call(mips_materialize_flags);                           \
+  }                                                                           \
+  flag_cache_state = FLAGS_EAGER                                              \
+
 #define generate_branch_patch_conditional(dest, offset)                       \
   *((uint16_t *)(dest)) = mips_relative_offset(dest, offset)                  \
 
@@ -1216,69 +1249,208 @@ typedef enum
 } condition_check_type;
 
 
-#define generate_condition_eq()                                               \
-  mips_emit_b_filler(beq, reg_z_cache, reg_zero, backpatch_address);          \
+// Conditions branch past the instruction when they fail. After a
+// subtraction every condition but VS and VC compares the operands directly,
+// and after an addition EQ, NE, CS, CC, MI and PL are still cheap to get from
+// them. Otherwise the flags are materialized first.
+
+#define generate_condition_branch(type, rs, rt)                               \
+  mips_emit_b_filler(type, rs, rt, backpatch_address);                        \
   generate_cycle_update_force()                                               \
 
+#define generate_condition_eq()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    generate_condition_branch(bne, reg_z_cache, reg_c_cache);                 \
+  }                                                                           \
+  else if(flag_cache_state == FLAGS_LAZY_ADD)                                 \
+  {                                                                           \
+    mips_emit_addu(reg_temp, reg_z_cache, reg_c_cache);                       \
+    generate_condition_branch(bne, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    generate_condition_branch(beq, reg_z_cache, reg_zero);                    \
+  }                                                                           \
+
 #define generate_condition_ne()                                               \
-  mips_emit_b_filler(bne, reg_z_cache, reg_zero, backpatch_address);          \
-  generate_cycle_update_force()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    generate_condition_branch(beq, reg_z_cache, reg_c_cache);                 \
+  }                                                                           \
+  else if(flag_cache_state == FLAGS_LAZY_ADD)                                 \
+  {                                                                           \
+    mips_emit_addu(reg_temp, reg_z_cache, reg_c_cache);                       \
+    generate_condition_branch(beq, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    generate_condition_branch(bne, reg_z_cache, reg_zero);                    \
+  }                                                                           \
 
 #define generate_condition_cs()                                               \
-  mips_emit_b_filler(beq, reg_c_cache, reg_zero, backpatch_address);          \
-  generate_cycle_update_force()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    mips_emit_sltu(reg_temp, reg_z_cache, reg_c_cache);                       \
+    generate_condition_branch(bne, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else if(flag_cache_state == FLAGS_LAZY_ADD)                                 \
+  {                                                                           \
+    mips_emit_addu(reg_temp, reg_z_cache, reg_c_cache);                       \
+    mips_emit_sltu(reg_temp, reg_temp, reg_z_cache);                          \
+    generate_condition_branch(beq, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    generate_condition_branch(beq, reg_c_cache, reg_zero);                    \
+  }                                                                           \
 
 #define generate_condition_cc()                                               \
-  mips_emit_b_filler(bne, reg_c_cache, reg_zero, backpatch_address);          \
-  generate_cycle_update_force()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    mips_emit_sltu(reg_temp, reg_z_cache, reg_c_cache);                       \
+    generate_condition_branch(beq, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else if(flag_cache_state == FLAGS_LAZY_ADD)                                 \
+  {                                                                           \
+    mips_emit_addu(reg_temp, reg_z_cache, reg_c_cache);                       \
+    mips_emit_sltu(reg_temp, reg_temp, reg_z_cache);                          \
+    generate_condition_branch(bne, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    generate_condition_branch(bne, reg_c_cache, reg_zero);                    \
+  }                                                                           \
 
 #define generate_condition_mi()                                               \
-  mips_emit_b_filler(beq, reg_n_cache, reg_zero, backpatch_address);          \
-  generate_cycle_update_force()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    mips_emit_subu(reg_temp, reg_z_cache, reg_c_cache);                       \
+    mips_emit_srl(reg_temp, reg_temp, 31);                                    \
+    generate_condition_branch(beq, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else if(flag_cache_state == FLAGS_LAZY_ADD)                                 \
+  {                                                                           \
+    mips_emit_addu(reg_temp, reg_z_cache, reg_c_cache);                       \
+    mips_emit_srl(reg_temp, reg_temp, 31);                                    \
+    generate_condition_branch(beq, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    generate_condition_branch(beq, reg_n_cache, reg_zero);                    \
+  }                                                                           \
 
 #define generate_condition_pl()                                               \
-  mips_emit_b_filler(bne, reg_n_cache, reg_zero, backpatch_address);          \
-  generate_cycle_update_force()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    mips_emit_subu(reg_temp, reg_z_cache, reg_c_cache);                       \
+    mips_emit_srl(reg_temp, reg_temp, 31);                                    \
+    generate_condition_branch(bne, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else if(flag_cache_state == FLAGS_LAZY_ADD)                                 \
+  {                                                                           \
+    mips_emit_addu(reg_temp, reg_z_cache, reg_c_cache);                       \
+    mips_emit_srl(reg_temp, reg_temp, 31);                                    \
+    generate_condition_branch(bne, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    generate_condition_branch(bne, reg_n_cache, reg_zero);                    \
+  }                                                                           \
 
 #define generate_condition_vs()                                               \
-  mips_emit_b_filler(beq, reg_v_cache, reg_zero, backpatch_address);          \
-  generate_cycle_update_force()                                               \
+  generate_materialize_flags();                                               \
+  generate_condition_branch(beq, reg_v_cache, reg_zero)                       \
 
 #define generate_condition_vc()                                               \
-  mips_emit_b_filler(bne, reg_v_cache, reg_zero, backpatch_address);          \
-  generate_cycle_update_force()                                               \
+  generate_materialize_flags();                                               \
+  generate_condition_branch(bne, reg_v_cache, reg_zero)                       \
 
 #define generate_condition_hi()                                               \
-  mips_emit_xori(reg_temp, reg_c_cache, 1);                                   \
-  mips_emit_or(reg_temp, reg_temp, reg_z_cache);                              \
-  mips_emit_b_filler(bne, reg_temp, reg_zero, backpatch_address);             \
-  generate_cycle_update_force()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    mips_emit_sltu(reg_temp, reg_c_cache, reg_z_cache);                       \
+    generate_condition_branch(beq, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    mips_emit_xori(reg_temp, reg_c_cache, 1);                                 \
+    mips_emit_or(reg_temp, reg_temp, reg_z_cache);                            \
+    generate_condition_branch(bne, reg_temp, reg_zero);                       \
+  }                                                                           \
 
 #define generate_condition_ls()                                               \
-  mips_emit_xori(reg_temp, reg_c_cache, 1);                                   \
-  mips_emit_or(reg_temp, reg_temp, reg_z_cache);                              \
-  mips_emit_b_filler(beq, reg_temp, reg_zero, backpatch_address);             \
-  generate_cycle_update_force()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    mips_emit_sltu(reg_temp, reg_c_cache, reg_z_cache);                       \
+    generate_condition_branch(bne, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    mips_emit_xori(reg_temp, reg_c_cache, 1);                                 \
+    mips_emit_or(reg_temp, reg_temp, reg_z_cache);                            \
+    generate_condition_branch(beq, reg_temp, reg_zero);                       \
+  }                                                                           \
 
 #define generate_condition_ge()                                               \
-  mips_emit_b_filler(bne, reg_n_cache, reg_v_cache, backpatch_address);       \
-  generate_cycle_update_force()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    mips_emit_slt(reg_temp, reg_z_cache, reg_c_cache);                        \
+    generate_condition_branch(bne, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    generate_condition_branch(bne, reg_n_cache, reg_v_cache);                 \
+  }                                                                           \
 
 #define generate_condition_lt()                                               \
-  mips_emit_b_filler(beq, reg_n_cache, reg_v_cache, backpatch_address);       \
-  generate_cycle_update_force()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    mips_emit_slt(reg_temp, reg_z_cache, reg_c_cache);                        \
+    generate_condition_branch(beq, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    generate_condition_branch(beq, reg_n_cache, reg_v_cache);                 \
+  }                                                                           \
 
 #define generate_condition_gt()                                               \
-  mips_emit_xor(reg_temp, reg_n_cache, reg_v_cache);                          \
-  mips_emit_or(reg_temp, reg_temp, reg_z_cache);                              \
-  mips_emit_b_filler(bne, reg_temp, reg_zero, backpatch_address);             \
-  generate_cycle_update_force()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    mips_emit_slt(reg_temp, reg_c_cache, reg_z_cache);                        \
+    generate_condition_branch(beq, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    mips_emit_xor(reg_temp, reg_n_cache, reg_v_cache);                        \
+    mips_emit_or(reg_temp, reg_temp, reg_z_cache);                            \
+    generate_condition_branch(bne, reg_temp, reg_zero);                       \
+  }                                                                           \
 
 #define generate_condition_le()                                               \
-  mips_emit_xor(reg_temp, reg_n_cache, reg_v_cache);                          \
-  mips_emit_or(reg_temp, reg_temp, reg_z_cache);                              \
-  mips_emit_b_filler(beq, reg_temp, reg_zero, backpatch_address);             \
-  generate_cycle_update_force()                                               \
+  if(flag_cache_state == FLAGS_LAZY_SUB)                                      \
+  {                                                                           \
+    mips_emit_slt(reg_temp, reg_c_cache, reg_z_cache);                        \
+    generate_condition_branch(bne, reg_temp, reg_zero);                       \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    generate_materialize_flags();                                             \
+    mips_emit_xor(reg_temp, reg_n_cache, reg_v_cache);                        \
+    mips_emit_or(reg_temp, reg_temp, reg_z_cache);                            \
+    generate_condition_branch(beq, reg_temp, reg_zero);                       \
+  }                                                                           \
 
 #define generate_condition()                                                  \
   switch(condition)                                                           \
@@ -1519,6 +1691,18 @@ typedef enum
   }                                                                           \
   generate_op_logic_flags(_rd)                                                \
 
+// SUBS, RSBS, ADDS, CMP, CMN and NEG set the flags lazily. The operands are
+// copied before the destination is written, since it may be one of them.
+
+#define generate_op_lazy_flags(lazy_type, _rn, _rm)                           \
+  if(flag_status & 0x0F)                                                      \
+  {                                                                           \
+    mips_emit_addu(reg_z_cache, _rn, reg_zero);                               \
+    mips_emit_addu(reg_c_cache, _rm, reg_zero);                               \
+    mips_emit_ori(reg_n_cache, reg_zero, lazy_type);                          \
+    flag_cache_state = lazy_type;                                             \
+  }                                                                           \
+
 #define generate_op_ands_reg(_rd, _rn, _rm)                                   \
   mips_emit_and(_rd, _rn, _rm);                                               \
   generate_op_logic_flags(_rd)                                                \
@@ -1537,14 +1721,12 @@ typedef enum
   generate_op_logic_flags(_rd)                                                \
 
 #define generate_op_subs_reg(_rd, _rn, _rm)                                   \
-  generate_op_sub_flags_prologue(_rn, _rm);                                   \
-  mips_emit_subu(_rd, _rn, _rm);                                              \
-  generate_op_sub_flags_epilogue(_rd)                                         \
+  generate_op_lazy_flags(FLAGS_LAZY_SUB, _rn, _rm);                           \
+  mips_emit_subu(_rd, _rn, _rm)                                               \
 
 #define generate_op_rsbs_reg(_rd, _rn, _rm)                                   \
-  generate_op_sub_flags_prologue(_rm, _rn);                                   \
-  mips_emit_subu(_rd, _rm, _rn);                                              \
-  generate_op_sub_flags_epilogue(_rd)                                         \
+  generate_op_lazy_flags(FLAGS_LAZY_SUB, _rm, _rn);                           \
+  mips_emit_subu(_rd, _rm, _rn)                                               \
 
 #define generate_op_sbcs_reg(_rd, _rn, _rm)                                   \
   mips_emit_xori(reg_temp, reg_c_cache, 1);                                   \
@@ -1561,9 +1743,8 @@ typedef enum
   generate_op_sub_flags_epilogue(_rd)                                         \
 
 #define generate_op_adds_reg(_rd, _rn, _rm)                                   \
-  generate_add_flags_prologue(_rn, _rm);                                      \
-  mips_emit_addu(_rd, _rn, _rm);                                              \
-  generate_add_flags_epilogue(_rd)                                            \
+  generate_op_lazy_flags(FLAGS_LAZY_ADD, _rn, _rm);                           \
+  mips_emit_addu(_rd, _rn, _rm)                                               \
 
 #define generate_op_adcs_reg(_rd, _rn, _rm)                                   \
   mips_emit_addu(reg_temp, _rm, reg_c_cache);                                 \
@@ -1588,10 +1769,10 @@ typedef enum
   generate_op_logic_flags(_rd)                                                \
 
 #define generate_op_cmp_reg(_rd, _rn, _rm)                                    \
-  generate_op_subs_reg(reg_temp, _rn, _rm)                                    \
+  generate_op_lazy_flags(FLAGS_LAZY_SUB, _rn, _rm)                            \
 
 #define generate_op_cmn_reg(_rd, _rn, _rm)                                    \
-  generate_op_adds_reg(reg_temp, _rn, _rm)                                    \
+  generate_op_lazy_flags(FLAGS_LAZY_ADD, _rn, _rm)                            \
 
 #define generate_op_tst_reg(_rd, _rn, _rm)                                    \
   generate_op_ands_reg(reg_temp, _rn, _rm)                                    \
@@ -1732,10 +1913,16 @@ typedef enum
 }                                                                             \
 
 #define arm_multiply_long_flags_yes(_rdlo, _rdhi)                             \
-  mips_emit_sltiu(reg_z_cache, _rdlo, 1);                                     \
-  mips_emit_sltiu(reg_a0, _rdhi, 1);                                          \
-  mips_emit_and(reg_z_cache, reg_z_cache, reg_a0);                            \
-  mips_emit_srl(reg_n_cache, _rdhi, 31);                                      \
+  if(check_generate_z_flag)                                                   \
+  {                                                                           \
+    mips_emit_sltiu(reg_z_cache, _rdlo, 1);                                   \
+    mips_emit_sltiu(reg_a0, _rdhi, 1);                                        \
+    mips_emit_and(reg_z_cache, reg_z_cache, reg_a0);                          \
+  }                                                                           \
+  if(check_generate_n_flag)                                                   \
+  {                                                                           \
+    mips_emit_srl(reg_n_cache, _rdhi, 31);                                    \
+  }                                                                           \
 
 #define arm_multiply_long_flags_no(_rdlo, _rdhi)                              \
 
@@ -1757,8 +1944,16 @@ typedef enum
    arm_to_mips_reg[rdhi]);                                                    \
 }                                                                             \
 
+// Reading and writing the CPSR leave the flags materialized.
+
+#define arm_psr_flags_cpsr()                                                  \
+  flag_cache_state = FLAGS_EAGER                                              \
+
+#define arm_psr_flags_spsr()                                                  \
+
 #define arm_psr_read(op_type, psr_reg)                                        \
   generate_function_call(execute_read_##psr_reg);                             \
+  arm_psr_flags_##psr_reg();                                                  \
   generate_store_reg(reg_rv, rd)                                              \
 
 uint32_t execute_store_cpsr_body(uint32_t _cpsr, uint32_t store_mask, uint32_t address)
@@ -1791,7 +1986,8 @@ uint32_t execute_store_cpsr_body(uint32_t _cpsr, uint32_t store_mask, uint32_t a
   arm_psr_load_new_##op_type();                                               \
   generate_load_imm(reg_a1, psr_masks[psr_field]);                            \
   generate_load_pc(reg_a2, (pc + 4));                                         \
-  generate_function_call_swap_delay(execute_store_##psr_reg)                  \
+  generate_function_call_swap_delay(execute_store_##psr_reg);                 \
+  arm_psr_flags_##psr_reg()                                                   \
 
 #define arm_psr(op_type, transfer_type, psr_reg)                              \
 {                                                                             \
@@ -2306,19 +2502,12 @@ uint32_t execute_store_cpsr_body(uint32_t _cpsr, uint32_t store_mask, uint32_t a
   thumb_access_memory_##access_type(mem_type, reg_rd);                        \
 }                                                                             \
 
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
-
 static inline void StatsAddThumbROMConstant(void)
 {
-	Stats.ThumbROMConstants++;
+	if (unlikely(PerformanceCounters))
+		Stats.ThumbROMConstants++;
 }
 
-#else
-
-static inline void StatsAddThumbROMConstant(void) {}
-
-#endif /* PERFORMANCE_IMPACTING_STATISTICS */
-
 #define thumb_ldr_from_pc(reg_rd, offset, mem_type)                           \
 {                                                                             \
   thumb_decode_imm();                                                         \
@@ -2678,6 +2867,8 @@ extern intptr_t swi_hle_handle[0x2B][3];
                                                                               \
       generate_load_imm(reg_temp, swi_hle_handle[swi_number][0]);             \
       generate_function_call_swap_delay(call_bios_hle);                       \
+      /* call_bios_hle materializes the flags while saving the CPSR */        \
+      flag_cache_state = FLAGS_EAGER;                                         \
                                                                               \
       if(swi_hle_handle[swi_number][2]) {                                     \
         mips_emit_addu(reg_r0, reg_rv, reg_zero);                             \
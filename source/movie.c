@@ -0,0 +1,340 @@
+/* Input movies and frame hash logs for ReGBA
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "common.h"
+#include "movie.h"
+
+/*
+ * A movie file is made of:
+ * - a struct MovieHeader;
+ * - BackupSize bytes written by save_backup_to_memory, because saved states
+ *   do not hold the game's SRAM, flash or EEPROM;
+ * - if the movie starts from a saved state, StateSize bytes written by
+ *   save_state_to_memory;
+ * - struct MovieRun records until the end of the file. Each says that the
+ *   same keys, in the GBA bitfield format of 'key' in input.c, were pressed
+ *   for a number of consecutive frames.
+ * All fields are little-endian.
+ *
+ * The real-time clock of games that have one still reads the system's time,
+ * so those games may not replay exactly.
+ */
+#define MOVIE_MAGIC "ReGBAMv2"
+
+#define MOVIE_ANCHOR_POWER_ON    0
+#define MOVIE_ANCHOR_SAVED_STATE 1
+
+struct MovieHeader {
+	char     Magic[8];
+	char     GameCode[4];
+	uint32_t Anchor;
+	uint32_t BootFromBIOS;  /* for movies starting from power-on */
+	uint32_t BackupSize;
+	uint32_t StateSize;
+} __attribute__((packed));
+
+struct MovieRun {
+	uint16_t Keys;
+	uint16_t Frames;
+} __attribute__((packed));
+
+enum MovieMode {
+	MOVIE_INACTIVE,
+	MOVIE_RECORDING,
+	MOVIE_PLAYING
+};
+
+static enum MovieMode Mode = MOVIE_INACTIVE;
+static FILE_TAG_TYPE MovieFile;
+static struct MovieRun CurrentRun;
+
+static FILE* HashLog = NULL;
+static uint32_t HashLogFrame;
+static uint32_t HashLogRenderedFrames;
+static uint64_t HashLogStartTime;
+
+uint32_t movie_frame_limit = 0;
+static uint32_t FramesRun = 0;
+
+static bool WriteMovieRun()
+{
+	if (CurrentRun.Frames == 0)
+		return true;
+	return FILE_WRITE(MovieFile, &CurrentRun, sizeof(CurrentRun)) == sizeof(CurrentRun);
+}
+
+bool movie_start_recording(const char* Filename, bool FromPowerOn,
+	uint32_t BootFromBIOS)
+{
+	struct MovieHeader Header;
+	uint8_t* Backup;
+	uint8_t* State = NULL;
+
+	movie_stop();
+
+	memcpy(Header.Magic, MOVIE_MAGIC, sizeof(Header.Magic));
+	memcpy(Header.GameCode, gamepak_code, sizeof(Header.GameCode));
+	Header.Anchor = MOVIE_ANCHOR_POWER_ON;
+	Header.BootFromBIOS = FromPowerOn ? BootFromBIOS : 0;
+	Header.StateSize = 0;
+
+	Backup = malloc(BACKUP_MEMORY_SIZE);
+	if (Backup == NULL)
+		return false;
+	Header.BackupSize = save_backup_to_memory(Backup);
+
+	if (!FromPowerOn)
+	{
+		State = malloc(SAVESTATE_SIZE);
+		if (State == NULL)
+		{
+			free(Backup);
+			return false;
+		}
+		Header.Anchor = MOVIE_ANCHOR_SAVED_STATE;
+		Header.StateSize = save_state_to_memory(State);
+	}
+
+	FILE_OPEN(MovieFile, Filename, WRITE);
+	if (!FILE_CHECK_VALID(MovieFile))
+	{
+		free(Backup);
+		free(State);
+		return false;
+	}
+
+	if (FILE_WRITE(MovieFile, &Header, sizeof(Header)) < sizeof(Header)
+	 || FILE_WRITE(MovieFile, Backup, Header.BackupSize) < Header.BackupSize
+	 || (State != NULL && FILE_WRITE(MovieFile, State, Header.StateSize) < Header.StateSize))
+	{
+		free(Backup);
+		free(State);
+		FILE_CLOSE(MovieFile);
+		return false;
+	}
+	free(Backup);
+	free(State);
+
+	CurrentRun.Keys = key;
+	CurrentRun.Frames = 0;
+	Mode = MOVIE_RECORDING;
+	return true;
+}
+
+bool movie_start_playback(const char* Filename)
+{
+	struct MovieHeader Header;
+	uint8_t* Backup;
+	uint8_t* State = NULL;
+
+	movie_stop();
+
+	FILE_OPEN(MovieFile, Filename, READ);
+	if (!FILE_CHECK_VALID(MovieFile))
+		return false;
+
+	if (FILE_READ(MovieFile, &Header, sizeof(Header)) < sizeof(Header)
+	 || memcmp(Header.Magic, MOVIE_MAGIC, sizeof(Header.Magic)) != 0
+	 || memcmp(Header.GameCode, gamepak_code, sizeof(Header.GameCode)) != 0
+	 || Header.BackupSize > BACKUP_MEMORY_SIZE
+	 || Header.StateSize > SAVESTATE_SIZE)
+	{
+		FILE_CLOSE(MovieFile);
+		return false;
+	}
+
+	// Read everything before changing anything, so that the game goes on
+	// as it was if the movie is cut short.
+	Backup = malloc(BACKUP_MEMORY_SIZE);
+	if (Header.Anchor == MOVIE_ANCHOR_SAVED_STATE)
+		State = malloc(SAVESTATE_SIZE);
+	if (Backup == NULL
+	 || (Header.Anchor == MOVIE_ANCHOR_SAVED_STATE && State == NULL)
+	 || FILE_READ(MovieFile, Backup, Header.BackupSize) < Header.BackupSize
+	 || (State != NULL && FILE_READ(MovieFile, State, Header.StateSize) < Header.StateSize)
+	 || !load_backup_from_memory(Backup, Header.BackupSize))
+	{
+		free(Backup);
+		free(State);
+		FILE_CLOSE(MovieFile);
+		return false;
+	}
+	free(Backup);
+
+	if (State != NULL)
+	{
+		load_state_from_memory(State);
+		free(State);
+	}
+	else
+		init_cpu(Header.BootFromBIOS);
+
+	CurrentRun.Frames = 0;
+	Mode = MOVIE_PLAYING;
+	return true;
+}
+
+void movie_stop()
+{
+	if (Mode == MOVIE_RECORDING)
+	{
+		if (!WriteMovieRun())
+			ReGBA_Trace("W: Failed to write the end of the movie");
+		FILE_CLOSE(MovieFile);
+	}
+	else if (Mode == MOVIE_PLAYING)
+		FILE_CLOSE(MovieFile);
+
+	Mode = MOVIE_INACTIVE;
+}
+
+enum ReGBA_Buttons movie_update_keys(enum ReGBA_Buttons Keys)
+{
+	switch (Mode)
+	{
+		case MOVIE_INACTIVE:
+			break;
+
+		case MOVIE_RECORDING:
+			if (CurrentRun.Keys != (Keys & 0x3FF) || CurrentRun.Frames == 0xFFFF)
+			{
+				if (!WriteMovieRun())
+				{
+					ReGBA_Trace("W: Failed to write to the movie; recording stopped");
+					CurrentRun.Frames = 0;
+					movie_stop();
+					break;
+				}
+				CurrentRun.Keys = Keys & 0x3FF;
+				CurrentRun.Frames = 0;
+			}
+			CurrentRun.Frames++;
+			break;
+
+		case MOVIE_PLAYING:
+			while (CurrentRun.Frames == 0)
+			{
+				if (FILE_READ(MovieFile, &CurrentRun, sizeof(CurrentRun)) < sizeof(CurrentRun))
+				{
+					// The movie is over. Hand control back to the user.
+					movie_stop();
+					return Keys;
+				}
+			}
+			CurrentRun.Frames--;
+			return CurrentRun.Keys;
+	}
+	return Keys;
+}
+
+bool frame_hash_log_open(const char* Filename)
+{
+	frame_hash_log_close();
+
+	HashLog = fopen(Filename, "w");
+	if (HashLog == NULL)
+		return false;
+
+	HashLogFrame = 0;
+	HashLogRenderedFrames = headless_frames_rendered;
+	HashLogStartTime = ReGBA_GetMonotonicTime();
+	sound_output_crc = 0;
+	sound_output_hashing = 1;
+	if (headless_mode)
+		request_headless_frame();
+	return true;
+}
+
+/*
+ * Writes the summary that ends a frame hash log. Its lines start with '#' so
+ * that they can be told apart from the lines for frames. They contain the
+ * time taken to emulate the logged frames, then counters from Stats.
+ */
+static void WriteHashLogSummary()
+{
+	fprintf(HashLog, "# Frames %u\n", HashLogFrame);
+	fprintf(HashLog, "# Nanoseconds %llu\n",
+		(unsigned long long) (ReGBA_GetMonotonicTime() - HashLogStartTime));
+	fprintf(HashLog, "# TotalEmulatedFrames %llu\n", (unsigned long long) Stats.TotalEmulatedFrames);
+	fprintf(HashLog, "# TotalRenderedFrames %llu\n", (unsigned long long) Stats.TotalRenderedFrames);
+	fprintf(HashLog, "# SoundBufferUnderrunCount %llu\n", (unsigned long long) Stats.SoundBufferUnderrunCount);
+#ifndef USE_C_CORE
+	{
+		uint64_t Flushes = 0, Bytes = 0;
+		uint32_t Region, Reason;
+		for (Region = 0; Region < TRANSLATION_REGION_COUNT; Region++)
+		{
+			Bytes += Stats.TranslationBytesFlushed[Region];
+			for (Reason = 0; Reason < CACHE_FLUSH_REASON_COUNT; Reason++)
+				Flushes += Stats.TranslationFlushCount[Region][Reason];
+		}
+		fprintf(HashLog, "# TranslationFlushCount %llu\n", (unsigned long long) Flushes);
+		fprintf(HashLog, "# TranslationBytesFlushed %llu\n", (unsigned long long) Bytes);
+		fprintf(HashLog, "# PartialFlushCount %llu\n", (unsigned long long) Stats.PartialFlushCount);
+	}
+#endif
+	fprintf(HashLog, "# WrongAddressLineCount %u\n", Stats.WrongAddressLineCount);
+	fprintf(HashLog, "# ARMOpcodesDecoded %llu\n", (unsigned long long) Stats.ARMOpcodesDecoded);
+	fprintf(HashLog, "# ThumbOpcodesDecoded %llu\n", (unsigned long long) Stats.ThumbOpcodesDecoded);
+	fprintf(HashLog, "# BlockRecompilationCount %llu\n", (unsigned long long) Stats.BlockRecompilationCount);
+	fprintf(HashLog, "# BlockReuseCount %llu\n", (unsigned long long) Stats.BlockReuseCount);
+}
+
+void frame_hash_log_close()
+{
+	if (HashLog != NULL)
+	{
+		WriteHashLogSummary();
+		fclose(HashLog);
+		HashLog = NULL;
+	}
+	sound_output_hashing = 0;
+}
+
+static void LogFrameHashes()
+{
+	if (headless_mode && headless_frames_rendered == HashLogRenderedFrames)
+	{
+		// The frame started before the log did, so it was not rendered.
+		fprintf(HashLog, "%u -------- %08X\n", HashLogFrame, sound_output_crc);
+	}
+	else
+	{
+		uint32_t ScreenCRC = 0;
+		uint32_t Y;
+		for (Y = 0; Y < GBA_SCREEN_HEIGHT; Y++)
+			ScreenCRC = crc32(ScreenCRC, (const Bytef*) (GBAScreen + Y * GBAScreenPitch),
+				GBA_SCREEN_WIDTH * sizeof(uint16_t));
+		fprintf(HashLog, "%u %08X %08X\n", HashLogFrame, ScreenCRC, sound_output_crc);
+	}
+
+	HashLogFrame++;
+	HashLogRenderedFrames = headless_frames_rendered;
+	sound_output_crc = 0;
+	if (headless_mode)
+		request_headless_frame();
+}
+
+void movie_frame_end()
+{
+	FramesRun++;
+	if (HashLog != NULL)
+		LogFrameHashes();
+
+	if (movie_frame_limit != 0 && FramesRun >= movie_frame_limit)
+		quit();
+}
@@ -0,0 +1,91 @@
+/* Input movies and frame hash logs for ReGBA
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef MOVIE_H
+#define MOVIE_H
+
+/*
+ * Starts recording the keys pressed on every frame to a movie file. The
+ * game's backup memory (SRAM, flash or EEPROM) is stored at the start of the
+ * movie.
+ * Input:
+ *   Filename: The path to the movie file to be created.
+ *   FromPowerOn: true if no frame of the current game has been emulated yet,
+ *   so that the movie can be replayed from a fresh start of the game. If
+ *   false, the current state of the GBA is stored at the start of the movie.
+ *   BootFromBIOS: For movies recorded from power-on, the value given to
+ *   init_cpu when the game was started.
+ * Returns:
+ *   true if recording has started; false if the file could not be created.
+ */
+extern bool movie_start_recording(const char* Filename, bool FromPowerOn,
+	uint32_t BootFromBIOS);
+
+/*
+ * Starts replaying a movie file. The backup memory stored in the movie
+ * replaces the game's, without being written to its backup file. If the
+ * movie was recorded from a saved state, that state is loaded; otherwise,
+ * this must be called before the first frame of the game is emulated, and
+ * the CPU is reset to boot as it did when the movie was recorded.
+ * Returns:
+ *   true if playback has started; false if the file could not be read, is
+ *   not a movie, or was recorded with another game.
+ */
+extern bool movie_start_playback(const char* Filename);
+
+/*
+ * Stops recording or replaying a movie, if either is in progress.
+ */
+extern void movie_stop();
+
+/*
+ * Called by update_input with the keys read from the controls for a frame.
+ * Returns the keys to be given to the GBA: the same keys while recording,
+ * which are also written to the movie, or the recorded keys while replaying.
+ */
+extern enum ReGBA_Buttons movie_update_keys(enum ReGBA_Buttons Keys);
+
+/*
+ * Starts writing a line to a text file for each frame, with the frame
+ * number, the CRC-32 of GBAScreen and the CRC-32 of the sound output during
+ * the frame. In headless mode, every frame is rendered for this.
+ * Frames skipped by frameskip are not rendered, so outside of headless mode
+ * the screen hashes are only meaningful without frameskip.
+ */
+extern bool frame_hash_log_open(const char* Filename);
+
+/*
+ * Closes the frame hash log after writing a summary: the number of frames
+ * logged, the time taken to emulate them in nanoseconds, and the counters
+ * from Stats, each on a line starting with '#'.
+ */
+
+extern void frame_hash_log_close();
+
+/*
+ * If this is not 0, the emulator quits after running this many frames. The
+ * frame hash log is closed first, so its summary is written.
+ */
+extern uint32_t movie_frame_limit;
+
+/*
+ * Called by the ports' update_gba at the end of each frame, after
+ * update_gbc_sound.
+ */
+extern void movie_frame_end();
+
+#endif /* MOVIE_H */
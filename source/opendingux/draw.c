@@ -79,10 +79,13 @@ void init_video()
 	  0 /* alpha: none */);
 
 	GBAScreen = (uint16_t*) GBAScreenSurface->pixels;
+
+	StartPresenter();
 }
 
 void SetMenuResolution()
 {
+	WaitPresenterIdle();
 #ifdef GCW_ZERO
 	if (SDL_MUSTLOCK(OutputSurface))
 		SDL_UnlockSurface(OutputSurface);
@@ -94,6 +97,7 @@ void SetMenuResolution()
 
 void SetGameResolution()
 {
+	WaitPresenterIdle();
 #ifdef GCW_ZERO
 	video_scale_type ResolvedScaleMode = ResolveSetting(ScaleMode, PerGameScaleMode);
 	unsigned int Width = GBA_SCREEN_WIDTH, Height = GBA_SCREEN_HEIGHT;
@@ -165,6 +169,31 @@ static inline uint16_t bgr555_to_rgb565_16(uint16_t px)
 	  | ((px & 0x001f) << 11);
 }
 
+/* Source lines converted to RGB 565 by bgr555_to_rgb565_rows, for the
+ * sub-pixel and bilinear scalers. Those blend every source pixel into up to
+ * 6 output pixels, so converting the lines once, two pixels per 32-bit
+ * operation, beats converting each pixel every time it is read. */
+static uint16_t ConvertedRows[4][GBA_SCREEN_WIDTH] __attribute__((aligned(4)));
+
+#define CONVERTED_ROW_PITCH (GBA_SCREEN_WIDTH * sizeof(uint16_t))
+
+/* Converts 'lines' lines of 'src_x' pixels, starting at 'from', from XBGR
+ * 1555 to RGB 565 into ConvertedRows. 'from' must be 32-bit aligned. */
+static inline void bgr555_to_rgb565_rows(uint16_t* from, uint32_t src_x,
+	uint32_t lines, uint32_t src_pitch)
+{
+	uint32_t Y, X;
+	for (Y = 0; Y < lines; Y++)
+	{
+		uint32_t* Src = (uint32_t*) ((uint8_t*) from + Y * src_pitch);
+		uint32_t* Dest = (uint32_t*) ConvertedRows[Y];
+		for (X = 0; X < src_x / 2; X++)
+			Dest[X] = bgr555_to_rgb565(Src[X]);
+		if (src_x & 1)
+			ConvertedRows[Y][src_x - 1] = bgr555_to_rgb565_16(((uint16_t*) Src)[src_x - 1]);
+	}
+}
+
 // Explaining the magic constants:
 // F7DEh is the mask to remove the lower bit of all color
 // components before dividing them by 2. Otherwise, the lower bit
@@ -610,12 +639,13 @@ static inline void gba_upscale_subpixel(uint16_t *to, uint16_t *from,
 	  uint32_t src_x, uint32_t src_y, uint32_t src_pitch, uint32_t dst_pitch)
 {
 	const uint32_t dst_x = src_x * 4 / 3;
-	const uint32_t src_skip = src_pitch - src_x * sizeof(uint16_t),
-	               dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
+	const uint32_t dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
 
 	uint_fast16_t sectY;
 	for (sectY = 0; sectY < src_y / 2; sectY++)
 	{
+		bgr555_to_rgb565_rows(from, src_x, 2, src_pitch);
+		uint16_t* row = ConvertedRows[0];
 		uint_fast16_t sectX;
 		for (sectX = 0; sectX < src_x / 3; sectX++)
 		{
@@ -627,10 +657,10 @@ static inline void gba_upscale_subpixel(uint16_t *to, uint16_t *from,
 			 * a b c | d
 			 * e f g | h
 			 */
-			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
-			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
-			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
-			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			uint32_t a = *(uint16_t*) ((uint8_t*) row    ),
+			         b = *(uint16_t*) ((uint8_t*) row + 2),
+			         c = *(uint16_t*) ((uint8_t*) row + 4),
+			         d = *(uint16_t*) ((uint8_t*) row + rightCol);
 			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
 			// coordinate for interpolation.
 
@@ -656,10 +686,10 @@ static inline void gba_upscale_subpixel(uint16_t *to, uint16_t *from,
 
 			// -- Row 2 --
 			// All pixels in this row are blended from the two rows.
-			uint32_t e = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch    )),
-			         f = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 2)),
-			         g = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 4)),
-			         h = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + rightCol));
+			uint32_t e = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH    ),
+			         f = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + 2),
+			         g = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + 4),
+			         h = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + rightCol);
 
 			// -- Row 2 pixel 1 (X = 0) --
 			*(uint16_t*) ((uint8_t*) to + dst_pitch) = likely(a == e)
@@ -719,13 +749,13 @@ static inline void gba_upscale_subpixel(uint16_t *to, uint16_t *from,
 				? g
 				: SubpixelRGB3_1(g, h);
 
-			from += 3;
+			row += 3;
 			to   += 4;
 		}
 
-		// Skip past the waste at the end of the first line, if any,
-		// then past 1 whole lines of source and 2 of destination.
-		from = (uint16_t*) ((uint8_t*) from + src_skip + 1 * src_pitch);
+		// Move down 2 whole lines of source. Skip past the waste at the
+		// end of the destination line, if any, then past 2 more of them.
+		from = (uint16_t*) ((uint8_t*) from + 2 * src_pitch);
 		to   = (uint16_t*) ((uint8_t*) to   + dst_skip + 2 * dst_pitch);
 	}
 }
@@ -750,12 +780,13 @@ static inline void gba_upscale_aspect_subpixel(uint16_t *to, uint16_t *from,
 	  uint32_t src_x, uint32_t src_y, uint32_t src_pitch, uint32_t dst_pitch)
 {
 	const uint32_t dst_x = src_x * 4 / 3;
-	const uint32_t src_skip = src_pitch - src_x * sizeof(uint16_t),
-	               dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
+	const uint32_t dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
 
 	uint_fast16_t sectY;
 	for (sectY = 0; sectY < src_y / 3; sectY++)
 	{
+		bgr555_to_rgb565_rows(from, src_x, 4, src_pitch);
+		uint16_t* row = ConvertedRows[0];
 		uint_fast16_t sectX;
 		for (sectX = 0; sectX < src_x / 3; sectX++)
 		{
@@ -770,10 +801,10 @@ static inline void gba_upscale_aspect_subpixel(uint16_t *to, uint16_t *from,
 			 * ---------
 			 * m n o | p
 			 */
-			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
-			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
-			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
-			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			uint32_t a = *(uint16_t*) ((uint8_t*) row    ),
+			         b = *(uint16_t*) ((uint8_t*) row + 2),
+			         c = *(uint16_t*) ((uint8_t*) row + 4),
+			         d = *(uint16_t*) ((uint8_t*) row + rightCol);
 			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
 			// coordinate for interpolation.
 
@@ -800,10 +831,10 @@ static inline void gba_upscale_aspect_subpixel(uint16_t *to, uint16_t *from,
 
 			// -- Row 2 --
 			// All pixels in this row use 0.75 as the Y coordinate.
-			uint32_t e = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch    )),
-			         f = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 2)),
-			         g = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 4)),
-			         h = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + rightCol));
+			uint32_t e = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH    ),
+			         f = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + 2),
+			         g = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + 4),
+			         h = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + rightCol);
 
 			// -- Row 2 pixel 1 (X = 0) --
 			*(uint16_t*) ((uint8_t*) to + dst_pitch) = likely(a == e)
@@ -845,10 +876,10 @@ static inline void gba_upscale_aspect_subpixel(uint16_t *to, uint16_t *from,
 
 			// -- Row 3 --
 			// All pixels in this row use 1.5 as the Y coordinate.
-			uint32_t i = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2    )),
-			         j = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + 2)),
-			         k = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + 4)),
-			         l = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + rightCol));
+			uint32_t i = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 2    ),
+			         j = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 2 + 2),
+			         k = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 2 + 4),
+			         l = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 2 + rightCol);
 
 			// -- Row 3 pixel 1 (X = 0) --
 			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2) = likely(e == i)
@@ -881,10 +912,10 @@ static inline void gba_upscale_aspect_subpixel(uint16_t *to, uint16_t *from,
 
 			// -- Row 4 --
 			// All pixels in this row use 2.25 as the Y coordinate.
-			uint32_t m = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3    )),
-			         n = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + 2)),
-			         o = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + 4)),
-			         p = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + rightCol));
+			uint32_t m = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 3    ),
+			         n = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 3 + 2),
+			         o = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 3 + 4),
+			         p = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 3 + rightCol);
 
 			// -- Row 4 pixel 1 (X = 0) --
 			*(uint16_t*) ((uint8_t*) to + dst_pitch * 3) = likely(i == m)
@@ -915,18 +946,20 @@ static inline void gba_upscale_aspect_subpixel(uint16_t *to, uint16_t *from,
 				? k3l1
 				: AverageQuarters3_1(/* in X, top */ k3l1, /* in X, bottom */ o3p1);
 
-			from += 3;
+			row += 3;
 			to   += 4;
 		}
 
-		// Skip past the waste at the end of the first line, if any,
-		// then past 2 whole lines of source and 3 of destination.
-		from = (uint16_t*) ((uint8_t*) from + src_skip + 2 * src_pitch);
+		// Move down 3 whole lines of source. Skip past the waste at the
+		// end of the destination line, if any, then past 3 more of them.
+		from = (uint16_t*) ((uint8_t*) from + 3 * src_pitch);
 		to   = (uint16_t*) ((uint8_t*) to   + dst_skip + 3 * dst_pitch);
 	}
 
 	if (src_y % 3 == 1)
 	{
+		bgr555_to_rgb565_rows(from, src_x, 1, src_pitch);
+		uint16_t* row = ConvertedRows[0];
 		uint_fast16_t sectX;
 		for (sectX = 0; sectX < src_x / 3; sectX++)
 		{
@@ -937,10 +970,10 @@ static inline void gba_upscale_aspect_subpixel(uint16_t *to, uint16_t *from,
 			 *
 			 * a b c | d
 			 */
-			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
-			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
-			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
-			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			uint32_t a = *(uint16_t*) ((uint8_t*) row    ),
+			         b = *(uint16_t*) ((uint8_t*) row + 2),
+			         c = *(uint16_t*) ((uint8_t*) row + 4),
+			         d = *(uint16_t*) ((uint8_t*) row + rightCol);
 			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
 			// coordinate for interpolation.
 
@@ -962,7 +995,7 @@ static inline void gba_upscale_aspect_subpixel(uint16_t *to, uint16_t *from,
 				? c
 				: AverageQuarters3_1(c, d);
 
-			from += 3;
+			row += 3;
 			to   += 4;
 		}
 	}
@@ -988,12 +1021,13 @@ static inline void gba_upscale_aspect_bilinear(uint16_t *to, uint16_t *from,
 	  uint32_t src_x, uint32_t src_y, uint32_t src_pitch, uint32_t dst_pitch)
 {
 	const uint32_t dst_x = src_x * 4 / 3;
-	const uint32_t src_skip = src_pitch - src_x * sizeof(uint16_t),
-	               dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
+	const uint32_t dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
 
 	uint_fast16_t sectY;
 	for (sectY = 0; sectY < src_y / 3; sectY++)
 	{
+		bgr555_to_rgb565_rows(from, src_x, 4, src_pitch);
+		uint16_t* row = ConvertedRows[0];
 		uint_fast16_t sectX;
 		for (sectX = 0; sectX < src_x / 3; sectX++)
 		{
@@ -1008,10 +1042,10 @@ static inline void gba_upscale_aspect_bilinear(uint16_t *to, uint16_t *from,
 			 * ---------
 			 * m n o | p
 			 */
-			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
-			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
-			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
-			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			uint32_t a = *(uint16_t*) ((uint8_t*) row    ),
+			         b = *(uint16_t*) ((uint8_t*) row + 2),
+			         c = *(uint16_t*) ((uint8_t*) row + 4),
+			         d = *(uint16_t*) ((uint8_t*) row + rightCol);
 			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
 			// coordinate for interpolation.
 
@@ -1038,10 +1072,10 @@ static inline void gba_upscale_aspect_bilinear(uint16_t *to, uint16_t *from,
 
 			// -- Row 2 --
 			// All pixels in this row use 0.75 as the Y coordinate.
-			uint32_t e = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch    )),
-			         f = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 2)),
-			         g = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 4)),
-			         h = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + rightCol));
+			uint32_t e = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH    ),
+			         f = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + 2),
+			         g = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + 4),
+			         h = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + rightCol);
 
 			// -- Row 2 pixel 1 (X = 0) --
 			*(uint16_t*) ((uint8_t*) to + dst_pitch) = likely(a == e)
@@ -1083,10 +1117,10 @@ static inline void gba_upscale_aspect_bilinear(uint16_t *to, uint16_t *from,
 
 			// -- Row 3 --
 			// All pixels in this row use 1.5 as the Y coordinate.
-			uint32_t i = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2    )),
-			         j = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + 2)),
-			         k = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + 4)),
-			         l = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + rightCol));
+			uint32_t i = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 2    ),
+			         j = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 2 + 2),
+			         k = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 2 + 4),
+			         l = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 2 + rightCol);
 
 			// -- Row 3 pixel 1 (X = 0) --
 			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2) = likely(e == i)
@@ -1119,10 +1153,10 @@ static inline void gba_upscale_aspect_bilinear(uint16_t *to, uint16_t *from,
 
 			// -- Row 4 --
 			// All pixels in this row use 2.25 as the Y coordinate.
-			uint32_t m = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3    )),
-			         n = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + 2)),
-			         o = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + 4)),
-			         p = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + rightCol));
+			uint32_t m = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 3    ),
+			         n = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 3 + 2),
+			         o = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 3 + 4),
+			         p = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH * 3 + rightCol);
 
 			// -- Row 4 pixel 1 (X = 0) --
 			*(uint16_t*) ((uint8_t*) to + dst_pitch * 3) = likely(i == m)
@@ -1153,18 +1187,20 @@ static inline void gba_upscale_aspect_bilinear(uint16_t *to, uint16_t *from,
 				? k3l1
 				: AverageQuarters3_1(/* in X, top */ k3l1, /* in X, bottom */ o3p1);
 
-			from += 3;
+			row += 3;
 			to   += 4;
 		}
 
-		// Skip past the waste at the end of the first line, if any,
-		// then past 2 whole lines of source and 3 of destination.
-		from = (uint16_t*) ((uint8_t*) from + src_skip + 2 * src_pitch);
+		// Move down 3 whole lines of source. Skip past the waste at the
+		// end of the destination line, if any, then past 3 more of them.
+		from = (uint16_t*) ((uint8_t*) from + 3 * src_pitch);
 		to   = (uint16_t*) ((uint8_t*) to   + dst_skip + 3 * dst_pitch);
 	}
 
 	if (src_y % 3 == 1)
 	{
+		bgr555_to_rgb565_rows(from, src_x, 1, src_pitch);
+		uint16_t* row = ConvertedRows[0];
 		uint_fast16_t sectX;
 		for (sectX = 0; sectX < src_x / 3; sectX++)
 		{
@@ -1175,10 +1211,10 @@ static inline void gba_upscale_aspect_bilinear(uint16_t *to, uint16_t *from,
 			 *
 			 * a b c | d
 			 */
-			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
-			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
-			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
-			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			uint32_t a = *(uint16_t*) ((uint8_t*) row    ),
+			         b = *(uint16_t*) ((uint8_t*) row + 2),
+			         c = *(uint16_t*) ((uint8_t*) row + 4),
+			         d = *(uint16_t*) ((uint8_t*) row + rightCol);
 			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
 			// coordinate for interpolation.
 
@@ -1200,7 +1236,7 @@ static inline void gba_upscale_aspect_bilinear(uint16_t *to, uint16_t *from,
 				? c
 				: AverageQuarters3_1(c, d);
 
-			from += 3;
+			row += 3;
 			to   += 4;
 		}
 	}
@@ -1226,12 +1262,13 @@ static inline void gba_upscale_bilinear(uint16_t *to, uint16_t *from,
 	  uint32_t src_x, uint32_t src_y, uint32_t src_pitch, uint32_t dst_pitch)
 {
 	const uint32_t dst_x = src_x * 4 / 3;
-	const uint32_t src_skip = src_pitch - src_x * sizeof(uint16_t),
-	               dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
+	const uint32_t dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
 
 	uint_fast16_t sectY;
 	for (sectY = 0; sectY < src_y / 2; sectY++)
 	{
+		bgr555_to_rgb565_rows(from, src_x, 2, src_pitch);
+		uint16_t* row = ConvertedRows[0];
 		uint_fast16_t sectX;
 		for (sectX = 0; sectX < src_x / 3; sectX++)
 		{
@@ -1243,10 +1280,10 @@ static inline void gba_upscale_bilinear(uint16_t *to, uint16_t *from,
 			 * a b c | d
 			 * e f g | h
 			 */
-			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
-			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
-			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
-			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			uint32_t a = *(uint16_t*) ((uint8_t*) row    ),
+			         b = *(uint16_t*) ((uint8_t*) row + 2),
+			         c = *(uint16_t*) ((uint8_t*) row + 4),
+			         d = *(uint16_t*) ((uint8_t*) row + rightCol);
 			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
 			// coordinate for interpolation.
 
@@ -1272,10 +1309,10 @@ static inline void gba_upscale_bilinear(uint16_t *to, uint16_t *from,
 
 			// -- Row 2 --
 			// All pixels in this row are blended from the two rows.
-			uint32_t e = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch    )),
-			         f = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 2)),
-			         g = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 4)),
-			         h = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + rightCol));
+			uint32_t e = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH    ),
+			         f = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + 2),
+			         g = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + 4),
+			         h = *(uint16_t*) ((uint8_t*) row + CONVERTED_ROW_PITCH + rightCol);
 
 			// -- Row 2 pixel 1 (X = 0) --
 			*(uint16_t*) ((uint8_t*) to + dst_pitch) = likely(a == e)
@@ -1335,13 +1372,13 @@ static inline void gba_upscale_bilinear(uint16_t *to, uint16_t *from,
 				? g
 				: AverageQuarters3_1(g, h);
 
-			from += 3;
+			row += 3;
 			to   += 4;
 		}
 
-		// Skip past the waste at the end of the first line, if any,
-		// then past 1 whole lines of source and 2 of destination.
-		from = (uint16_t*) ((uint8_t*) from + src_skip + 1 * src_pitch);
+		// Move down 2 whole lines of source. Skip past the waste at the
+		// end of the destination line, if any, then past 2 more of them.
+		from = (uint16_t*) ((uint8_t*) from + 2 * src_pitch);
 		to   = (uint16_t*) ((uint8_t*) to   + dst_skip + 2 * dst_pitch);
 	}
 }
@@ -1487,70 +1524,219 @@ void ScaleModeUnapplied()
 	FramesBordered = 0;
 }
 
-void ReGBA_RenderScreen(void)
+/* Converts, scales and displays a GBA frame on OutputSurface, along with the
+ * on-screen display, then flips it.
+ * Input:
+ *   Src: A pointer to the first pixel of the GBA frame, in XBGR 1555.
+ *   SrcPitch: The number of bytes making up a scanline in the frame.
+ */
+static void PresentFrame(uint16_t* Src, uint32_t SrcPitch)
 {
-	if (ReGBA_IsRenderingNextFrame())
+	video_scale_type ResolvedScaleMode = ResolveSetting(ScaleMode, PerGameScaleMode);
+	if (FramesBordered < 3)
+	{
+		ApplyScaleMode(ResolvedScaleMode);
+		FramesBordered++;
+	}
+	switch (ResolvedScaleMode)
 	{
-		Stats.TotalRenderedFrames++;
-		Stats.RenderedFrames++;
-		video_scale_type ResolvedScaleMode = ResolveSetting(ScaleMode, PerGameScaleMode);
-		if (FramesBordered < 3)
-		{
-			ApplyScaleMode(ResolvedScaleMode);
-			FramesBordered++;
-		}
-		switch (ResolvedScaleMode)
-		{
 #ifndef GCW_ZERO
-			case hardware: /* Hardware, when there's no hardware to scale
-			                  images, acts as unscaled */
+		case hardware: /* Hardware, when there's no hardware to scale
+		                  images, acts as unscaled */
 #endif
-			case unscaled:
-				gba_render(OutputSurface->pixels, GBAScreen, GBAScreenSurface->pitch, OutputSurface->pitch);
-				break;
+		case unscaled:
+			gba_render(OutputSurface->pixels, Src, SrcPitch, OutputSurface->pitch);
+			break;
 
-			case fullscreen:
-				gba_upscale(OutputSurface->pixels, GBAScreen, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, GBAScreenSurface->pitch, OutputSurface->pitch);
-				break;
+		case fullscreen:
+			gba_upscale(OutputSurface->pixels, Src, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, SrcPitch, OutputSurface->pitch);
+			break;
 
-			case fullscreen_bilinear:
-				gba_upscale_bilinear(OutputSurface->pixels, GBAScreen, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, GBAScreenSurface->pitch, OutputSurface->pitch);
-				break;
+		case fullscreen_bilinear:
+			gba_upscale_bilinear(OutputSurface->pixels, Src, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, SrcPitch, OutputSurface->pitch);
+			break;
 
-			case fullscreen_subpixel:
-				gba_upscale_subpixel(OutputSurface->pixels, GBAScreen, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, GBAScreenSurface->pitch, OutputSurface->pitch);
-				break;
+		case fullscreen_subpixel:
+			gba_upscale_subpixel(OutputSurface->pixels, Src, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, SrcPitch, OutputSurface->pitch);
+			break;
 
-			case scaled_aspect:
-				gba_upscale_aspect((uint16_t*) ((uint8_t*)
-					OutputSurface->pixels +
-					(((GCW0_SCREEN_HEIGHT - (GBA_SCREEN_HEIGHT) * 4 / 3) / 2) * OutputSurface->pitch)) /* center vertically */,
-					GBAScreen, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, GBAScreenSurface->pitch, OutputSurface->pitch);
-				break;
+		case scaled_aspect:
+			gba_upscale_aspect((uint16_t*) ((uint8_t*)
+				OutputSurface->pixels +
+				(((GCW0_SCREEN_HEIGHT - (GBA_SCREEN_HEIGHT) * 4 / 3) / 2) * OutputSurface->pitch)) /* center vertically */,
+				Src, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, SrcPitch, OutputSurface->pitch);
+			break;
 
-			case scaled_aspect_bilinear:
-				gba_upscale_aspect_bilinear((uint16_t*) ((uint8_t*)
-					OutputSurface->pixels +
-					(((GCW0_SCREEN_HEIGHT - (GBA_SCREEN_HEIGHT) * 4 / 3) / 2) * OutputSurface->pitch)) /* center vertically */,
-					GBAScreen, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, GBAScreenSurface->pitch, OutputSurface->pitch);
-				break;
+		case scaled_aspect_bilinear:
+			gba_upscale_aspect_bilinear((uint16_t*) ((uint8_t*)
+				OutputSurface->pixels +
+				(((GCW0_SCREEN_HEIGHT - (GBA_SCREEN_HEIGHT) * 4 / 3) / 2) * OutputSurface->pitch)) /* center vertically */,
+				Src, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, SrcPitch, OutputSurface->pitch);
+			break;
 
-			case scaled_aspect_subpixel:
-				gba_upscale_aspect_subpixel((uint16_t*) ((uint8_t*)
-					OutputSurface->pixels +
-					(((GCW0_SCREEN_HEIGHT - (GBA_SCREEN_HEIGHT) * 4 / 3) / 2) * OutputSurface->pitch)) /* center vertically */,
-					GBAScreen, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, GBAScreenSurface->pitch, OutputSurface->pitch);
-				break;
+		case scaled_aspect_subpixel:
+			gba_upscale_aspect_subpixel((uint16_t*) ((uint8_t*)
+				OutputSurface->pixels +
+				(((GCW0_SCREEN_HEIGHT - (GBA_SCREEN_HEIGHT) * 4 / 3) / 2) * OutputSurface->pitch)) /* center vertically */,
+				Src, GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, SrcPitch, OutputSurface->pitch);
+			break;
 
 #ifdef GCW_ZERO
-			case hardware:
-				gba_convert(OutputSurface->pixels, GBAScreen, GBAScreenSurface->pitch, OutputSurface->pitch);
+		case hardware:
+			gba_convert(OutputSurface->pixels, Src, SrcPitch, OutputSurface->pitch);
 #endif
-		}
-		ReGBA_DisplayFPS();
+	}
+	ReGBA_DisplayFPS();
 
-		ReGBA_VideoFlip();
+	ReGBA_VideoFlip();
+}
+
+/* On systems with more than one processor, a presenter thread calls
+ * PresentFrame, so that scaling a frame overlaps with emulating the next.
+ * Frames reach it through three buffers. The emulation thread copies
+ * GBAScreen into PresenterBack, then swaps that with PresenterReady. The
+ * presenter thread swaps PresenterReady with PresenterFront, then presents
+ * PresenterFront. If the presenter falls behind, a frame still waiting in
+ * PresenterReady is replaced by the next one, and so it's dropped.
+ *
+ * GBAScreen itself is not swapped, because the renderer skips scanlines
+ * that it knows are already in it. */
+static SDL_Thread* PresenterThread = NULL;
+static SDL_mutex*  PresenterLock;
+static SDL_cond*   PresenterCond;
+static uint16_t*   PresenterBack;
+static uint16_t*   PresenterReady;
+static uint16_t*   PresenterFront;
+static uint32_t    PresenterPitch;
+static bool        PresenterFrameReady = false;
+static bool        PresenterBusy = false;
+static bool        PresenterQuit = false;
+/* Nanoseconds spent in PresentFrame since the last frame was queued, while
+ * FrameTiming is non-zero. */
+static uint64_t    PresenterTime = 0;
+
+static int PresenterMain(void* Data)
+{
+	SDL_LockMutex(PresenterLock);
+	while (true)
+	{
+		while (!PresenterFrameReady && !PresenterQuit)
+			SDL_CondWait(PresenterCond, PresenterLock);
+		if (PresenterQuit)
+			break;
+
+		uint16_t* Swap = PresenterFront;
+		PresenterFront = PresenterReady;
+		PresenterReady = Swap;
+		PresenterFrameReady = false;
+		PresenterBusy = true;
+		SDL_UnlockMutex(PresenterLock);
+
+		uint64_t Start = FrameTiming ? ReGBA_GetMonotonicTime() : 0;
+		PresentFrame(PresenterFront, PresenterPitch);
+
+		SDL_LockMutex(PresenterLock);
+		if (Start != 0)
+			PresenterTime += ReGBA_GetMonotonicTime() - Start;
+		PresenterBusy = false;
+		SDL_CondBroadcast(PresenterCond);
+	}
+	SDL_UnlockMutex(PresenterLock);
+	return 0;
+}
 
+void StartPresenter()
+{
+	if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+		return;
+
+	size_t Size = GBAScreenSurface->pitch * GBA_SCREEN_HEIGHT;
+	PresenterPitch = GBAScreenSurface->pitch;
+	PresenterBack = malloc(Size);
+	PresenterReady = malloc(Size);
+	PresenterFront = malloc(Size);
+	PresenterLock = SDL_CreateMutex();
+	PresenterCond = SDL_CreateCond();
+	if (PresenterBack == NULL || PresenterReady == NULL || PresenterFront == NULL
+	 || PresenterLock == NULL || PresenterCond == NULL
+	 || (PresenterThread = SDL_CreateThread(PresenterMain, NULL)) == NULL)
+	{
+		// Present frames on the emulation thread instead.
+		printf("Failed to start the presenter thread\n");
+		free(PresenterBack);
+		free(PresenterReady);
+		free(PresenterFront);
+		if (PresenterLock != NULL)
+			SDL_DestroyMutex(PresenterLock);
+		if (PresenterCond != NULL)
+			SDL_DestroyCond(PresenterCond);
+	}
+}
+
+void WaitPresenterIdle()
+{
+	if (PresenterThread == NULL)
+		return;
+
+	SDL_LockMutex(PresenterLock);
+	PresenterFrameReady = false;
+	while (PresenterBusy)
+		SDL_CondWait(PresenterCond, PresenterLock);
+	SDL_UnlockMutex(PresenterLock);
+}
+
+void StopPresenter()
+{
+	if (PresenterThread == NULL)
+		return;
+
+	SDL_LockMutex(PresenterLock);
+	PresenterQuit = true;
+	SDL_CondBroadcast(PresenterCond);
+	SDL_UnlockMutex(PresenterLock);
+	SDL_WaitThread(PresenterThread, NULL);
+	PresenterThread = NULL;
+}
+
+bool IsPresenterRunning()
+{
+	return PresenterThread != NULL;
+}
+
+/* Hands the current contents of GBAScreen to the presenter thread. */
+static void QueuePresenterFrame()
+{
+	memcpy(PresenterBack, GBAScreen, PresenterPitch * GBA_SCREEN_HEIGHT);
+
+	SDL_LockMutex(PresenterLock);
+	uint16_t* Swap = PresenterReady;
+	PresenterReady = PresenterBack;
+	PresenterBack = Swap;
+	PresenterFrameReady = true;
+	Stats.PresenterFrameTime = PresenterTime;
+	PresenterTime = 0;
+	SDL_CondBroadcast(PresenterCond);
+	SDL_UnlockMutex(PresenterLock);
+}
+
+void ReGBA_RenderScreen(void)
+{
+	enum FrameTimeCategory PreviousTimeCategory =
+		StatsEnterFrameTime(FRAME_TIME_PRESENT);
+
+	if (ReGBA_IsRenderingNextFrame())
+	{
+		// Counted here, on the emulation thread, because port.c resets
+		// RenderedFrames on it. A frame that the presenter thread drops is
+		// still counted.
+		Stats.TotalRenderedFrames++;
+		Stats.RenderedFrames++;
+		if (PresenterThread != NULL)
+			QueuePresenterFrame();
+		else
+			PresentFrame(GBAScreen, GBAScreenSurface->pitch);
+
+		StatsEnterFrameTime(FRAME_TIME_IDLE);
 		while (true)
 		{
 			unsigned int AudioFastForwardedCopy = AudioFastForwarded;
@@ -1564,6 +1750,8 @@ void ReGBA_RenderScreen(void)
 		}
 	}
 
+	StatsEnterFrameTime(PreviousTimeCategory);
+
 	if (ReGBA_GetAudioSamplesAvailable() < AUDIO_OUTPUT_BUFFER_SIZE * 2 * OUTPUT_FREQUENCY_DIVISOR)
 	{
 		if (AudioFrameskip < MAX_AUTO_FRAMESKIP)
@@ -50,6 +50,29 @@ extern video_scale_type PerGameScaleMode;
 extern video_scale_type ScaleMode;
 
 void init_video();
+
+/*
+ * Starts the thread that scales and displays GBA frames, if there is more
+ * than one processor. Without it, ReGBA_RenderScreen does that work itself.
+ */
+extern void StartPresenter();
+
+/*
+ * Discards any GBA frame still waiting to be displayed, then waits until the
+ * presenter thread has finished displaying its current one, if any. This is
+ * needed before anything else draws to or replaces OutputSurface.
+ */
+extern void WaitPresenterIdle();
+
+/*
+ * Stops the presenter thread, if it's running.
+ */
+extern void StopPresenter();
+
+/*
+ * Returns true if the presenter thread is running.
+ */
+extern bool IsPresenterRunning();
 extern bool ApplyBorder(const char* Filename);
 
 extern void ApplyScaleMode(video_scale_type NewMode);
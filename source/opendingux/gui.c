@@ -965,6 +965,30 @@ static void ActionShowVersion(struct Menu** ActiveMenu, uint32_t* ActiveMenuEntr
 	GrabButtons(*ActiveMenu, Text);
 }
 
+static void ActionEventTrace(struct Menu** ActiveMenu, uint32_t* ActiveMenuEntryIndex)
+{
+	char Text[1024];
+	char TracePath[MAX_PATH + 1];
+	sprintf(TracePath, "%s/trace.bin", main_path);
+
+	if (trace_categories == 0)
+	{
+		if (trace_set_categories(TRACE_CATEGORIES_ALL))
+			sprintf(Text, "Event tracing started.\nSelect this again to stop it and\nsave the trace to %s.", TracePath);
+		else
+			sprintf(Text, "Event tracing failed to start:\nNot enough memory");
+	}
+	else
+	{
+		trace_set_categories(0);
+		if (trace_save(TracePath))
+			sprintf(Text, "Event tracing stopped.\nThe trace was saved to %s.", TracePath);
+		else
+			sprintf(Text, "Saving the event trace failed:\n%s", strerror(errno));
+	}
+	GrabButtons(*ActiveMenu, Text);
+}
+
 // -- Strut --
 
 static bool CanNeverFocusFunction(struct Menu* ActiveMenu, struct MenuEntry* ActiveMenuEntry)
@@ -1057,7 +1081,6 @@ static struct MenuEntry ExecutionMenu_FramesRendered = {
 	ENTRY_DISPLAY("Frames rendered", &Stats.TotalRenderedFrames, TYPE_UINT64)
 };
 
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 static struct MenuEntry ExecutionMenu_ARMOps = {
 	ENTRY_DISPLAY("ARM opcodes decoded", &Stats.ARMOpcodesDecoded, TYPE_UINT64)
 };
@@ -1073,15 +1096,10 @@ static struct MenuEntry ExecutionMenu_ThumbROMConsts = {
 static struct MenuEntry ExecutionMenu_MemAccessors = {
 	ENTRY_DISPLAY("Memory accessors patched", &Stats.WrongAddressLineCount, TYPE_UINT32)
 };
-#endif
 
 static struct Menu ExecutionMenu = {
 	.Parent = &DebugMenu, .Title = "Execution statistics",
-	.Entries = { &ExecutionMenu_SoundUnderruns, &ExecutionMenu_FramesEmulated, &ExecutionMenu_FramesRendered
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
-	, &ExecutionMenu_ARMOps, &ExecutionMenu_ThumbOps, &ExecutionMenu_ThumbROMConsts, &ExecutionMenu_MemAccessors
-#endif
-	, NULL }
+	.Entries = { &ExecutionMenu_SoundUnderruns, &ExecutionMenu_FramesEmulated, &ExecutionMenu_FramesRendered, &ExecutionMenu_ARMOps, &ExecutionMenu_ThumbOps, &ExecutionMenu_ThumbROMConsts, &ExecutionMenu_MemAccessors, NULL }
 };
 
 static struct MenuEntry DebugMenu_Execution = {
@@ -1090,7 +1108,6 @@ static struct MenuEntry DebugMenu_Execution = {
 
 // -- Debug > Code reuse stats --
 
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 static struct MenuEntry ReuseMenu_OpsRecompiled = {
 	ENTRY_DISPLAY("Opcodes recompiled", &Stats.OpcodeRecompilationCount, TYPE_UINT64)
 };
@@ -1115,7 +1132,45 @@ static struct Menu ReuseMenu = {
 static struct MenuEntry DebugMenu_Reuse = {
 	ENTRY_SUBMENU("Code reuse statistics...", &ReuseMenu)
 };
-#endif
+
+// -- Debug > Renderer stats --
+
+static struct MenuEntry RendererMenu_Mode0 = {
+	ENTRY_DISPLAY("Mode 0 ns per scanline", &Stats.ScanlineRenderAverage[0], TYPE_UINT64)
+};
+
+static struct MenuEntry RendererMenu_Mode1 = {
+	ENTRY_DISPLAY("Mode 1 ns per scanline", &Stats.ScanlineRenderAverage[1], TYPE_UINT64)
+};
+
+static struct MenuEntry RendererMenu_Mode2 = {
+	ENTRY_DISPLAY("Mode 2 ns per scanline", &Stats.ScanlineRenderAverage[2], TYPE_UINT64)
+};
+
+static struct MenuEntry RendererMenu_Mode3 = {
+	ENTRY_DISPLAY("Mode 3 ns per scanline", &Stats.ScanlineRenderAverage[3], TYPE_UINT64)
+};
+
+static struct MenuEntry RendererMenu_Mode4 = {
+	ENTRY_DISPLAY("Mode 4 ns per scanline", &Stats.ScanlineRenderAverage[4], TYPE_UINT64)
+};
+
+static struct MenuEntry RendererMenu_Mode5 = {
+	ENTRY_DISPLAY("Mode 5 ns per scanline", &Stats.ScanlineRenderAverage[5], TYPE_UINT64)
+};
+
+static struct MenuEntry RendererMenu_Skipped = {
+	ENTRY_DISPLAY("Scanlines skipped", &Stats.ScanlinesSkipped, TYPE_UINT64)
+};
+
+static struct Menu RendererMenu = {
+	.Parent = &DebugMenu, .Title = "Renderer statistics",
+	.Entries = { &RendererMenu_Mode0, &RendererMenu_Mode1, &RendererMenu_Mode2, &RendererMenu_Mode3, &RendererMenu_Mode4, &RendererMenu_Mode5, &RendererMenu_Skipped, NULL }
+};
+
+static struct MenuEntry DebugMenu_Renderer = {
+	ENTRY_SUBMENU("Renderer statistics...", &RendererMenu)
+};
 
 static struct MenuEntry ROMInfoMenu_GameName = {
 	ENTRY_DISPLAY("game_name =", gamepak_title, TYPE_STRING)
@@ -1138,6 +1193,26 @@ static struct MenuEntry DebugMenu_ROMInfo = {
 	ENTRY_SUBMENU("ROM information...", &ROMInfoMenu)
 };
 
+static struct MenuEntry DebugMenu_PerformanceCounters = {
+	ENTRY_OPTION("detailed_statistics", "Detailed statistics", &PerformanceCounters),
+	.ChoiceCount = 2, .Choices = { { "Off", "off" }, { "On", "on" } }
+};
+
+static struct MenuEntry DebugMenu_FrameTiming = {
+	ENTRY_OPTION("frame_timing", "Frame time breakdown", &FrameTiming),
+	.ChoiceCount = 2, .Choices = { { "Off", "off" }, { "On", "on" } }
+};
+
+static struct MenuEntry DebugMenu_DeferredRendering = {
+	ENTRY_OPTION("deferred_rendering", "Render whole frames at once", &deferred_rendering),
+	.ChoiceCount = 2, .Choices = { { "Off", "off" }, { "On", "on" } }
+};
+
+static struct MenuEntry DebugMenu_EventTrace = {
+	.Kind = KIND_CUSTOM, .Name = "Start or save event trace...",
+	.ButtonEnterFunction = &ActionEventTrace
+};
+
 static struct MenuEntry DebugMenu_VersionInfo = {
 	.Kind = KIND_CUSTOM, .Name = "ReGBA version information...",
 	.ButtonEnterFunction = &ActionShowVersion
@@ -1147,11 +1222,7 @@ static struct MenuEntry DebugMenu_VersionInfo = {
 
 static struct Menu DebugMenu = {
 	.Parent = &MainMenu, .Title = "Performance and debugging",
-	.Entries = { &DebugMenu_NativeCode, &DebugMenu_Metadata, &DebugMenu_Execution
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
-	, &DebugMenu_Reuse
-#endif
-	, &Strut, &DebugMenu_ROMInfo, &Strut, &DebugMenu_VersionInfo, NULL }
+	.Entries = { &DebugMenu_NativeCode, &DebugMenu_Metadata, &DebugMenu_Execution, &DebugMenu_Reuse, &DebugMenu_Renderer, &DebugMenu_PerformanceCounters, &DebugMenu_FrameTiming, &DebugMenu_DeferredRendering, &Strut, &DebugMenu_EventTrace, &DebugMenu_ROMInfo, &Strut, &DebugMenu_VersionInfo, NULL }
 };
 
 // -- Display Settings --
@@ -1490,6 +1561,7 @@ static struct Menu ErrorScreen = {
 u32 ReGBA_Menu(enum ReGBA_MenuEntryReason EntryReason)
 {
 	SDL_PauseAudio(SDL_ENABLE);
+	WaitPresenterIdle();
 	MainMenu.UserData = copy_screen();
 	ScaleModeUnapplied();
 
@@ -44,6 +44,36 @@ u32 synchronize_flag = 1;
 
 char executable_path[MAX_PATH + 1];
 
+// Where to save the event trace when quitting, if --trace was given.
+static const char* TraceFilePath = NULL;
+
+// Where --stats-log writes the change in the statistics every
+// STATS_LOG_INTERVAL frames.
+#define STATS_LOG_INTERVAL 600
+static FILE* StatsLog = NULL;
+
+static void WriteStatsLog(const struct ReGBA_Stats* Current,
+	const struct ReGBA_Stats* Previous)
+{
+	uint64_t Flushes = 0;
+	uint32_t Region, Reason;
+	for (Region = 0; Region < TRANSLATION_REGION_COUNT; Region++)
+		for (Reason = 0; Reason < CACHE_FLUSH_REASON_COUNT; Reason++)
+			Flushes += Current->TranslationFlushCount[Region][Reason]
+				- Previous->TranslationFlushCount[Region][Reason];
+
+	fprintf(StatsLog, "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu32 "\n",
+		Current->TotalEmulatedFrames,
+		Current->TotalRenderedFrames - Previous->TotalRenderedFrames,
+		Flushes,
+		Current->ARMOpcodesDecoded - Previous->ARMOpcodesDecoded,
+		Current->ThumbOpcodesDecoded - Previous->ThumbOpcodesDecoded,
+		Current->BlockRecompilationCount - Previous->BlockRecompilationCount,
+		Current->BlockReuseCount - Previous->BlockReuseCount,
+		Current->WrongAddressLineCount - Previous->WrongAddressLineCount);
+	fflush(StatsLog);
+}
+
 #define check_count(count_var)                                                \
   if(count_var < execute_cycles)                                              \
     execute_cycles = count_var;                                               \
@@ -119,6 +149,7 @@ void init_main()
 
   if (!caches_inited)
   {
+    init_translater();
     flush_translation_cache(TRANSLATION_REGION_READONLY, FLUSH_REASON_INITIALIZING);
     flush_translation_cache(TRANSLATION_REGION_WRITABLE, FLUSH_REASON_INITIALIZING);
   }
@@ -218,6 +249,66 @@ int main(int argc, char *argv[])
 
   if(argc > 1)
   {
+		// regba <ROM> [options]
+		// --headless runs the game without video or audio output and without
+		//   speed limits.
+		// --record FILE records the keys pressed from power-on to a movie.
+		// --play FILE replays a movie recorded with --record.
+		// --hash-log FILE writes the CRC-32 of the screen and of the sound
+		//   output of every frame to a text file.
+		// --frames N quits after emulating N frames.
+		// --trace MASK FILE records the events of the categories in MASK
+		//   (see trace.h) and saves them to FILE when quitting.
+		// --stats-log FILE turns on detailed statistics and writes how they
+		//   changed to FILE, in CSV, every 600 frames.
+		// --frame-time-log FILE writes the time spent in each subsystem
+		//   during every frame to FILE, in CSV.
+		// --ppu-dump N FILE saves video memory and the video registers of
+		//   the first frame rendered after N frames to FILE, for
+		//   tools/ppureplay.
+		const char* RecordPath = NULL;
+		const char* PlayPath = NULL;
+		const char* HashLogPath = NULL;
+		int i;
+		for (i = 2; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--headless") == 0)
+				headless_mode = 1;
+			else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+				RecordPath = argv[++i];
+			else if (strcmp(argv[i], "--play") == 0 && i + 1 < argc)
+				PlayPath = argv[++i];
+			else if (strcmp(argv[i], "--hash-log") == 0 && i + 1 < argc)
+				HashLogPath = argv[++i];
+			else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+				movie_frame_limit = strtoul(argv[++i], NULL, 10);
+			else if (strcmp(argv[i], "--trace") == 0 && i + 2 < argc)
+			{
+				if (trace_set_categories(strtoul(argv[i + 1], NULL, 0)))
+					TraceFilePath = argv[i + 2];
+				i += 2;
+			}
+			else if (strcmp(argv[i], "--stats-log") == 0 && i + 1 < argc)
+			{
+				StatsLog = fopen(argv[++i], "w");
+				if (StatsLog == NULL)
+					fprintf(stderr, "Failed to create the statistics log %s\n", argv[i]);
+			}
+			else if (strcmp(argv[i], "--frame-time-log") == 0 && i + 1 < argc)
+			{
+				if (!StatsOpenFrameTimeLog(argv[++i]))
+					fprintf(stderr, "Failed to create the frame time log %s\n", argv[i]);
+			}
+			else if (strcmp(argv[i], "--ppu-dump") == 0 && i + 2 < argc)
+			{
+				if (!ppu_dump_open(argv[i + 2], strtoul(argv[i + 1], NULL, 10)))
+					fprintf(stderr, "Failed to create the PPU state dump %s\n", argv[i + 2]);
+				i += 2;
+			}
+			else
+				fprintf(stderr, "Ignoring unknown option: %s\n", argv[i]);
+		}
+
 		if(load_gamepak(argv[1]) == -1)
 		{
 			if (errno != 0)
@@ -241,6 +332,21 @@ int main(int argc, char *argv[])
 #endif
 
     init_cpu(ResolveSetting(BootFromBIOS, PerGameBootFromBIOS) /* in port.c */);
+
+		if (PlayPath != NULL && !movie_start_playback(PlayPath))
+			fprintf(stderr, "Failed to play the movie %s\n", PlayPath);
+		else if (PlayPath == NULL && RecordPath != NULL
+		 && !movie_start_recording(RecordPath, true,
+		      ResolveSetting(BootFromBIOS, PerGameBootFromBIOS)))
+			fprintf(stderr, "Failed to record the movie %s\n", RecordPath);
+		if (HashLogPath != NULL && !frame_hash_log_open(HashLogPath))
+			fprintf(stderr, "Failed to create the hash log %s\n", HashLogPath);
+		if (StatsLog != NULL)
+		{
+			fprintf(StatsLog, "frame,rendered,flushes,arm_decoded,thumb_decoded,blocks_recompiled,blocks_reused,accessors_patched\n");
+			PerformanceCounters = 1;
+			StatsSetSnapshotCallback(STATS_LOG_INTERVAL, WriteStatsLog);
+		}
   }
   else
   {
@@ -284,6 +390,7 @@ int main(int argc, char *argv[])
 u32 update_gba()
 {
   IRQ_TYPE irq_raised = IRQ_NONE;
+  StatsEnterFrameTime(FRAME_TIME_OTHER);
   do
   {
     cpu_ticks += execute_cycles;
@@ -376,10 +483,15 @@ u32 update_gba()
             continue;
 
           update_gbc_sound(cpu_ticks);
+          movie_frame_end();
 
 		Stats.EmulatedFrames++;
 		Stats.TotalEmulatedFrames++;
-		ReGBA_RenderScreen();
+		if (!headless_mode)
+			ReGBA_RenderScreen();
+		trace_event(TRACE_EVENT_FRAME_END, Stats.TotalEmulatedFrames,
+			Stats.TotalRenderedFrames, 0);
+		StatsFrameEnd();
 
           update_backup();
 
@@ -419,6 +531,7 @@ u32 update_gba()
     check_timer(2);
     check_timer(3);
   } while(reg[CPU_HALT_STATE] != CPU_ACTIVE);
+  StatsEnterFrameTime(FRAME_TIME_CPU);
   return execute_cycles;
 }
 
@@ -539,6 +652,14 @@ static void quit_common()
 	if(IsGameLoaded)
 		update_backup_force();
 
+	movie_stop();
+	frame_hash_log_close();
+	if (TraceFilePath != NULL && !trace_save(TraceFilePath))
+		fprintf(stderr, "Failed to save the event trace to %s\n", TraceFilePath);
+	if (StatsLog != NULL)
+		fclose(StatsLog);
+	StatsCloseFrameTimeLog();
+	StopPresenter();
 	SDL_Quit();
 }
 
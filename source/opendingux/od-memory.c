@@ -93,7 +93,7 @@ uint8_t* ReGBA_AllocateROM(size_t Size)
 	uint8_t* Result = malloc(Size);
 #if TRACE_MEMORY
 	if (Result != NULL)
-		ReGBA_Trace("I: Allocated space for a %u-byte ROM buffer", Size);
+		ReGBA_Trace("I: Allocated space for a %zu-byte ROM buffer", Size);
 #endif
 	return Result;
 }
@@ -123,7 +123,7 @@ size_t ReGBA_AllocateOnDemandBuffer(void** Buffer)
 	Result = malloc(Size);
 
 #if TRACE_MEMORY
-	ReGBA_Trace("I: Allocated space for a %u-byte on-demand buffer",
+	ReGBA_Trace("I: Allocated space for a %zu-byte on-demand buffer",
 		Size);
 #endif
 
@@ -131,6 +131,133 @@ size_t ReGBA_AllocateOnDemandBuffer(void** Buffer)
 	return Size;
 }
 
+/* Fallback code caches, used if the kernel will not map one where the
+ * emitter can reach it. Untouched pages of these cost no memory. */
+static uint8_t FallbackReadonlyCodeCache[READONLY_CODE_CACHE_SIZE]
+  __attribute__((aligned(32)));
+static uint8_t FallbackWritableCodeCache[WRITABLE_CODE_CACHE_SIZE]
+  __attribute__((aligned(32)));
+
+/*
+ * Returns the size of the kernel's huge pages, or 0 if it doesn't say.
+ */
+static size_t GetHugePageSize(void)
+{
+	size_t Result = 0;
+	char Line[128];
+	FILE* File = fopen("/proc/meminfo", "r");
+	if (File == NULL)
+		return 0;
+	while (fgets(Line, sizeof(Line), File) != NULL)
+	{
+		unsigned long KiB;
+		if (sscanf(Line, "Hugepagesize: %lu kB", &KiB) == 1)
+		{
+			Result = (size_t) KiB * 1024;
+			break;
+		}
+	}
+	fclose(File);
+	return Result;
+}
+
+/*
+ * Determines whether all of the given code cache is in the same 256 MiB
+ * segment as ReGBA's code, so that MIPS J and JAL instructions in it can reach
+ * the core's and the port's native code.
+ */
+static bool IsCodeCacheReachable(const uint8_t* Cache, size_t Size)
+{
+	uintptr_t Segment = (uintptr_t) &ReGBA_AllocateCodeCache & ~UINT32_C(0x0FFFFFFF);
+	return ((uintptr_t) Cache & ~UINT32_C(0x0FFFFFFF)) == Segment
+	    && ((uintptr_t) (Cache + Size - 1) & ~UINT32_C(0x0FFFFFFF)) == Segment;
+}
+
+static uint8_t* MapCodeCache(size_t Size, int Flags)
+{
+	/* Hint at the middle of our segment; the kernel is free to ignore it,
+	 * in which case the caller checks reachability. */
+	void* Hint = (void*) (((uintptr_t) &ReGBA_AllocateCodeCache & ~UINT32_C(0x0FFFFFFF))
+		+ UINT32_C(0x08000000));
+	uint8_t* Result = mmap(Hint, Size,
+		PROT_READ | PROT_WRITE | PROT_EXEC,
+		MAP_PRIVATE | MAP_ANONYMOUS | Flags,
+		-1, 0);
+	if (Result == MAP_FAILED)
+		return NULL;
+	if (!IsCodeCacheReachable(Result, Size))
+	{
+		munmap(Result, Size);
+		return NULL;
+	}
+	return Result;
+}
+
+uint8_t* ReGBA_AllocateCodeCache(TRANSLATION_REGION_TYPE Region, size_t* Size)
+{
+	/* The sizes in port.h can be overridden, in KiB, from the environment:
+	 * larger for games that flush their caches often, smaller for devices
+	 * that are short on memory. */
+	const char* Override = getenv(Region == TRANSLATION_REGION_READONLY
+		? "REGBA_READONLY_CODE_CACHE_KIB"
+		: "REGBA_WRITABLE_CODE_CACHE_KIB");
+	if (Override != NULL)
+	{
+		unsigned long KiB = strtoul(Override, NULL, 10);
+		if ((size_t) KiB * 1024 > TRANSLATION_CACHE_LIMIT_THRESHOLD * 2)
+			*Size = (size_t) KiB * 1024;
+	}
+
+	uint8_t* Result = NULL;
+	size_t HugePageSize = GetHugePageSize();
+#ifdef MAP_HUGETLB
+	/* Explicit huge pages first, if the administrator has reserved some. */
+	if (HugePageSize != 0)
+	{
+		size_t HugeSize = (*Size + HugePageSize - 1) & ~(HugePageSize - 1);
+		Result = MapCodeCache(HugeSize, MAP_HUGETLB);
+		if (Result != NULL)
+		{
+			*Size = HugeSize;
+#  if TRACE_MEMORY
+			ReGBA_Trace("I: Mapped a %zu-byte code cache in huge pages", *Size);
+#  endif
+			return Result;
+		}
+	}
+#endif
+	Result = MapCodeCache(*Size, 0);
+	if (Result != NULL)
+	{
+#ifdef MADV_HUGEPAGE
+		/* Then transparent huge pages, if the kernel has them. */
+		if (HugePageSize != 0)
+			madvise(Result, *Size, MADV_HUGEPAGE);
+#endif
+#if TRACE_MEMORY
+		ReGBA_Trace("I: Mapped a %zu-byte code cache", *Size);
+#endif
+		return Result;
+	}
+
+	switch (Region)
+	{
+		case TRANSLATION_REGION_READONLY:
+			*Size = sizeof(FallbackReadonlyCodeCache);
+			Result = FallbackReadonlyCodeCache;
+			break;
+		case TRANSLATION_REGION_WRITABLE:
+		default:
+			*Size = sizeof(FallbackWritableCodeCache);
+			Result = FallbackWritableCodeCache;
+			break;
+	}
+#if TRACE_MEMORY
+	ReGBA_Trace("I: Using the static %zu-byte code cache", *Size);
+#endif
+	return Result;
+}
+
 void ReGBA_DeallocateROM(void* Buffer)
 {
 	free(Buffer);
@@ -31,6 +31,11 @@ static inline void RenderSample(int16_t* Left, int16_t* Right)
 
 void feed_buffer(void *udata, Uint8 *buffer, int len)
 {
+	// In headless mode, update_gbc_sound consumes the sound itself; see
+	// hash_sound_output.
+	if (headless_mode)
+		return;
+
 	s16* stream = (s16*) buffer;
 	u32 Samples = ReGBA_GetAudioSamplesAvailable() / OUTPUT_FREQUENCY_DIVISOR;
 	u32 Requested = len / (2 * sizeof(s16));
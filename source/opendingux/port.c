@@ -82,6 +82,59 @@ timespec TimeDifference(timespec Past, timespec Present)
 	return Result;
 }
 
+static const char* FrameTimeNames[FRAME_TIME_COUNT] = {
+	"CPU", "JIT", "PPU", "APU", "Out", "Idle", "Misc"
+};
+
+static const uint16_t FrameTimeColors[FRAME_TIME_COUNT] = {
+	RGB888_TO_RGB565(255, 255, 255),
+	RGB888_TO_RGB565(255, 128,   0),
+	RGB888_TO_RGB565(  0, 255,   0),
+	RGB888_TO_RGB565(  0, 192, 255),
+	RGB888_TO_RGB565(255, 255,   0),
+	RGB888_TO_RGB565(128, 128, 128),
+	RGB888_TO_RGB565(255,   0, 255)
+};
+
+static void DisplayFrameTimeLine(uint32_t Line, const char* Name,
+	uint64_t Nanoseconds, uint16_t Color)
+{
+	char line[64];
+	uint32_t LineHeight = GetRenderedHeight(" ") + 1;
+	uint32_t Microseconds = (uint32_t) (Nanoseconds / 1000);
+	uint32_t BarLength = (Microseconds + 500) / 1000;
+	int Length = sprintf(line, "%-4s %2u.%03u ", Name,
+		Microseconds / 1000, Microseconds % 1000);
+	if (BarLength > 30)
+		BarLength = 30;
+	memset(&line[Length], '|', BarLength);
+	line[Length + BarLength] = '\0';
+	PrintStringOutline(line, Color, RGB888_TO_RGB565(0, 0, 0), OutputSurface->pixels, OutputSurface->pitch, 7, 3 + LineHeight * Line, OutputSurface->w - 14, LineHeight, LEFT, TOP);
+}
+
+/*
+ * Draws one line per FrameTimeCategory in the upper-left corner, with the
+ * time spent in it during the last frame and a bar with one '|' per
+ * millisecond. A frame lasts about 16.7 milliseconds at 59.73 FPS.
+ * With the presenter thread, FRAME_TIME_PRESENT is only the copy of the
+ * frame for that thread, so it is shown as "Copy", and the thread's own
+ * time is shown as "Out" on a last line.
+ */
+static void DisplayFrameTime(void)
+{
+	bool Presenter = IsPresenterRunning();
+	uint32_t i;
+
+	ScaleModeUnapplied();
+	for (i = 0; i < FRAME_TIME_COUNT; i++)
+		DisplayFrameTimeLine(i,
+			(Presenter && i == FRAME_TIME_PRESENT) ? "Copy" : FrameTimeNames[i],
+			Stats.FrameTime[i], FrameTimeColors[i]);
+	if (Presenter)
+		DisplayFrameTimeLine(FRAME_TIME_COUNT, FrameTimeNames[FRAME_TIME_PRESENT],
+			Stats.PresenterFrameTime, FrameTimeColors[FRAME_TIME_PRESENT]);
+}
+
 void ReGBA_DisplayFPS(void)
 {
 	u32 Visible = ResolveSetting(ShowFPS, PerGameShowFPS);
@@ -117,6 +170,16 @@ void ReGBA_DisplayFPS(void)
 		ScaleModeUnapplied();
 		PrintStringOutline(line, RGB888_TO_RGB565(255, 255, 255), RGB888_TO_RGB565(0, 0, 0), OutputSurface->pixels, OutputSurface->pitch, 7, 3, OutputSurface->w - 14, OutputSurface->h - 6, LEFT, BOTTOM);
 	}
+
+	if (FrameTiming)
+		DisplayFrameTime();
+}
+
+uint64_t ReGBA_GetMonotonicTime(void)
+{
+	timespec Now;
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return (uint64_t) Now.tv_sec * 1000000000 + Now.tv_nsec;
 }
 
 void ReGBA_LoadRTCTime(struct ReGBA_RTC* RTCData)
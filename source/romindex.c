@@ -0,0 +1,407 @@
+/* ROM directory index for ReGBA
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <sys/stat.h>
+#include <time.h>
+
+#include "common.h"
+#include "romindex.h"
+
+/*
+ * An index file is made of ROM_INDEX_MAGIC, then a uint32_t saying how many
+ * entries follow, then for each entry a struct RomIndexRecord followed by
+ * NameLength bytes of the name, without a terminating '\0'. Entries are
+ * sorted by name. All fields are in the byte order of the emulator.
+ */
+#define ROM_INDEX_MAGIC "ReGBAIx1"
+
+struct RomIndexRecord {
+	uint32_t Size;
+	uint32_t ModifiedTime;
+	uint32_t LastPlayed;
+	char     Title[12];
+	char     Code[4];
+	char     Maker[2];
+	uint8_t  Version;
+	uint8_t  Checksum;
+	uint8_t  Flags;
+	uint8_t  Reserved;
+	uint16_t NameLength;
+} __attribute__((packed));
+
+// The part of the GBA header that is indexed, from the title at 0xA0 to the
+// header checksum at 0xBD.
+#define GBA_HEADER_START 0xA0
+#define GBA_HEADER_SIZE  0x1E
+
+static int CompareNames(const char* A, const char* B)
+{
+	int Result = strcasecmp(A, B);
+	return Result != 0 ? Result : strcmp(A, B);
+}
+
+static int EntrySort(const void* A, const void* B)
+{
+	return CompareNames(((const struct RomIndexEntry*) A)->Name,
+	                    ((const struct RomIndexEntry*) B)->Name);
+}
+
+static void GetIndexPath(char* Result, const char* Directory)
+{
+	snprintf(Result, MAX_PATH, "%s/%s", Directory, ROM_INDEX_FILE_NAME);
+}
+
+static void SetHeader(struct RomIndexEntry* Entry, const uint8_t* Header)
+{
+	memcpy(Entry->Title, Header + 0xA0 - GBA_HEADER_START, 12);
+	memcpy(Entry->Code, Header + 0xAC - GBA_HEADER_START, 4);
+	memcpy(Entry->Maker, Header + 0xB0 - GBA_HEADER_START, 2);
+	Entry->Title[12] = '\0';
+	Entry->Code[4] = '\0';
+	Entry->Maker[2] = '\0';
+	Entry->Version = Header[0xBC - GBA_HEADER_START];
+	Entry->Checksum = Header[0xBD - GBA_HEADER_START];
+	Entry->Flags |= ROM_INDEX_HEADER_VALID;
+}
+
+/*
+ * Reads the header of a ROM into its entry. ROMs in .zip files are left
+ * without a header, because that would require decompressing them.
+ */
+static void ReadHeader(const char* Directory, struct RomIndexEntry* Entry)
+{
+	char Path[MAX_PATH];
+	uint8_t Header[GBA_HEADER_SIZE];
+	uint8_t Magic[4];
+	FILE_TAG_TYPE fd;
+
+	Entry->Flags &= ~ROM_INDEX_HEADER_VALID;
+	Entry->Title[0] = Entry->Code[0] = Entry->Maker[0] = '\0';
+	Entry->Version = Entry->Checksum = 0;
+
+	snprintf(Path, MAX_PATH, "%s/%s", Directory, Entry->Name);
+	FILE_OPEN(fd, Path, READ);
+	if (!FILE_CHECK_VALID(fd))
+		return;
+
+	if (FILE_READ(fd, Magic, 4) == 4
+	 && !(Magic[0] == 0x50 && Magic[1] == 0x4B && Magic[2] == 0x03 && Magic[3] == 0x04)
+	 && FILE_SEEK(fd, GBA_HEADER_START, SEEK_SET) == 0
+	 && FILE_READ(fd, Header, GBA_HEADER_SIZE) == GBA_HEADER_SIZE)
+		SetHeader(Entry, Header);
+
+	FILE_CLOSE(fd);
+}
+
+static bool Reserve(struct RomIndex* Index, size_t Capacity)
+{
+	struct RomIndexEntry* NewEntries;
+
+	if (Capacity <= Index->Capacity)
+		return true;
+	if (Capacity < Index->Capacity * 2)
+		Capacity = Index->Capacity * 2;
+	if (Capacity < 16)
+		Capacity = 16;
+
+	NewEntries = realloc(Index->Entries, Capacity * sizeof(struct RomIndexEntry));
+	if (NewEntries == NULL)
+		return false;
+	Index->Entries = NewEntries;
+	Index->Capacity = Capacity;
+	return true;
+}
+
+static void ParseIndex(struct RomIndex* Index, const uint8_t* Data, size_t Size)
+{
+	uint32_t Count, i;
+	size_t Offset = 12;
+
+	if (Size < 12 || memcmp(Data, ROM_INDEX_MAGIC, 8) != 0)
+		return;
+	memcpy(&Count, Data + 8, sizeof(Count));
+	if (Count > (Size - Offset) / sizeof(struct RomIndexRecord)
+	 || !Reserve(Index, Count))
+		return;
+
+	for (i = 0; i < Count; i++)
+	{
+		struct RomIndexRecord Record;
+		struct RomIndexEntry* Entry = &Index->Entries[Index->Count];
+
+		if (Size - Offset < sizeof(Record))
+			break;
+		memcpy(&Record, Data + Offset, sizeof(Record));
+		Offset += sizeof(Record);
+		if (Size - Offset < Record.NameLength)
+			break;
+
+		Entry->Name = malloc(Record.NameLength + 1);
+		if (Entry->Name == NULL)
+			break;
+		memcpy(Entry->Name, Data + Offset, Record.NameLength);
+		Entry->Name[Record.NameLength] = '\0';
+		Offset += Record.NameLength;
+
+		Entry->Size = Record.Size;
+		Entry->ModifiedTime = Record.ModifiedTime;
+		Entry->LastPlayed = Record.LastPlayed;
+		memcpy(Entry->Title, Record.Title, 12);
+		memcpy(Entry->Code, Record.Code, 4);
+		memcpy(Entry->Maker, Record.Maker, 2);
+		Entry->Title[12] = '\0';
+		Entry->Code[4] = '\0';
+		Entry->Maker[2] = '\0';
+		Entry->Version = Record.Version;
+		Entry->Checksum = Record.Checksum;
+		Entry->Flags = Record.Flags;
+		Entry->Seen = false;
+		Index->Count++;
+	}
+
+	// Whatever was read is in the order it was written in, which is sorted.
+	Index->Sorted = Index->Count;
+	// If the file was cut short, write it again in full.
+	Index->Dirty = Index->Count != Count;
+}
+
+void rom_index_load(struct RomIndex* Index, const char* Directory)
+{
+	char Path[MAX_PATH];
+	FILE_TAG_TYPE fd;
+	uint8_t* Data;
+	long Size;
+
+	memset(Index, 0, sizeof(struct RomIndex));
+	strncpy(Index->Directory, Directory, MAX_PATH - 1);
+
+	GetIndexPath(Path, Directory);
+	FILE_OPEN(fd, Path, READ);
+	if (!FILE_CHECK_VALID(fd))
+		return;
+
+	// Read the whole index at once; many small reads are slow on SD cards.
+	FILE_SEEK(fd, 0, SEEK_END);
+	Size = FILE_TELL(fd);
+	FILE_SEEK(fd, 0, SEEK_SET);
+
+	if (Size > 0 && (Data = malloc(Size)) != NULL)
+	{
+		if (FILE_READ(fd, Data, Size) == (size_t) Size)
+			ParseIndex(Index, Data, Size);
+		free(Data);
+	}
+	FILE_CLOSE(fd);
+}
+
+struct RomIndexEntry* rom_index_update(struct RomIndex* Index,
+	const char* Name, uint32_t Size, uint32_t ModifiedTime)
+{
+	struct RomIndexEntry* Entry = NULL;
+	size_t Low = 0, High = Index->Sorted;
+
+	// Entries added since the last sort need not be searched, because a
+	// directory contains each name only once.
+	while (Low < High)
+	{
+		size_t Middle = Low + (High - Low) / 2;
+		int Comparison = CompareNames(Name, Index->Entries[Middle].Name);
+		if (Comparison == 0)
+		{
+			Entry = &Index->Entries[Middle];
+			break;
+		}
+		else if (Comparison < 0)
+			High = Middle;
+		else
+			Low = Middle + 1;
+	}
+
+	if (Entry == NULL)
+	{
+		char* NameCopy;
+
+		if (!Reserve(Index, Index->Count + 1)
+		 || (NameCopy = strdup(Name)) == NULL)
+			return NULL;
+		Entry = &Index->Entries[Index->Count++];
+		memset(Entry, 0, sizeof(struct RomIndexEntry));
+		Entry->Name = NameCopy;
+	}
+	else if (Entry->Size == Size && Entry->ModifiedTime == ModifiedTime)
+	{
+		Entry->Seen = true;
+		return Entry;
+	}
+
+	Entry->Size = Size;
+	Entry->ModifiedTime = ModifiedTime;
+	Entry->Seen = true;
+	ReadHeader(Index->Directory, Entry);
+	Index->Dirty = true;
+	return Entry;
+}
+
+static bool SaveIndex(const struct RomIndex* Index)
+{
+	char Path[MAX_PATH];
+	FILE_TAG_TYPE fd;
+	uint32_t Count = Index->Count;
+	size_t i;
+	bool Result;
+
+	GetIndexPath(Path, Index->Directory);
+	FILE_OPEN(fd, Path, WRITE);
+	if (!FILE_CHECK_VALID(fd))
+		return false;
+
+	Result = FILE_WRITE(fd, ROM_INDEX_MAGIC, 8) == 8
+	      && FILE_WRITE(fd, &Count, sizeof(Count)) == sizeof(Count);
+
+	for (i = 0; Result && i < Index->Count; i++)
+	{
+		const struct RomIndexEntry* Entry = &Index->Entries[i];
+		struct RomIndexRecord Record;
+
+		memset(&Record, 0, sizeof(Record));
+		Record.Size = Entry->Size;
+		Record.ModifiedTime = Entry->ModifiedTime;
+		Record.LastPlayed = Entry->LastPlayed;
+		memcpy(Record.Title, Entry->Title, 12);
+		memcpy(Record.Code, Entry->Code, 4);
+		memcpy(Record.Maker, Entry->Maker, 2);
+		Record.Version = Entry->Version;
+		Record.Checksum = Entry->Checksum;
+		Record.Flags = Entry->Flags;
+		Record.NameLength = strlen(Entry->Name);
+
+		Result = FILE_WRITE(fd, &Record, sizeof(Record)) == sizeof(Record)
+		      && FILE_WRITE(fd, Entry->Name, Record.NameLength) == Record.NameLength;
+	}
+
+	FILE_CLOSE(fd);
+	if (!Result)
+		FILE_DELETE(Path);
+	return Result;
+}
+
+bool rom_index_finish(struct RomIndex* Index)
+{
+	size_t Read, Write = 0, Sorted = 0;
+
+	// Drop the entries of ROMs that are gone, keeping the others in order.
+	for (Read = 0; Read < Index->Count; Read++)
+	{
+		if (Index->Entries[Read].Seen)
+		{
+			if (Read < Index->Sorted)
+				Sorted++;
+			Index->Entries[Write++] = Index->Entries[Read];
+		}
+		else
+			free(Index->Entries[Read].Name);
+	}
+	if (Write != Index->Count)
+		Index->Dirty = true;
+	Index->Count = Write;
+	Index->Sorted = Sorted;
+
+	// Sort the new entries, then merge them into the sorted ones.
+	if (Index->Sorted < Index->Count)
+	{
+		qsort(&Index->Entries[Index->Sorted], Index->Count - Index->Sorted,
+			sizeof(struct RomIndexEntry), EntrySort);
+
+		if (Index->Sorted > 0)
+		{
+			struct RomIndexEntry* Merged = malloc(Index->Count * sizeof(struct RomIndexEntry));
+			size_t Old = 0, New = Index->Sorted, Out = 0;
+
+			if (Merged == NULL)
+				return false;
+			while (Old < Index->Sorted && New < Index->Count)
+			{
+				if (EntrySort(&Index->Entries[Old], &Index->Entries[New]) <= 0)
+					Merged[Out++] = Index->Entries[Old++];
+				else
+					Merged[Out++] = Index->Entries[New++];
+			}
+			while (Old < Index->Sorted)
+				Merged[Out++] = Index->Entries[Old++];
+			while (New < Index->Count)
+				Merged[Out++] = Index->Entries[New++];
+
+			memcpy(Index->Entries, Merged, Index->Count * sizeof(struct RomIndexEntry));
+			free(Merged);
+		}
+		Index->Sorted = Index->Count;
+	}
+
+	if (Index->Dirty)
+	{
+		if (!SaveIndex(Index))
+			ReGBA_Trace("W: Failed to write the ROM index of %s", Index->Directory);
+		Index->Dirty = false;
+	}
+	return true;
+}
+
+void rom_index_free(struct RomIndex* Index)
+{
+	size_t i;
+	for (i = 0; i < Index->Count; i++)
+		free(Index->Entries[i].Name);
+	free(Index->Entries);
+	Index->Entries = NULL;
+	Index->Count = Index->Sorted = Index->Capacity = 0;
+}
+
+void rom_index_note_played(const char* Path)
+{
+	char Directory[MAX_PATH];
+	const char* Slash = strrchr(Path, '/');
+	struct RomIndex Index;
+	struct RomIndexEntry* Entry;
+	struct stat st;
+	size_t i;
+
+	if (Slash == NULL || Slash - Path >= MAX_PATH || stat(Path, &st) != 0)
+		return;
+	memcpy(Directory, Path, Slash - Path);
+	Directory[Slash - Path] = '\0';
+
+	rom_index_load(&Index, Directory);
+	// Only one ROM is looked at, so keep the others.
+	for (i = 0; i < Index.Count; i++)
+		Index.Entries[i].Seen = true;
+
+	Entry = rom_index_update(&Index, Slash + 1, st.st_size, st.st_mtime);
+	if (Entry != NULL)
+	{
+		// The header is known now, even if the ROM was in a .zip file.
+		memcpy(Entry->Title, gamepak_title, sizeof(Entry->Title));
+		memcpy(Entry->Code, gamepak_code, sizeof(Entry->Code));
+		memcpy(Entry->Maker, gamepak_maker, sizeof(Entry->Maker));
+		Entry->Version = gamepak_rom[0xBC];
+		Entry->Checksum = gamepak_rom[0xBD];
+		Entry->Flags |= ROM_INDEX_HEADER_VALID;
+		Entry->LastPlayed = time(NULL);
+		Index.Dirty = true;
+		rom_index_finish(&Index);
+	}
+	rom_index_free(&Index);
+}
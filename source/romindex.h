@@ -0,0 +1,104 @@
+/* ROM directory index for ReGBA
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef ROMINDEX_H
+#define ROMINDEX_H
+
+/*
+ * A ROM index remembers, for each ROM in a directory, what a file selector
+ * would otherwise have to find out every time it opens the directory: the
+ * header of the ROM and where it sorts among the others. It is kept in the
+ * directory itself, in a file named ROM_INDEX_FILE_NAME.
+ *
+ * The file selector still reads the directory to see which ROMs are there.
+ * For each one, rom_index_update finds its entry, re-reading the ROM header
+ * only if the ROM's size or modification time changed since it was indexed.
+ * rom_index_finish then drops the entries for ROMs that are gone and sorts
+ * the new ones into the rest, so a directory that did not change is not
+ * sorted again.
+ */
+
+#define ROM_INDEX_FILE_NAME "regba.idx"
+
+/* The GBA header fields below were read from the ROM. They are not for ROMs
+ * in .zip files until they are first played. */
+#define ROM_INDEX_HEADER_VALID 0x01
+
+struct RomIndexEntry {
+	char*    Name;            /* File name, without the directory */
+	uint32_t Size;            /* Size of the file, in bytes */
+	uint32_t ModifiedTime;    /* Modification time of the file, time_t */
+	uint32_t LastPlayed;      /* time_t; 0 if never played */
+	char     Title[13];       /* GBA header at 0xA0 */
+	char     Code[5];         /* GBA header at 0xAC */
+	char     Maker[3];        /* GBA header at 0xB0 */
+	uint8_t  Version;         /* GBA header at 0xBC */
+	uint8_t  Checksum;        /* GBA header at 0xBD */
+	uint8_t  Flags;           /* ROM_INDEX_* */
+	bool     Seen;            /* Found by this scan of the directory */
+};
+
+struct RomIndex {
+	char                  Directory[MAX_PATH];
+	struct RomIndexEntry* Entries;
+	/* Entries[0 .. Sorted - 1] are sorted by name, ignoring case. The others
+	 * were added by rom_index_update since the index was last sorted. */
+	size_t                Count;
+	size_t                Sorted;
+	size_t                Capacity;
+	/* Must the index be written back to its file? */
+	bool                  Dirty;
+};
+
+/*
+ * Reads the index of the given directory. If there is no index yet, or it
+ * cannot be read, the index starts out empty.
+ */
+extern void rom_index_load(struct RomIndex* Index, const char* Directory);
+
+/*
+ * Marks the ROM with the given name as being in the directory, adding or
+ * refreshing its entry if needed.
+ * Input:
+ *   Name: The name of the ROM, without the directory.
+ *   Size, ModifiedTime: From stat() on the ROM.
+ * Returns:
+ *   The entry of the ROM, which is valid until the next call to a function
+ *   in this file, or NULL if memory ran out.
+ */
+extern struct RomIndexEntry* rom_index_update(struct RomIndex* Index,
+	const char* Name, uint32_t Size, uint32_t ModifiedTime);
+
+/*
+ * Removes the entries of ROMs that rom_index_update was not called for since
+ * the index was loaded, sorts the index and writes it back to its file if it
+ * changed. After this, Entries[0 .. Count - 1] are sorted by name.
+ * Returns:
+ *   false if memory ran out while sorting; true otherwise, even if the index
+ *   could not be written, as is the case on read-only media.
+ */
+extern bool rom_index_finish(struct RomIndex* Index);
+
+extern void rom_index_free(struct RomIndex* Index);
+
+/*
+ * Records that the ROM at the given path was just loaded, along with its
+ * header, which is now known even for ROMs in .zip files.
+ */
+extern void rom_index_note_played(const char* Path);
+
+#endif /* ROMINDEX_H */
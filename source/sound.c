@@ -174,6 +174,9 @@
   GBC_SOUND_RENDER_SAMPLE_RIGHT();                                            \
   GBC_SOUND_RENDER_SAMPLE_LEFT()                                              \
 
+// Headless mode: only the length, envelope and sweep counters run
+#define GBC_SOUND_RENDER_SAMPLE_NULL()                                        \
+
 #define GBC_SOUND_RENDER_SAMPLES(type, sample_length, envelope_op, sweep_op)  \
   for(i = 0; i < buffer_ticks; i++)                                           \
   {                                                                           \
@@ -213,6 +216,11 @@
     UPDATE_TONE_COUNTERS(envelope_op, sweep_op);                              \
   }                                                                           \
 
+// Headless mode does not mix sound, unless it is hashed for the frame hash
+// log; regression runs compare those hashes.
+#define SOUND_MIXING_SKIPPED()                                                \
+  (headless_mode && !sound_output_hashing)
+
 #define GBC_SOUND_RENDER_CHANNEL(type, sample_length, envelope_op, sweep_op)  \
   sound_write_offset = gbc_sound_buffer_index;                                \
   sample_index = gs->sample_index;                                            \
@@ -221,6 +229,15 @@
                                                                               \
   UPDATE_VOLUME(envelope_op);                                                 \
                                                                               \
+  if(SOUND_MIXING_SKIPPED())                                                  \
+  {                                                                           \
+    if(gs->status != GBC_SOUND_INACTIVE)                                      \
+    {                                                                         \
+      GBC_SOUND_RENDER_##type(NULL, sample_length, envelope_op, sweep_op);    \
+    }                                                                         \
+  }                                                                           \
+  else                                                                        \
+                                                                              \
   switch(gs->status)                                                          \
   {                                                                           \
     case GBC_SOUND_INACTIVE:                                                  \
@@ -319,7 +336,8 @@ void sound_timer(FIXED16_16 frequency_step, uint32_t channel)
     ds->fifo_base = (ds->fifo_base + 1) % 32;
     next_sample = ds->fifo[ds->fifo_base] << 4;
 
-    if (sound_on == 1)
+    // In headless mode, only consume the FIFO; it still requests DMA below.
+    if (sound_on == 1 && !SOUND_MIXING_SKIPPED())
     {
       if (ds->volume == DIRECT_SOUND_VOLUME_50)
       {
@@ -365,10 +383,10 @@ void sound_timer(FIXED16_16 frequency_step, uint32_t channel)
       if (fifo_length <= 16)
       {
         if (dma[1].direct_sound_channel == channel)
-          dma_transfer(dma + 1);
+          dma_transfer_sound(dma + 1);
 
         if (dma[2].direct_sound_channel == channel)
-          dma_transfer(dma + 2);
+          dma_transfer_sound(dma + 2);
       }
   }
 
@@ -443,6 +461,31 @@ uint32_t gbc_sound_master_volume_left;
 uint32_t gbc_sound_master_volume_right;
 uint32_t gbc_sound_master_volume;
 
+// Running CRC-32 of the samples that update_gbc_sound completes, for the
+// frame hash log in movie.c. Samples up to gbc_sound_buffer_index can be
+// consumed (and zeroed) by the audio output at any time, so they're hashed
+// just before it moves past them.
+//
+// Headless mode still mixes while hashing, so that the hashes cover the
+// sound. There is no audio output then, so the hashed samples are zeroed
+// here instead, as the output would, before the ring comes back to them.
+uint32_t sound_output_hashing = 0;
+uint32_t sound_output_crc = 0;
+
+static void hash_sound_output(uint32_t start, uint32_t count)
+  {
+    if (start + count > BUFFER_SIZE)
+    {
+      hash_sound_output(start, BUFFER_SIZE - start);
+      count -= BUFFER_SIZE - start;
+      start = 0;
+    }
+    sound_output_crc = crc32(sound_output_crc,
+      (const Bytef *) &sound_buffer[start], count * sizeof(int16_t));
+    if (headless_mode)
+      memset(&sound_buffer[start], 0, count * sizeof(int16_t));
+  }
+
 void update_gbc_sound(uint32_t cpu_ticks)
   {
     // TODO 実数部のビット数を多くした方がいい？
@@ -459,6 +502,8 @@ void update_gbc_sound(uint32_t cpu_ticks)
     int8_t *sample_data;
     int8_t *wave_bank;
     uint8_t *wave_ram = ((uint8_t *)io_registers) + 0x90;
+    enum FrameTimeCategory previous_time_category =
+      StatsEnterFrameTime(FRAME_TIME_AUDIO);
 
     gbc_sound_partial_ticks += FP16_16_FRACTIONAL_PART(buffer_ticks);
     buffer_ticks = FP16_16_TO_U32(buffer_ticks);
@@ -537,6 +582,10 @@ void update_gbc_sound(uint32_t cpu_ticks)
     ADDRESS16(io_registers, 0x84) = sound_status;
 
     gbc_sound_last_cpu_ticks = cpu_ticks;
+
+    if (sound_output_hashing)
+      hash_sound_output(gbc_sound_buffer_index, buffer_ticks << 1);
+
     // サウンドタイミングの調整
     gbc_sound_buffer_index =(gbc_sound_buffer_index + (buffer_ticks << 1)) & BUFFER_SIZE_MASK;
 
@@ -561,6 +610,8 @@ void update_gbc_sound(uint32_t cpu_ticks)
 			direct_sound_channel[i].buffer_index = gbc_sound_buffer_index;
 		}
 	}
+
+    StatsEnterFrameTime(previous_time_category);
   }
 
 void init_sound()
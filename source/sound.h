@@ -317,6 +317,9 @@ extern uint32_t gbc_sound_wave_volume[4];
 extern uint32_t gbc_sound_buffer_index;
 extern uint32_t gbc_sound_partial_ticks;
 
+extern uint32_t sound_output_hashing;
+extern uint32_t sound_output_crc;
+
 void sound_timer_queue32(uint8_t channel);
 void sound_timer(FIXED16_16 frequency_step, uint32_t channel);
 void sound_reset_fifo(uint32_t channel);
@@ -21,6 +21,24 @@
 
 struct ReGBA_Stats Stats;
 
+#ifdef PERFORMANCE_IMPACTING_STATISTICS
+uint32_t PerformanceCounters = 1;
+#else
+uint32_t PerformanceCounters = 0;
+#endif
+
+uint32_t FrameTiming = 0;
+
+static enum FrameTimeCategory CurrentFrameTimeCategory = FRAME_TIME_CPU;
+static uint64_t FrameTimeCategoryStart;
+static uint64_t FrameTimeAccumulated[FRAME_TIME_COUNT];
+static FILE* FrameTimeLog = NULL;
+static uint32_t FrameTimingStarted = 0;
+
+static uint32_t SnapshotInterval = 0;
+static StatsSnapshotCallback SnapshotCallback = NULL;
+static struct ReGBA_Stats PreviousSnapshot;
+
 void StatsStopFPS(void)
 {
 	Stats.RenderedFPS = -1;
@@ -62,7 +80,6 @@ void StatsInitGame(void)
 	Stats.InSoundBufferUnderrun = 0;
 	Stats.TotalEmulatedFrames = 0;
 	Stats.TotalRenderedFrames = 0;
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 	Stats.ARMOpcodesDecoded = 0;
 	Stats.ThumbOpcodesDecoded = 0;
 	Stats.ThumbROMConstants = 0;
@@ -70,6 +87,110 @@ void StatsInitGame(void)
 	Stats.BlockRecompilationCount = 0;
 	Stats.OpcodeReuseCount = 0;
 	Stats.OpcodeRecompilationCount = 0;
+	uint32_t mode;
+	for (mode = 0; mode < 8; mode++)
+	{
+		Stats.ScanlinesRendered[mode] = 0;
+		Stats.ScanlineRenderTime[mode] = 0;
+		Stats.ScanlineRenderAverage[mode] = 0;
+	}
+	Stats.ScanlinesSkipped = 0;
 	Stats.WrongAddressLineCount = 0;
-#endif
+	memset(&PreviousSnapshot, 0, sizeof(PreviousSnapshot));
+}
+
+enum FrameTimeCategory StatsSwitchFrameTime(enum FrameTimeCategory Category)
+{
+	enum FrameTimeCategory Previous = CurrentFrameTimeCategory;
+	uint64_t Now = ReGBA_GetMonotonicTime();
+	FrameTimeAccumulated[Previous] += Now - FrameTimeCategoryStart;
+	FrameTimeCategoryStart = Now;
+	CurrentFrameTimeCategory = Category;
+	return Previous;
+}
+
+void StatsPauseFrameTime(void)
+{
+	if (FrameTiming)
+		StatsSwitchFrameTime(CurrentFrameTimeCategory);
+}
+
+void StatsResumeFrameTime(void)
+{
+	FrameTimeCategoryStart = ReGBA_GetMonotonicTime();
+}
+
+static void CompleteFrameTime(void)
+{
+	uint32_t i;
+
+	// Close the current category without leaving it.
+	StatsSwitchFrameTime(CurrentFrameTimeCategory);
+
+	memcpy(Stats.FrameTime, FrameTimeAccumulated, sizeof(Stats.FrameTime));
+	memset(FrameTimeAccumulated, 0, sizeof(FrameTimeAccumulated));
+
+	if (FrameTimeLog != NULL)
+	{
+		fprintf(FrameTimeLog, "%" PRIu64, Stats.TotalEmulatedFrames);
+		for (i = 0; i < FRAME_TIME_COUNT; i++)
+			fprintf(FrameTimeLog, ",%" PRIu64, Stats.FrameTime[i]);
+		fprintf(FrameTimeLog, ",%" PRIu64 "\n", Stats.PresenterFrameTime);
+	}
+}
+
+bool StatsOpenFrameTimeLog(const char* Filename)
+{
+	StatsCloseFrameTimeLog();
+
+	FrameTimeLog = fopen(Filename, "w");
+	if (FrameTimeLog == NULL)
+		return false;
+
+	fprintf(FrameTimeLog, "frame,cpu_ns,translation_ns,ppu_ns,audio_ns,present_ns,idle_ns,other_ns,presenter_ns\n");
+	FrameTiming = 1;
+	return true;
+}
+
+void StatsCloseFrameTimeLog(void)
+{
+	if (FrameTimeLog != NULL)
+	{
+		fclose(FrameTimeLog);
+		FrameTimeLog = NULL;
+	}
+}
+
+void StatsSnapshot(struct ReGBA_Stats* Snapshot)
+{
+	memcpy(Snapshot, &Stats, sizeof(Stats));
+}
+
+void StatsSetSnapshotCallback(uint32_t Interval, StatsSnapshotCallback Callback)
+{
+	SnapshotInterval = Callback != NULL ? Interval : 0;
+	SnapshotCallback = Callback;
+	StatsSnapshot(&PreviousSnapshot);
+}
+
+void StatsFrameEnd(void)
+{
+	if (FrameTiming && FrameTimingStarted)
+		CompleteFrameTime();
+	else if (FrameTiming)
+	{
+		// Frame timing was just turned on. What was accumulated so far
+		// started from a stale time, so start over from this frame.
+		memset(FrameTimeAccumulated, 0, sizeof(FrameTimeAccumulated));
+		FrameTimeCategoryStart = ReGBA_GetMonotonicTime();
+	}
+	FrameTimingStarted = FrameTiming;
+
+	if (SnapshotInterval != 0 && Stats.TotalEmulatedFrames % SnapshotInterval == 0)
+	{
+		struct ReGBA_Stats Current;
+		StatsSnapshot(&Current);
+		SnapshotCallback(&Current, &PreviousSnapshot);
+		PreviousSnapshot = Current;
+	}
 }
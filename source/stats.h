@@ -9,15 +9,34 @@
 
 #include "common.h"
 
+/*
+ * Where the time of each frame goes, for the frame timing breakdown. Time is
+ * attributed to the current category until StatsEnterFrameTime switches to
+ * another.
+ */
+enum FrameTimeCategory {
+	FRAME_TIME_NONE = -1,   /* Returned by StatsEnterFrameTime while
+	                         * FrameTiming is zero; ignored when given back */
+	FRAME_TIME_CPU,         /* In translated code */
+	FRAME_TIME_TRANSLATION, /* Translating GBA code to native code */
+	FRAME_TIME_PPU,         /* In update_scanline */
+	FRAME_TIME_AUDIO,       /* In update_gbc_sound */
+	FRAME_TIME_PRESENT,     /* Scaling and flipping, or only handing the
+	                         * frame to a presenter thread, whose time is
+	                         * in PresenterFrameTime */
+	FRAME_TIME_IDLE,        /* Waiting for the audio to catch up */
+	FRAME_TIME_OTHER,       /* The rest of update_gba */
+	FRAME_TIME_COUNT
+};
+
 struct ReGBA_Stats {
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 	// This needs to be first, because the assembler code needs it to be
 	// at the address of Stats (and I can't be bothered to change the
 	// structure offset if I move it, so deal with it, ha!). It's also of type
 	// uint32_t, not uint64_t, because the code that updates it is short on
 	// registers. - Neb
+	// It is only updated while PerformanceCounters is non-zero.
 	uint32_t        WrongAddressLineCount;
-#endif
 	/* For FPS display. The first 3 variables are updated by the
 	 * emulation and read by StatsDisplayFPS. The last 2 variables are
 	 * updated and read by StatsDisplayFPS. */
@@ -53,9 +72,9 @@ struct ReGBA_Stats {
 	 * running? */
 	uint64_t        TotalRenderedFrames;
 
-#ifdef PERFORMANCE_IMPACTING_STATISTICS
 	/* Performance statistics collectors. This set impacts normal
-	 * performance of the emulator. */
+	 * performance of the emulator, so it is only updated while
+	 * PerformanceCounters is non-zero. */
 	/* How many times have we had to decode an ARM or a Thumb opcode from
 	 * scratch since the current game started running? */
 	uint64_t        ARMOpcodesDecoded;
@@ -73,8 +92,25 @@ struct ReGBA_Stats {
 	uint64_t        BlockReuseCount;
 	/* And how many opcodes was that? */
 	uint64_t        OpcodeReuseCount;
+	/* How many scanlines have we rendered in each video mode, and how
+	 * many nanoseconds did that take? Lines that did not change since the
+	 * previous frame are not rendered, so they are not counted. */
+	uint64_t        ScanlinesRendered[8];
+	uint64_t        ScanlineRenderTime[8];
+	/* ScanlineRenderTime / ScanlinesRendered, updated every frame. */
+	uint64_t        ScanlineRenderAverage[8];
+	/* How many scanlines were not rendered because they were already in
+	 * the screen buffer as they would have been drawn? */
+	uint64_t        ScanlinesSkipped;
 
-#endif
+	/* How many nanoseconds did the last frame spend in each category?
+	 * Only updated while FrameTiming is non-zero. */
+	uint64_t        FrameTime[FRAME_TIME_COUNT];
+	/* How many nanoseconds did the port's presenter thread, if it has one,
+	 * spend scaling and flipping since the previous frame was handed to
+	 * it? That thread runs alongside the emulation, so this is not part of
+	 * FrameTime. Only updated while FrameTiming is non-zero. */
+	uint64_t        PresenterFrameTime;
 
 	/* Are we in a sound buffer underrun? If we are, ignore underrunning
 	 * until the current underrun is done. */
@@ -83,8 +119,80 @@ struct ReGBA_Stats {
 
 extern struct ReGBA_Stats Stats;
 
+/*
+ * Non-zero if the performance statistics that impact performance are being
+ * collected. The recompiler checks this while translating code, and the
+ * stubs check it before counting, so it can be changed at any time; counts
+ * then only cover the code translated or run while it was set.
+ * It starts out non-zero in builds with PERFORMANCE_IMPACTING_STATISTICS.
+ */
+extern uint32_t PerformanceCounters;
+
+/*
+ * Non-zero if the time spent in each FrameTimeCategory is being measured.
+ * Measuring takes a reading of the monotonic clock at each switch between
+ * categories, so it is off by default.
+ */
+extern uint32_t FrameTiming;
+
+extern enum FrameTimeCategory StatsSwitchFrameTime(enum FrameTimeCategory Category);
+
+/*
+ * Attributes the time from now on to Category, if FrameTiming is non-zero.
+ * Returns:
+ *   The previous category, to be given back to this function when the work
+ *   attributed to Category is done. If FrameTiming was zero, this is
+ *   FRAME_TIME_NONE, which this function ignores, so that turning FrameTiming
+ *   on in the meantime does not attribute the time to the wrong category.
+ */
+static inline enum FrameTimeCategory StatsEnterFrameTime(enum FrameTimeCategory Category)
+{
+	if (likely(!FrameTiming) || Category == FRAME_TIME_NONE)
+		return FRAME_TIME_NONE;
+	return StatsSwitchFrameTime(Category);
+}
+
+/*
+ * Excludes the time between these calls, such as the time spent in the menu,
+ * from the timing breakdown of the current frame.
+ */
+extern void StatsPauseFrameTime(void);
+extern void StatsResumeFrameTime(void);
+
+/*
+ * Starts writing a CSV line for each frame to the given file, with the
+ * nanoseconds spent in each FrameTimeCategory, and turns FrameTiming on.
+ * Returns:
+ *   true if the file could be created; false otherwise.
+ */
+extern bool StatsOpenFrameTimeLog(const char* Filename);
+
+extern void StatsCloseFrameTimeLog(void);
+
 extern void StatsStopFPS(void);
 extern void StatsInit(void);
 extern void StatsInitGame(void);
 
+/*
+ * Copies the current statistics to Snapshot.
+ */
+extern void StatsSnapshot(struct ReGBA_Stats* Snapshot);
+
+/*
+ * Requests that Callback be called every Interval emulated frames with a
+ * snapshot of the statistics and the snapshot given to the previous call
+ * (or, on the first call, the statistics as they were when this function was
+ * called), so that the difference between them can be reported. An Interval
+ * of 0 or a NULL Callback stops the calls.
+ */
+typedef void (*StatsSnapshotCallback) (const struct ReGBA_Stats* Current,
+	const struct ReGBA_Stats* Previous);
+extern void StatsSetSnapshotCallback(uint32_t Interval, StatsSnapshotCallback Callback);
+
+/*
+ * Called by the ports at the end of each emulated frame. This completes the
+ * frame's timing breakdown and calls the snapshot callback if one is due.
+ */
+extern void StatsFrameEnd(void);
+
 #endif // !__GPSP_STATS_H__
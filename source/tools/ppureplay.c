@@ -0,0 +1,415 @@
+/*
+ * Renders PPU state dumps (see ppu_dump_open in video.h) with the emulator's
+ * scanline renderer, times it, and compares the CRC-32 of each frame with
+ * a list of goldens.
+ *
+ * Build on the host with:  make -C tools ppureplay
+ * usage: ./ppureplay [-n RUNS] [-g GOLDENS] [-u] DUMP...
+ *        ./ppureplay -s DIRECTORY
+ *
+ * Each dump is rendered RUNS times (default 1), every line in full, and the
+ * average time per frame is printed with the CRC-32 of the frame. With -g,
+ * the CRC-32 is compared with the line for the dump's file name in GOLDENS,
+ * which holds lines of the form "CRC-32 NAME"; ppureplay exits with 1 if
+ * any differs. With -u, GOLDENS is rewritten with the CRC-32 of every dump
+ * instead.
+ *
+ * -s writes synthetic dumps to DIRECTORY, one for each video mode and for
+ * windows and colour effects, made from random video memory and registers
+ * that change every line. ppugoldens.txt holds their goldens; see the check
+ * target in the Makefile. Dumps saved from games with --ppu-dump can be
+ * added to any list of goldens with -u.
+ *
+ * Dumps must have been saved by a processor of the same byte order as the
+ * host's; every device ReGBA runs on is little-endian.
+ */
+#include "common.h"
+
+#include <stdarg.h>
+#include <time.h>
+#include <zlib.h>
+
+/* What video.c uses from the rest of the emulator. */
+uint16_t palette_ram[0x200];
+uint16_t oam_ram[0x200];
+uint8_t  vram[0x18000];
+uint16_t io_registers[0x4000];
+uint32_t palette_update, oam_update, vram_update;
+uint8_t* g_state_buffer_ptr;
+
+uint16_t* GBAScreen;
+uint32_t  GBAScreenPitch = GBA_SCREEN_WIDTH;
+
+static uint16_t Screen[GBA_SCREEN_WIDTH * GBA_SCREEN_HEIGHT];
+
+bool ReGBA_IsRenderingNextFrame()
+{
+	return true;
+}
+
+void ReGBA_Trace(const char* Format, ...)
+{
+	va_list Args;
+	va_start(Args, Format);
+	vfprintf(stderr, Format, Args);
+	va_end(Args);
+	fputc('\n', stderr);
+}
+
+uint64_t ReGBA_GetMonotonicTime()
+{
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return (uint64_t) Time.tv_sec * 1000000000 + Time.tv_nsec;
+}
+
+struct PPUDump {
+	char Magic[16];
+	uint16_t PaletteRAM[0x200];
+	uint16_t OAMRAM[0x200];
+	uint8_t  VRAM[0x18000];
+	uint16_t IORegisters[0x200];
+	ppu_dump_line_struct Lines[GBA_SCREEN_HEIGHT];
+};
+
+static struct PPUDump Dump;
+
+static bool LoadDump(const char* Path)
+{
+	FILE* File = fopen(Path, "rb");
+	size_t Read;
+	if (File == NULL)
+		return false;
+	Read = fread(&Dump, 1, sizeof(Dump), File);
+	fclose(File);
+	return Read == sizeof(Dump)
+	    && memcmp(Dump.Magic, PPU_DUMP_MAGIC, sizeof(Dump.Magic)) == 0;
+}
+
+static bool SaveDump(const char* Path)
+{
+	FILE* File = fopen(Path, "wb");
+	bool Result;
+	if (File == NULL)
+		return false;
+	Result = fwrite(&Dump, 1, sizeof(Dump), File) == sizeof(Dump);
+	return fclose(File) == 0 && Result;
+}
+
+/* Renders the dump in Dump into Screen. Every line is rendered, even if it
+ * is the same as the last time. */
+static void RenderDump(void)
+{
+	uint32_t Line;
+
+	memcpy(palette_ram, Dump.PaletteRAM, sizeof(palette_ram));
+	memcpy(oam_ram, Dump.OAMRAM, sizeof(oam_ram));
+	memcpy(vram, Dump.VRAM, sizeof(vram));
+	memcpy(io_registers, Dump.IORegisters, sizeof(Dump.IORegisters));
+	palette_update = 1;
+	oam_update = 1;
+	vram_update = 1;
+	invalidate_scanline_records();
+
+	for (Line = 0; Line < GBA_SCREEN_HEIGHT; Line++)
+	{
+		const ppu_dump_line_struct* State = &Dump.Lines[Line];
+		memcpy(affine_reference_x, State->affine_reference_x, sizeof(affine_reference_x));
+		memcpy(affine_reference_y, State->affine_reference_y, sizeof(affine_reference_y));
+		memcpy(io_registers, State->registers, sizeof(State->registers));
+		io_registers[REG_VCOUNT] = Line;
+		update_scanline();
+	}
+}
+
+/* -- Goldens -- */
+
+struct Golden {
+	char Name[256];
+	uint32_t CRC;
+};
+
+#define MAX_GOLDENS 1024
+
+static struct Golden Goldens[MAX_GOLDENS];
+static unsigned int GoldenCount;
+
+static const char* BaseName(const char* Path)
+{
+	const char* Slash = strrchr(Path, '/');
+	return Slash != NULL ? Slash + 1 : Path;
+}
+
+static bool LoadGoldens(const char* Path)
+{
+	char Line[512];
+	FILE* File = fopen(Path, "r");
+	if (File == NULL)
+		return false;
+	while (fgets(Line, sizeof(Line), File) != NULL && GoldenCount < MAX_GOLDENS)
+	{
+		struct Golden* Golden = &Goldens[GoldenCount];
+		if (Line[0] == '#')
+			continue;
+		if (sscanf(Line, "%8x %255s", &Golden->CRC, Golden->Name) == 2)
+			GoldenCount++;
+	}
+	fclose(File);
+	return true;
+}
+
+static struct Golden* FindGolden(const char* Name)
+{
+	unsigned int i;
+	for (i = 0; i < GoldenCount; i++)
+		if (strcmp(Goldens[i].Name, Name) == 0)
+			return &Goldens[i];
+	return NULL;
+}
+
+static bool SaveGoldens(const char* Path)
+{
+	unsigned int i;
+	FILE* File = fopen(Path, "w");
+	if (File == NULL)
+		return false;
+	fprintf(File, "# CRC-32 of the frames rendered from PPU state dumps; see ppureplay.c\n");
+	for (i = 0; i < GoldenCount; i++)
+		fprintf(File, "%08X %s\n", Goldens[i].CRC, Goldens[i].Name);
+	return fclose(File) == 0;
+}
+
+/* -- Synthetic dumps -- */
+
+static uint32_t RandomState;
+
+static uint32_t Random32(void)
+{
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+	return RandomState;
+}
+
+struct Scene {
+	const char* Name;
+	uint16_t DisplayControl;
+	uint16_t BlendControl;  /* its effect bits; the targets are random */
+};
+
+/* OBJ is on in every scene, with 1D mapping. */
+static const struct Scene Scenes[] = {
+	{ "mode0",            0x1F40, 0x0000 },
+	{ "mode0-alpha",      0x1F40, 0x0040 },
+	{ "mode0-brighten",   0x1F40, 0x0080 },
+	{ "mode0-darken",     0x1F40, 0x00C0 },
+	{ "mode0-windows",    0xFF40, 0x0040 },
+	{ "mode1",            0x1741, 0x0000 },
+	{ "mode1-windows",    0xF741, 0x0080 },
+	{ "mode2",            0x1C42, 0x0040 },
+	{ "mode3",            0x1443, 0x0000 },
+	{ "mode3-windows",    0x7443, 0x0040 },
+	{ "mode4",            0x1444, 0x0000 },
+	{ "mode4-frame1",     0x1454, 0x00C0 },
+	{ "mode5",            0x1445, 0x0000 },
+	{ "forced-blank",     0x1FC0, 0x0000 },
+};
+
+#define SCENE_COUNT (sizeof(Scenes) / sizeof(Scenes[0]))
+
+static void MakeScene(const struct Scene* Scene, uint32_t Seed)
+{
+	uint32_t i, Line;
+	int32_t ReferenceX[2], ReferenceY[2];
+	uint16_t Registers[REG_BLDY + 1];
+
+	RandomState = Seed * 2654435761u + 1;
+	memset(&Dump, 0, sizeof(Dump));
+	memcpy(Dump.Magic, PPU_DUMP_MAGIC, sizeof(Dump.Magic));
+
+	for (i = 0; i < 0x200; i++)
+		Dump.PaletteRAM[i] = Random32() & 0x7FFF;
+	for (i = 0; i < 0x200; i++)
+		Dump.OAMRAM[i] = Random32();
+	for (i = 0; i < sizeof(Dump.VRAM); i++)
+		Dump.VRAM[i] = Random32();
+
+	/* The first few sprites are small and on screen; the rest are wherever
+	 * the random bits put them. */
+	for (i = 0; i < 16; i++)
+	{
+		Dump.OAMRAM[i * 4] = (Dump.OAMRAM[i * 4] & 0xFC00 & ~0x0300) | (Random32() % GBA_SCREEN_HEIGHT);
+		Dump.OAMRAM[i * 4 + 1] = (Dump.OAMRAM[i * 4 + 1] & 0xFE00) | (Random32() % GBA_SCREEN_WIDTH);
+	}
+
+	memset(Registers, 0, sizeof(Registers));
+	Registers[REG_DISPCNT] = Scene->DisplayControl;
+	for (i = 0; i < 4; i++)
+	{
+		/* No mosaic. 256-colour tiles at character base 3 would run past
+		 * the end of VRAM, so those use character base 1. */
+		Registers[REG_BG0CNT + i] = Random32() & ~0x0040;
+		if (Registers[REG_BG0CNT + i] & 0x0080)
+			Registers[REG_BG0CNT + i] &= ~0x0008;
+	}
+	for (i = REG_BG2PA; i <= REG_BG3Y_H; i++)
+		Registers[i] = Random32();
+	Registers[REG_BG2PA] = Registers[REG_BG3PA] = 0x100 + (Random32() & 0x7F);
+	Registers[REG_BG2PD] = Registers[REG_BG3PD] = 0x100 - (Random32() & 0x7F);
+	Registers[REG_WININ] = Random32() & 0x3F3F;
+	Registers[REG_WINOUT] = Random32() & 0x3F3F;
+	Registers[REG_BLDCNT] = (Random32() & 0x3F3F) | Scene->BlendControl;
+	Registers[REG_BLDALPHA] = Random32() & 0x1F1F;
+	Registers[REG_BLDY] = Random32() & 0x1F;
+
+	for (i = 0; i < 2; i++)
+	{
+		ReferenceX[i] = (int32_t) (Random32() << 4) >> 12;
+		ReferenceY[i] = (int32_t) (Random32() << 4) >> 12;
+	}
+
+	for (Line = 0; Line < GBA_SCREEN_HEIGHT; Line++)
+	{
+		ppu_dump_line_struct* State = &Dump.Lines[Line];
+
+		/* Scroll the text backgrounds a little every line, and move the
+		 * windows every 32 lines, as raster effects would. */
+		for (i = REG_BG0HOFS; i <= REG_BG3VOFS; i++)
+			Registers[i] += Random32() % 3;
+		if (Line % 32 == 0)
+		{
+			uint32_t Top = Random32() % GBA_SCREEN_HEIGHT, Left = Random32() % GBA_SCREEN_WIDTH;
+			Registers[REG_WIN0H] = (Left << 8) | (Left + Random32() % (GBA_SCREEN_WIDTH - Left + 1));
+			Registers[REG_WIN0V] = (Top << 8) | (Top + Random32() % (GBA_SCREEN_HEIGHT - Top + 1));
+			Registers[REG_WIN1H] = Random32() & 0xFFFF;
+			Registers[REG_WIN1V] = Random32() & 0xFFFF;
+		}
+
+		for (i = 0; i < 2; i++)
+		{
+			State->affine_reference_x[i] = ReferenceX[i];
+			State->affine_reference_y[i] = ReferenceY[i];
+		}
+		ReferenceX[0] += (int16_t) Registers[REG_BG2PB];
+		ReferenceY[0] += (int16_t) Registers[REG_BG2PD];
+		ReferenceX[1] += (int16_t) Registers[REG_BG3PB];
+		ReferenceY[1] += (int16_t) Registers[REG_BG3PD];
+
+		memcpy(State->registers, Registers, sizeof(State->registers));
+	}
+
+	memcpy(Dump.IORegisters, Registers, sizeof(Registers));
+}
+
+static int MakeScenes(const char* Directory)
+{
+	uint32_t i;
+	for (i = 0; i < SCENE_COUNT; i++)
+	{
+		char Path[1024];
+		snprintf(Path, sizeof(Path), "%s/%s.ppu", Directory, Scenes[i].Name);
+		MakeScene(&Scenes[i], i + 1);
+		if (!SaveDump(Path))
+		{
+			fprintf(stderr, "Failed to write %s\n", Path);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	const char* GoldensPath = NULL;
+	unsigned int Runs = 1, Failures = 0;
+	bool Update = false;
+	int i;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++)
+	{
+		if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			return MakeScenes(argv[i + 1]);
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			Runs = strtoul(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+			GoldensPath = argv[++i];
+		else if (strcmp(argv[i], "-u") == 0)
+			Update = true;
+		else
+		{
+			fprintf(stderr, "Unknown option: %s\n", argv[i]);
+			return 2;
+		}
+	}
+
+	if (i == argc || Runs == 0 || (Update && GoldensPath == NULL))
+	{
+		fprintf(stderr, "usage: %s [-n RUNS] [-g GOLDENS] [-u] DUMP...\n"
+		                "       %s -s DIRECTORY\n", argv[0], argv[0]);
+		return 2;
+	}
+
+	if (GoldensPath != NULL && !LoadGoldens(GoldensPath) && !Update)
+	{
+		fprintf(stderr, "Failed to read the goldens %s\n", GoldensPath);
+		return 2;
+	}
+
+	GBAScreen = Screen;
+
+	for (; i < argc; i++)
+	{
+		const char* Name = BaseName(argv[i]);
+		struct Golden* Golden;
+		uint64_t Start;
+		uint32_t CRC;
+		unsigned int Run;
+
+		if (!LoadDump(argv[i]))
+		{
+			printf("%-24s not a PPU state dump\n", Name);
+			Failures++;
+			continue;
+		}
+
+		Start = ReGBA_GetMonotonicTime();
+		for (Run = 0; Run < Runs; Run++)
+			RenderDump();
+		Start = (ReGBA_GetMonotonicTime() - Start) / Runs;
+
+		CRC = crc32(0, (const Bytef*) Screen, sizeof(Screen));
+		printf("%-24s %10llu ns %08X", Name, (unsigned long long) Start, CRC);
+
+		Golden = GoldensPath != NULL ? FindGolden(Name) : NULL;
+		if (Update)
+		{
+			if (Golden == NULL && GoldenCount < MAX_GOLDENS)
+			{
+				Golden = &Goldens[GoldenCount++];
+				snprintf(Golden->Name, sizeof(Golden->Name), "%s", Name);
+			}
+			if (Golden != NULL)
+				Golden->CRC = CRC;
+			printf("\n");
+		}
+		else if (GoldensPath == NULL)
+			printf("\n");
+		else if (Golden == NULL)
+			printf("  no golden\n");
+		else if (Golden->CRC == CRC)
+			printf("  OK\n");
+		else
+		{
+			printf("  FAIL, expected %08X\n", Golden->CRC);
+			Failures++;
+		}
+	}
+
+	if (Update && !SaveGoldens(GoldensPath))
+	{
+		fprintf(stderr, "Failed to write the goldens %s\n", GoldensPath);
+		return 2;
+	}
+
+	return Failures != 0;
+}
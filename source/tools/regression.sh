@@ -0,0 +1,156 @@
+#!/bin/sh
+# Runs a corpus of ROMs through headless ReGBA in parallel, then compares
+# the frame hash logs against a baseline from an earlier build.
+#
+# usage: ./regression.sh [-j JOBS] [-n FRAMES] [-b BASELINE_DIR] [-u]
+#                        CORPUS_DIR OUTPUT_DIR
+#
+# Every ROM in CORPUS_DIR (*.gba, *.bin, *.zip) is run for FRAMES frames
+# (default 3600). If a movie with the same name and the extension .mov sits
+# next to a ROM, it is replayed; otherwise, no keys are pressed. Each ROM
+# writes OUTPUT_DIR/<ROM name>.log; see frame_hash_log_open in movie.h.
+#
+# JOBS emulators run at the same time (default: the number of processors).
+#
+# With -b, each log is compared against the log of the same name in
+# BASELINE_DIR. The first frame whose screen or sound hash differs is
+# reported, as well as the change in emulated frames per second. The
+# summary is also written to OUTPUT_DIR/summary.txt. With -u, the new logs
+# then replace those in BASELINE_DIR.
+#
+# Each emulator runs with HOME set to a new directory under OUTPUT_DIR/home,
+# holding only a copy of ~/.gpsp/gba_bios.bin if there is one.
+#
+# The emulator is started with the command in $REGBA (default ./regba.dge).
+# To run a MIPS build on another host, set it to something like
+#   REGBA="qemu-mipsel -L /path/to/sysroot /path/to/regba.dge"
+
+# Runs one ROM. The script calls itself this way through xargs, with the
+# settings in the environment.
+run_rom() {
+	ROM="$1"
+	NAME=$(basename "$ROM")
+	NAME="${NAME%.*}"
+	MOVIE="${ROM%.*}.mov"
+	LOG="$OUTPUT/$NAME.log"
+
+	# Each run gets its own, empty ~/.gpsp so that saves and settings from
+	# other runs can't change the results. Only the BIOS is copied.
+	RUN_HOME="$OUTPUT/home/$NAME"
+	rm -rf "$RUN_HOME" "$LOG"
+	mkdir -p "$RUN_HOME/.gpsp"
+	if [ -f "$HOME/.gpsp/gba_bios.bin" ]; then
+		cp "$HOME/.gpsp/gba_bios.bin" "$RUN_HOME/.gpsp/"
+	fi
+	export HOME="$RUN_HOME"
+
+	if [ -f "$MOVIE" ]; then
+		$REGBA "$ROM" --headless --frames "$FRAMES" --play "$MOVIE" \
+			--hash-log "$LOG" > "$OUTPUT/$NAME.out" 2>&1
+	else
+		$REGBA "$ROM" --headless --frames "$FRAMES" \
+			--hash-log "$LOG" > "$OUTPUT/$NAME.out" 2>&1
+	fi
+}
+
+if [ "$1" = "--run-one" ]; then
+	run_rom "$2"
+	exit 0
+fi
+
+JOBS=$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)
+FRAMES=3600
+BASELINE=
+UPDATE=0
+: "${REGBA:=./regba.dge}"
+
+while getopts "j:n:b:u" OPTION; do
+	case "$OPTION" in
+		j) JOBS="$OPTARG" ;;
+		n) FRAMES="$OPTARG" ;;
+		b) BASELINE="$OPTARG" ;;
+		u) UPDATE=1 ;;
+		*) sed -n '5,6p' "$0" >&2; exit 2 ;;
+	esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 2 ]; then
+	sed -n '5,6p' "$0" >&2
+	exit 2
+fi
+
+CORPUS="$1"
+OUTPUT="$2"
+mkdir -p "$OUTPUT" || exit 1
+
+# - - - Running - - -
+
+export OUTPUT FRAMES REGBA
+find "$CORPUS" -maxdepth 1 -type f \
+	\( -iname '*.gba' -o -iname '*.bin' -o -iname '*.zip' \) -print0 |
+	xargs -0 -n 1 -P "$JOBS" sh "$0" --run-one
+
+# - - - Comparing - - -
+
+if [ -z "$BASELINE" ]; then
+	exit 0
+fi
+
+SUMMARY="$OUTPUT/summary.txt"
+: > "$SUMMARY"
+DIVERGED=0
+
+for BASE_LOG in "$BASELINE"/*.log; do
+	[ -f "$BASE_LOG" ] || continue
+	NAME=$(basename "$BASE_LOG" .log)
+	LOG="$OUTPUT/$NAME.log"
+
+	if ! grep -q '^# Frames' "$LOG" 2>/dev/null; then
+		echo "$NAME: did not finish (see $OUTPUT/$NAME.out)" >> "$SUMMARY"
+		DIVERGED=$((DIVERGED + 1))
+		continue
+	fi
+
+	# Frame lines are "frame screen-crc sound-crc". A screen hash of
+	# "--------" (frame not rendered) matches anything.
+	awk -v NAME="$NAME" '
+		FNR == 1 { File++ }
+		/^#/ {
+			if ($2 == "Frames") Frames[File] = $3
+			if ($2 == "Nanoseconds") Time[File] = $3
+			next
+		}
+		File == 1 { Screen[$1] = $2; Sound[$1] = $3; next }
+		Diverged == "" && ($1 in Sound) {
+			if ($3 != Sound[$1])
+				Diverged = $1 " (sound)"
+			else if ($2 != Screen[$1] && $2 != "--------" && Screen[$1] != "--------")
+				Diverged = $1 " (screen)"
+		}
+		END {
+			Line = NAME ": "
+			if (Diverged != "")
+				Line = Line "diverges at frame " Diverged
+			else if (Frames[1] != Frames[2])
+				Line = Line "ran " Frames[2] " frames instead of " Frames[1]
+			else
+				Line = Line "identical"
+			if (Time[1] > 0 && Time[2] > 0) {
+				Before = Frames[1] * 1e9 / Time[1]
+				After = Frames[2] * 1e9 / Time[2]
+				Line = Line sprintf(", %.1f -> %.1f FPS (%+.1f%%)", Before, After, (After - Before) * 100 / Before)
+			}
+			print Line
+			exit (Diverged != "" || Frames[1] != Frames[2])
+		}' "$BASE_LOG" "$LOG" >> "$SUMMARY" || DIVERGED=$((DIVERGED + 1))
+done
+
+echo "$DIVERGED ROM(s) diverged from the baseline." >> "$SUMMARY"
+cat "$SUMMARY"
+
+if [ "$UPDATE" -ne 0 ]; then
+	mkdir -p "$BASELINE" && cp "$OUTPUT"/*.log "$BASELINE"/
+fi
+
+[ "$DIVERGED" -eq 0 ]
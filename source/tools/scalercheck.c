@@ -0,0 +1,218 @@
+/*
+ * Checks that the OpenDingux sub-pixel and bilinear scalers, which convert
+ * their source lines once with bgr555_to_rgb565_rows, draw exactly what the
+ * per-pixel scalers in scalerref.h draw, on frames made to hit both the
+ * blending and the equal-pixel shortcuts. Also times the scalers.
+ *
+ * Build on the host with:  make -C tools scalercheck
+ * usage: ./scalercheck              check every scaler; exits with 1 on a
+ *                                   difference
+ *        ./scalercheck -b [FRAMES]  time every scaler over FRAMES frames
+ *                                   (default 1000)
+ *
+ * draw.c is compiled in whole so that its static scalers can be called;
+ * nothing else in it is used.
+ */
+#include "../opendingux/draw.c"
+#include "scalerref.h"
+
+#include <time.h>
+
+#define DST_PITCH (GCW0_SCREEN_WIDTH * sizeof(uint16_t))
+#define DST_SIZE  (GCW0_SCREEN_HEIGHT * DST_PITCH)
+#define MAX_SRC_PITCH 512
+
+/* Offset of the aspect scalers' output, as in PresentFrame. */
+#define ASPECT_OFFSET \
+	(((GCW0_SCREEN_HEIGHT - GBA_SCREEN_HEIGHT * 4 / 3) / 2) * DST_PITCH)
+
+typedef void (*scaler_function)(uint16_t* to, uint16_t* from,
+	uint32_t src_x, uint32_t src_y, uint32_t src_pitch, uint32_t dst_pitch);
+
+struct scaler {
+	const char* name;
+	scaler_function scaler;
+	scaler_function reference;  /* NULL if the scaler has no new path */
+	size_t dst_offset;
+};
+
+static void render(uint16_t* to, uint16_t* from, uint32_t src_x,
+	uint32_t src_y, uint32_t src_pitch, uint32_t dst_pitch)
+{
+	gba_render(to, from, src_pitch, dst_pitch);
+}
+
+static void convert(uint16_t* to, uint16_t* from, uint32_t src_x,
+	uint32_t src_y, uint32_t src_pitch, uint32_t dst_pitch)
+{
+	gba_convert(to, from, src_pitch, dst_pitch);
+}
+
+static const struct scaler scalers[] = {
+	{ "fullscreen subpixel", gba_upscale_subpixel, ref_gba_upscale_subpixel, 0 },
+	{ "fullscreen bilinear", gba_upscale_bilinear, ref_gba_upscale_bilinear, 0 },
+	{ "aspect subpixel", gba_upscale_aspect_subpixel, ref_gba_upscale_aspect_subpixel, ASPECT_OFFSET },
+	{ "aspect bilinear", gba_upscale_aspect_bilinear, ref_gba_upscale_aspect_bilinear, ASPECT_OFFSET },
+	{ "fullscreen", gba_upscale, NULL, 0 },
+	{ "aspect", gba_upscale_aspect, NULL, ASPECT_OFFSET },
+	{ "unscaled", render, NULL, 0 },
+	{ "hardware", convert, NULL, 0 },
+};
+
+#define SCALER_COUNT (sizeof(scalers) / sizeof(scalers[0]))
+
+static uint16_t Source[GBA_SCREEN_HEIGHT * MAX_SRC_PITCH / sizeof(uint16_t)] __attribute__((aligned(4)));
+static uint16_t Output[DST_SIZE / sizeof(uint16_t)];
+static uint16_t Expected[DST_SIZE / sizeof(uint16_t)];
+
+static uint32_t RandomState = 1;
+
+static uint16_t Random16(void)
+{
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+	return RandomState;
+}
+
+enum FramePattern {
+	FRAME_RANDOM,      /* every pixel differs from its neighbours */
+	FRAME_FLAT,        /* every pixel is the same */
+	FRAME_BLOCKS,      /* runs of equal pixels in both directions */
+	FRAME_STRIPES,     /* columns alternate */
+	FRAME_CHECKERS,    /* pixels alternate in both directions */
+	FRAME_PATTERN_COUNT
+};
+
+static const char* PatternNames[FRAME_PATTERN_COUNT] = {
+	"random", "flat", "blocks", "stripes", "checkers"
+};
+
+/* Fills the source with a pattern. Bit 15, which the GBA ignores, is set
+ * at random throughout, and so is the padding at the end of each line. */
+static void FillSource(enum FramePattern Pattern, uint32_t SrcPitch)
+{
+	uint16_t A = Random16(), B = Random16();
+	uint32_t X, Y;
+	for (Y = 0; Y < GBA_SCREEN_HEIGHT; Y++)
+	{
+		uint16_t* Line = (uint16_t*) ((uint8_t*) Source + Y * SrcPitch);
+		for (X = 0; X < SrcPitch / sizeof(uint16_t); X++)
+		{
+			uint16_t Pixel;
+			switch (Pattern)
+			{
+				case FRAME_RANDOM:   Pixel = Random16(); break;
+				case FRAME_FLAT:     Pixel = A; break;
+				case FRAME_BLOCKS:   Pixel = ((X / 5 + Y / 3) & 1) ? A : B; break;
+				case FRAME_STRIPES:  Pixel = (X & 1) ? A : B; break;
+				default:             Pixel = ((X ^ Y) & 1) ? A : B; break;
+			}
+			Line[X] = (Pixel & 0x7FFF) | (Random16() & 0x8000);
+		}
+	}
+}
+
+static void RunScaler(scaler_function Scaler, size_t DstOffset,
+	uint16_t* Dest, uint32_t SrcPitch)
+{
+	Scaler((uint16_t*) ((uint8_t*) Dest + DstOffset), Source,
+		GBA_SCREEN_WIDTH, GBA_SCREEN_HEIGHT, SrcPitch, DST_PITCH);
+}
+
+static unsigned int Check(void)
+{
+	static const uint32_t SrcPitches[] = {
+		GBA_SCREEN_WIDTH * sizeof(uint16_t), MAX_SRC_PITCH
+	};
+	unsigned int Failures = 0, Frames = 0;
+	uint32_t P, Pattern, Seed, S;
+
+	for (P = 0; P < sizeof(SrcPitches) / sizeof(SrcPitches[0]); P++)
+	for (Pattern = 0; Pattern < FRAME_PATTERN_COUNT; Pattern++)
+	for (Seed = 0; Seed < 4; Seed++)
+	{
+		FillSource(Pattern, SrcPitches[P]);
+		Frames++;
+		for (S = 0; S < SCALER_COUNT; S++)
+		{
+			size_t Pixel;
+			if (scalers[S].reference == NULL)
+				continue;
+			/* Anything the scalers don't draw must stay as it was, too. */
+			memset(Output, 0xA5, DST_SIZE);
+			memset(Expected, 0xA5, DST_SIZE);
+			RunScaler(scalers[S].scaler, scalers[S].dst_offset, Output, SrcPitches[P]);
+			RunScaler(scalers[S].reference, scalers[S].dst_offset, Expected, SrcPitches[P]);
+			for (Pixel = 0; Pixel < DST_SIZE / sizeof(uint16_t); Pixel++)
+				if (Output[Pixel] != Expected[Pixel])
+					break;
+			if (Pixel < DST_SIZE / sizeof(uint16_t))
+			{
+				printf("FAIL: %s, %s frame, source pitch %u: pixel (%u, %u) is %04X, not %04X\n",
+					scalers[S].name, PatternNames[Pattern], SrcPitches[P],
+					(unsigned int) (Pixel % GCW0_SCREEN_WIDTH),
+					(unsigned int) (Pixel / GCW0_SCREEN_WIDTH),
+					Output[Pixel], Expected[Pixel]);
+				Failures++;
+			}
+		}
+	}
+
+	if (Failures == 0)
+		printf("All scalers match their references on %u frames\n", Frames);
+	return Failures;
+}
+
+static uint64_t Now(void)
+{
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return (uint64_t) Time.tv_sec * 1000000000 + Time.tv_nsec;
+}
+
+static uint64_t TimeScaler(scaler_function Scaler, size_t DstOffset,
+	unsigned int Frames)
+{
+	uint64_t Start = Now();
+	unsigned int Frame;
+	for (Frame = 0; Frame < Frames; Frame++)
+		RunScaler(Scaler, DstOffset, Output, GBA_SCREEN_WIDTH * sizeof(uint16_t));
+	return (Now() - Start) / Frames;
+}
+
+static void Benchmark(unsigned int Frames)
+{
+	uint32_t S;
+
+	/* Frames from games have long runs of equal pixels, which take the
+	 * scalers' shortcuts; random frames never do. Time both. */
+	printf("%-20s %12s %12s %12s %12s\n", "ns per frame", "blocks",
+		"(per pixel)", "random", "(per pixel)");
+	for (S = 0; S < SCALER_COUNT; S++)
+	{
+		uint64_t Times[4] = { 0, 0, 0, 0 };
+		enum FramePattern Patterns[2] = { FRAME_BLOCKS, FRAME_RANDOM };
+		uint32_t P;
+		for (P = 0; P < 2; P++)
+		{
+			FillSource(Patterns[P], GBA_SCREEN_WIDTH * sizeof(uint16_t));
+			Times[P * 2] = TimeScaler(scalers[S].scaler, scalers[S].dst_offset, Frames);
+			if (scalers[S].reference != NULL)
+				Times[P * 2 + 1] = TimeScaler(scalers[S].reference, scalers[S].dst_offset, Frames);
+		}
+		printf("%-20s %12llu %12llu %12llu %12llu\n", scalers[S].name,
+			(unsigned long long) Times[0], (unsigned long long) Times[1],
+			(unsigned long long) Times[2], (unsigned long long) Times[3]);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc >= 2 && strcmp(argv[1], "-b") == 0)
+	{
+		Benchmark(argc >= 3 ? (unsigned int) strtoul(argv[2], NULL, 10) : 1000);
+		return 0;
+	}
+	return Check() != 0;
+}
@@ -0,0 +1,764 @@
+/*
+ * The sub-pixel and bilinear scalers of opendingux/draw.c as they were
+ * before they converted their source lines with bgr555_to_rgb565_rows:
+ * every source pixel is converted by bgr555_to_rgb565_16 where it is read.
+ * scalercheck.c compares the scalers in draw.c against these.
+ *
+ * Include after draw.c, which defines the colour helpers they use.
+ */
+
+/* Upscales an image based on subpixel rendering; also does color conversion
+ * using the function above.
+ * Input:
+ *   from: A pointer to the pixels member of a src_x by src_y surface to be
+ *     read by this function. The pixel format of this surface is XBGR 1555.
+ *   src_x: The width of the source.
+ *   src_y: The height of the source.
+ *   src_pitch: The number of bytes making up a scanline in the source
+ *     surface.
+ *   dst_pitch: The number of bytes making up a scanline in the destination
+ *     surface.
+ * Output:
+ *   to: A pointer to the pixels member of a (src_x * 4/3) by (src_y * 3/2)
+ *     surface to be filled with the upscaled GBA image. The pixel format of
+ *     this surface is RGB 565.
+ */
+static inline void ref_gba_upscale_subpixel(uint16_t *to, uint16_t *from,
+	  uint32_t src_x, uint32_t src_y, uint32_t src_pitch, uint32_t dst_pitch)
+{
+	const uint32_t dst_x = src_x * 4 / 3;
+	const uint32_t src_skip = src_pitch - src_x * sizeof(uint16_t),
+	               dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
+
+	uint_fast16_t sectY;
+	for (sectY = 0; sectY < src_y / 2; sectY++)
+	{
+		uint_fast16_t sectX;
+		for (sectX = 0; sectX < src_x / 3; sectX++)
+		{
+			uint_fast16_t rightCol = (sectX == src_x / 3 - 1) ? 4 : 6;
+			/* Read RGB565 elements in the source grid.
+			 * The last column blends with the first column of the next
+			 * section.
+			 *
+			 * a b c | d
+			 * e f g | h
+			 */
+			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
+			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
+			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
+			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
+			// coordinate for interpolation.
+
+			// -- Row 1 --
+
+			// -- Row 1 pixel 1 (X = 0) --
+			*to = a;
+
+			// -- Row 1 pixel 2 (X = 0.75) --
+			*(uint16_t*) ((uint8_t*) to + 2) = likely(a == b)
+				? a
+				: SubpixelRGB1_3(a, b);
+
+			// -- Row 1 pixel 3 (X = 1.5) --
+			*(uint16_t*) ((uint8_t*) to + 4) = likely(b == c)
+				? b
+				: SubpixelRGB1_1(b, c);
+
+			// -- Row 1 pixel 4 (X = 2.25) --
+			*(uint16_t*) ((uint8_t*) to + 6) = likely(c == d)
+				? c
+				: SubpixelRGB3_1(c, d);
+
+			// -- Row 2 --
+			// All pixels in this row are blended from the two rows.
+			uint32_t e = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch    )),
+			         f = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 2)),
+			         g = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 4)),
+			         h = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + rightCol));
+
+			// -- Row 2 pixel 1 (X = 0) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch) = likely(a == e)
+				? a
+				: Average(a, e);
+
+			// -- Row 2 pixel 2 (X = 0.75) --
+			uint16_t e1f3 = likely(e == f)
+				? e
+				: SubpixelRGB1_3(e, f);
+			uint16_t a1b3 = likely(a == b)
+				? a
+				: SubpixelRGB1_3(a, b);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 2) = likely(a1b3 == e1f3)
+				? a1b3
+				: Average(a1b3, e1f3);
+
+			// -- Row 2 pixel 3 (X = 1.5) --
+			uint16_t fg = likely(f == g)
+				? f
+				: SubpixelRGB1_1(f, g);
+			uint16_t bc = likely(b == c)
+				? b
+				: SubpixelRGB1_1(b, c);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 4) = likely(bc == fg)
+				? bc
+				: Average(bc, fg);
+
+			// -- Row 2 pixel 4 (X = 2.25) --
+			uint16_t g3h1 = likely(g == h)
+				? g
+				: SubpixelRGB3_1(g, h);
+			uint16_t c3d1 = likely(c == d)
+				? c
+				: SubpixelRGB3_1(c, d);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 6) = /* in Y */ likely(g3h1 == c3d1)
+				? c3d1
+				: Average(c3d1, g3h1);
+
+			// -- Row 3 --
+
+			// -- Row 3 pixel 1 (X = 0) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2) = e;
+
+			// -- Row 3 pixel 2 (X = 0.75) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 2) = likely(e == f)
+				? e
+				: SubpixelRGB1_3(e, f);
+
+			// -- Row 3 pixel 3 (X = 1.5) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 4) = likely(f == g)
+				? f
+				: SubpixelRGB1_1(f, g);
+
+			// -- Row 3 pixel 4 (X = 2.25) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 6) = likely(g == h)
+				? g
+				: SubpixelRGB3_1(g, h);
+
+			from += 3;
+			to   += 4;
+		}
+
+		// Skip past the waste at the end of the first line, if any,
+		// then past 1 whole lines of source and 2 of destination.
+		from = (uint16_t*) ((uint8_t*) from + src_skip + 1 * src_pitch);
+		to   = (uint16_t*) ((uint8_t*) to   + dst_skip + 2 * dst_pitch);
+	}
+}
+
+/* Upscales an image by 33% in width and in height, based on subpixel
+ * rendering; also does color conversion using the function above.
+ * Input:
+ *   from: A pointer to the pixels member of a src_x by src_y surface to be
+ *     read by this function. The pixel format of this surface is XBGR 1555.
+ *   src_x: The width of the source.
+ *   src_y: The height of the source.
+ *   src_pitch: The number of bytes making up a scanline in the source
+ *     surface.
+ *   dst_pitch: The number of bytes making up a scanline in the destination
+ *     surface.
+ * Output:
+ *   to: A pointer to the pixels member of a (src_x * 4/3) by (src_y * 4/3)
+ *     surface to be filled with the upscaled GBA image. The pixel format of
+ *     this surface is RGB 565.
+ */
+static inline void ref_gba_upscale_aspect_subpixel(uint16_t *to, uint16_t *from,
+	  uint32_t src_x, uint32_t src_y, uint32_t src_pitch, uint32_t dst_pitch)
+{
+	const uint32_t dst_x = src_x * 4 / 3;
+	const uint32_t src_skip = src_pitch - src_x * sizeof(uint16_t),
+	               dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
+
+	uint_fast16_t sectY;
+	for (sectY = 0; sectY < src_y / 3; sectY++)
+	{
+		uint_fast16_t sectX;
+		for (sectX = 0; sectX < src_x / 3; sectX++)
+		{
+			uint_fast16_t rightCol = (sectX == src_x / 3 - 1) ? 4 : 6;
+			/* Read RGB565 elements in the source grid.
+			 * The last column blends with the first column of the next
+			 * section. The last row does the same thing.
+			 *
+			 * a b c | d
+			 * e f g | h
+			 * i j k | l
+			 * ---------
+			 * m n o | p
+			 */
+			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
+			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
+			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
+			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
+			// coordinate for interpolation.
+
+			// -- Row 1 --
+			// All pixels in this row use 0 as the Y coordinate.
+
+			// -- Row 1 pixel 1 (X = 0) --
+			*to = a;
+
+			// -- Row 1 pixel 2 (X = 0.75) --
+			*(uint16_t*) ((uint8_t*) to + 2) = likely(a == b)
+				? a
+				: SubpixelRGB1_3(a, b);
+
+			// -- Row 1 pixel 3 (X = 1.5) --
+			*(uint16_t*) ((uint8_t*) to + 4) = likely(b == c)
+				? b
+				: SubpixelRGB1_1(b, c);
+
+			// -- Row 1 pixel 4 (X = 2.25) --
+			*(uint16_t*) ((uint8_t*) to + 6) = likely(c == d)
+				? c
+				: SubpixelRGB3_1(c, d);
+
+			// -- Row 2 --
+			// All pixels in this row use 0.75 as the Y coordinate.
+			uint32_t e = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch    )),
+			         f = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 2)),
+			         g = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 4)),
+			         h = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + rightCol));
+
+			// -- Row 2 pixel 1 (X = 0) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch) = likely(a == e)
+				? a
+				: AverageQuarters3_1(e, a);
+
+			// -- Row 2 pixel 2 (X = 0.75) --
+			uint16_t e1f3 = likely(e == f)
+				? e
+				: SubpixelRGB1_3(e, f);
+			uint16_t a1b3 = likely(a == b)
+				? a
+				: SubpixelRGB1_3(a, b);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 2) = /* in Y */ likely(a1b3 == e1f3)
+				? a1b3
+				: AverageQuarters3_1(/* in X, bottom */ e1f3, /* in X, top */ a1b3);
+
+			// -- Row 2 pixel 3 (X = 1.5) --
+			uint16_t fg = likely(f == g)
+				? f
+				: SubpixelRGB1_1(f, g);
+			uint16_t bc = likely(b == c)
+				? b
+				: SubpixelRGB1_1(b, c);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 4) = /* in Y */ likely(bc == fg)
+				? bc
+				: AverageQuarters3_1(/* in X, bottom */ fg, /* in X, top */ bc);
+
+			// -- Row 2 pixel 4 (X = 2.25) --
+			uint16_t g3h1 = likely(g == h)
+				? g
+				: SubpixelRGB3_1(g, h);
+			uint16_t c3d1 = likely(c == d)
+				? c
+				: SubpixelRGB3_1(c, d);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 6) = /* in Y */ likely(g3h1 == c3d1)
+				? c3d1
+				: AverageQuarters3_1(/* in X, bottom */ g3h1, /* in X, top */ c3d1);
+
+			// -- Row 3 --
+			// All pixels in this row use 1.5 as the Y coordinate.
+			uint32_t i = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2    )),
+			         j = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + 2)),
+			         k = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + 4)),
+			         l = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + rightCol));
+
+			// -- Row 3 pixel 1 (X = 0) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2) = likely(e == i)
+				? e
+				: Average(e, i);
+
+			// -- Row 3 pixel 2 (X = 0.75) --
+			uint16_t i1j3 = likely(i == j)
+				? i
+				: SubpixelRGB1_3(i, j);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 2) = /* in Y */ likely(e1f3 == i1j3)
+				? e1f3
+				: Average(e1f3, i1j3);
+
+			// -- Row 3 pixel 3 (X = 1.5) --
+			uint16_t jk = likely(j == k)
+				? j
+				: SubpixelRGB1_1(j, k);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 4) = /* in Y */ likely(fg == jk)
+				? fg
+				: Average(fg, jk);
+
+			// -- Row 3 pixel 4 (X = 2.25) --
+			uint16_t k3l1 = likely(k == l)
+				? k
+				: SubpixelRGB3_1(k, l);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 6) = /* in Y */ likely(g3h1 == k3l1)
+				? g3h1
+				: Average(g3h1, k3l1);
+
+			// -- Row 4 --
+			// All pixels in this row use 2.25 as the Y coordinate.
+			uint32_t m = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3    )),
+			         n = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + 2)),
+			         o = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + 4)),
+			         p = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + rightCol));
+
+			// -- Row 4 pixel 1 (X = 0) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 3) = likely(i == m)
+				? i
+				: AverageQuarters3_1(i, m);
+
+			// -- Row 4 pixel 2 (X = 0.75) --
+			uint16_t m1n3 = likely(m == n)
+				? m
+				: SubpixelRGB1_3(m, n);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 3 + 2) = /* in Y */ likely(i1j3 == m1n3)
+				? i1j3
+				: AverageQuarters3_1(/* in X, top */ i1j3, /* in X, bottom */ m1n3);
+
+			// -- Row 4 pixel 3 (X = 1.5) --
+			uint16_t no = likely(n == o)
+				? n
+				: SubpixelRGB1_1(n, o);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 3 + 4) = /* in Y */ likely(jk == no)
+				? jk
+				: AverageQuarters3_1(/* in X, top */ jk, /* in X, bottom */ no);
+
+			// -- Row 4 pixel 4 (X = 2.25) --
+			uint16_t o3p1 = likely(o == p)
+				? o
+				: SubpixelRGB3_1(o, p);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 3 + 6) = /* in Y */ likely(k3l1 == o3p1)
+				? k3l1
+				: AverageQuarters3_1(/* in X, top */ k3l1, /* in X, bottom */ o3p1);
+
+			from += 3;
+			to   += 4;
+		}
+
+		// Skip past the waste at the end of the first line, if any,
+		// then past 2 whole lines of source and 3 of destination.
+		from = (uint16_t*) ((uint8_t*) from + src_skip + 2 * src_pitch);
+		to   = (uint16_t*) ((uint8_t*) to   + dst_skip + 3 * dst_pitch);
+	}
+
+	if (src_y % 3 == 1)
+	{
+		uint_fast16_t sectX;
+		for (sectX = 0; sectX < src_x / 3; sectX++)
+		{
+			uint_fast16_t rightCol = (sectX == src_x / 3 - 1) ? 4 : 6;
+			/* Read RGB565 elements in the source grid.
+			 * The last column blends with the first column of the next
+			 * section. The last row does the same thing.
+			 *
+			 * a b c | d
+			 */
+			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
+			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
+			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
+			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
+			// coordinate for interpolation.
+
+			// -- Row 1 pixel 1 (X = 0) --
+			*to = a;
+
+			// -- Row 1 pixel 2 (X = 0.75) --
+			*(uint16_t*) ((uint8_t*) to + 2) = likely(a == b)
+				? a
+				: AverageQuarters3_1(b, a);
+
+			// -- Row 1 pixel 3 (X = 1.5) --
+			*(uint16_t*) ((uint8_t*) to + 4) = likely(b == c)
+				? b
+				: Average(b, c);
+
+			// -- Row 1 pixel 4 (X = 2.25) --
+			*(uint16_t*) ((uint8_t*) to + 6) = likely(c == d)
+				? c
+				: AverageQuarters3_1(c, d);
+
+			from += 3;
+			to   += 4;
+		}
+	}
+}
+
+/* Upscales an image by 33% in width and in height with bilinear filtering;
+ * also does color conversion using the function above.
+ * Input:
+ *   from: A pointer to the pixels member of a src_x by src_y surface to be
+ *     read by this function. The pixel format of this surface is XBGR 1555.
+ *   src_x: The width of the source.
+ *   src_y: The height of the source.
+ *   src_pitch: The number of bytes making up a scanline in the source
+ *     surface.
+ *   dst_pitch: The number of bytes making up a scanline in the destination
+ *     surface.
+ * Output:
+ *   to: A pointer to the pixels member of a (src_x * 4/3) by (src_y * 4/3)
+ *     surface to be filled with the upscaled GBA image. The pixel format of
+ *     this surface is RGB 565.
+ */
+static inline void ref_gba_upscale_aspect_bilinear(uint16_t *to, uint16_t *from,
+	  uint32_t src_x, uint32_t src_y, uint32_t src_pitch, uint32_t dst_pitch)
+{
+	const uint32_t dst_x = src_x * 4 / 3;
+	const uint32_t src_skip = src_pitch - src_x * sizeof(uint16_t),
+	               dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
+
+	uint_fast16_t sectY;
+	for (sectY = 0; sectY < src_y / 3; sectY++)
+	{
+		uint_fast16_t sectX;
+		for (sectX = 0; sectX < src_x / 3; sectX++)
+		{
+			uint_fast16_t rightCol = (sectX == src_x / 3 - 1) ? 4 : 6;
+			/* Read RGB565 elements in the source grid.
+			 * The last column blends with the first column of the next
+			 * section. The last row does the same thing.
+			 *
+			 * a b c | d
+			 * e f g | h
+			 * i j k | l
+			 * ---------
+			 * m n o | p
+			 */
+			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
+			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
+			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
+			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
+			// coordinate for interpolation.
+
+			// -- Row 1 --
+			// All pixels in this row use 0 as the Y coordinate.
+
+			// -- Row 1 pixel 1 (X = 0) --
+			*to = a;
+
+			// -- Row 1 pixel 2 (X = 0.75) --
+			*(uint16_t*) ((uint8_t*) to + 2) = likely(a == b)
+				? a
+				: AverageQuarters3_1(b, a);
+
+			// -- Row 1 pixel 3 (X = 1.5) --
+			*(uint16_t*) ((uint8_t*) to + 4) = likely(b == c)
+				? b
+				: Average(b, c);
+
+			// -- Row 1 pixel 4 (X = 2.25) --
+			*(uint16_t*) ((uint8_t*) to + 6) = likely(c == d)
+				? c
+				: AverageQuarters3_1(c, d);
+
+			// -- Row 2 --
+			// All pixels in this row use 0.75 as the Y coordinate.
+			uint32_t e = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch    )),
+			         f = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 2)),
+			         g = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 4)),
+			         h = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + rightCol));
+
+			// -- Row 2 pixel 1 (X = 0) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch) = likely(a == e)
+				? a
+				: AverageQuarters3_1(e, a);
+
+			// -- Row 2 pixel 2 (X = 0.75) --
+			uint16_t e1f3 = likely(e == f)
+				? e
+				: AverageQuarters3_1(f, e);
+			uint16_t a1b3 = likely(a == b)
+				? a
+				: AverageQuarters3_1(b, a);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 2) = /* in Y */ likely(a1b3 == e1f3)
+				? a1b3
+				: AverageQuarters3_1(/* in X, bottom */ e1f3, /* in X, top */ a1b3);
+
+			// -- Row 2 pixel 3 (X = 1.5) --
+			uint16_t fg = likely(f == g)
+				? f
+				: Average(f, g);
+			uint16_t bc = likely(b == c)
+				? b
+				: Average(b, c);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 4) = /* in Y */ likely(bc == fg)
+				? bc
+				: AverageQuarters3_1(/* in X, bottom */ fg, /* in X, top */ bc);
+
+			// -- Row 2 pixel 4 (X = 2.25) --
+			uint16_t g3h1 = likely(g == h)
+				? g
+				: AverageQuarters3_1(g, h);
+			uint16_t c3d1 = likely(c == d)
+				? c
+				: AverageQuarters3_1(c, d);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 6) = /* in Y */ likely(g3h1 == c3d1)
+				? c3d1
+				: AverageQuarters3_1(/* in X, bottom */ g3h1, /* in X, top */ c3d1);
+
+			// -- Row 3 --
+			// All pixels in this row use 1.5 as the Y coordinate.
+			uint32_t i = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2    )),
+			         j = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + 2)),
+			         k = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + 4)),
+			         l = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 2 + rightCol));
+
+			// -- Row 3 pixel 1 (X = 0) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2) = likely(e == i)
+				? e
+				: Average(e, i);
+
+			// -- Row 3 pixel 2 (X = 0.75) --
+			uint16_t i1j3 = likely(i == j)
+				? i
+				: AverageQuarters3_1(j, i);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 2) = /* in Y */ likely(e1f3 == i1j3)
+				? e1f3
+				: Average(e1f3, i1j3);
+
+			// -- Row 3 pixel 3 (X = 1.5) --
+			uint16_t jk = likely(j == k)
+				? j
+				: Average(j, k);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 4) = /* in Y */ likely(fg == jk)
+				? fg
+				: Average(fg, jk);
+
+			// -- Row 3 pixel 4 (X = 2.25) --
+			uint16_t k3l1 = likely(k == l)
+				? k
+				: AverageQuarters3_1(k, l);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 6) = /* in Y */ likely(g3h1 == k3l1)
+				? g3h1
+				: Average(g3h1, k3l1);
+
+			// -- Row 4 --
+			// All pixels in this row use 2.25 as the Y coordinate.
+			uint32_t m = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3    )),
+			         n = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + 2)),
+			         o = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + 4)),
+			         p = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch * 3 + rightCol));
+
+			// -- Row 4 pixel 1 (X = 0) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 3) = likely(i == m)
+				? i
+				: AverageQuarters3_1(i, m);
+
+			// -- Row 4 pixel 2 (X = 0.75) --
+			uint16_t m1n3 = likely(m == n)
+				? m
+				: AverageQuarters3_1(n, m);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 3 + 2) = /* in Y */ likely(i1j3 == m1n3)
+				? i1j3
+				: AverageQuarters3_1(/* in X, top */ i1j3, /* in X, bottom */ m1n3);
+
+			// -- Row 4 pixel 3 (X = 1.5) --
+			uint16_t no = likely(n == o)
+				? n
+				: Average(n, o);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 3 + 4) = /* in Y */ likely(jk == no)
+				? jk
+				: AverageQuarters3_1(/* in X, top */ jk, /* in X, bottom */ no);
+
+			// -- Row 4 pixel 4 (X = 2.25) --
+			uint16_t o3p1 = likely(o == p)
+				? o
+				: AverageQuarters3_1(o, p);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 3 + 6) = /* in Y */ likely(k3l1 == o3p1)
+				? k3l1
+				: AverageQuarters3_1(/* in X, top */ k3l1, /* in X, bottom */ o3p1);
+
+			from += 3;
+			to   += 4;
+		}
+
+		// Skip past the waste at the end of the first line, if any,
+		// then past 2 whole lines of source and 3 of destination.
+		from = (uint16_t*) ((uint8_t*) from + src_skip + 2 * src_pitch);
+		to   = (uint16_t*) ((uint8_t*) to   + dst_skip + 3 * dst_pitch);
+	}
+
+	if (src_y % 3 == 1)
+	{
+		uint_fast16_t sectX;
+		for (sectX = 0; sectX < src_x / 3; sectX++)
+		{
+			uint_fast16_t rightCol = (sectX == src_x / 3 - 1) ? 4 : 6;
+			/* Read RGB565 elements in the source grid.
+			 * The last column blends with the first column of the next
+			 * section. The last row does the same thing.
+			 *
+			 * a b c | d
+			 */
+			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
+			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
+			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
+			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
+			// coordinate for interpolation.
+
+			// -- Row 1 pixel 1 (X = 0) --
+			*to = a;
+
+			// -- Row 1 pixel 2 (X = 0.75) --
+			*(uint16_t*) ((uint8_t*) to + 2) = likely(a == b)
+				? a
+				: AverageQuarters3_1(b, a);
+
+			// -- Row 1 pixel 3 (X = 1.5) --
+			*(uint16_t*) ((uint8_t*) to + 4) = likely(b == c)
+				? b
+				: Average(b, c);
+
+			// -- Row 1 pixel 4 (X = 2.25) --
+			*(uint16_t*) ((uint8_t*) to + 6) = likely(c == d)
+				? c
+				: AverageQuarters3_1(c, d);
+
+			from += 3;
+			to   += 4;
+		}
+	}
+}
+
+/* Upscales an image by 33% in width and 50% in height with bilinear
+ * filtering; also does color conversion using the function above.
+ * Input:
+ *   from: A pointer to the pixels member of a src_x by src_y surface to be
+ *     read by this function. The pixel format of this surface is XBGR 1555.
+ *   src_x: The width of the source.
+ *   src_y: The height of the source.
+ *   src_pitch: The number of bytes making up a scanline in the source
+ *     surface.
+ *   dst_pitch: The number of bytes making up a scanline in the destination
+ *     surface.
+ * Output:
+ *   to: A pointer to the pixels member of a (src_x * 4/3) by (src_y * 3/2)
+ *     surface to be filled with the upscaled GBA image. The pixel format of
+ *     this surface is RGB 565.
+ */
+static inline void ref_gba_upscale_bilinear(uint16_t *to, uint16_t *from,
+	  uint32_t src_x, uint32_t src_y, uint32_t src_pitch, uint32_t dst_pitch)
+{
+	const uint32_t dst_x = src_x * 4 / 3;
+	const uint32_t src_skip = src_pitch - src_x * sizeof(uint16_t),
+	               dst_skip = dst_pitch - dst_x * sizeof(uint16_t);
+
+	uint_fast16_t sectY;
+	for (sectY = 0; sectY < src_y / 2; sectY++)
+	{
+		uint_fast16_t sectX;
+		for (sectX = 0; sectX < src_x / 3; sectX++)
+		{
+			uint_fast16_t rightCol = (sectX == src_x / 3 - 1) ? 4 : 6;
+			/* Read RGB565 elements in the source grid.
+			 * The last column blends with the first column of the next
+			 * section.
+			 *
+			 * a b c | d
+			 * e f g | h
+			 */
+			uint32_t a = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from    )),
+			         b = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 2)),
+			         c = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + 4)),
+			         d = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + rightCol));
+			// The 4 output pixels in a row use 0.75, 1.5 then 2.25 as the X
+			// coordinate for interpolation.
+
+			// -- Row 1 --
+
+			// -- Row 1 pixel 1 (X = 0) --
+			*to = a;
+
+			// -- Row 1 pixel 2 (X = 0.75) --
+			*(uint16_t*) ((uint8_t*) to + 2) = likely(a == b)
+				? a
+				: AverageQuarters3_1(b, a);
+
+			// -- Row 1 pixel 3 (X = 1.5) --
+			*(uint16_t*) ((uint8_t*) to + 4) = likely(b == c)
+				? b
+				: Average(b, c);
+
+			// -- Row 1 pixel 4 (X = 2.25) --
+			*(uint16_t*) ((uint8_t*) to + 6) = likely(c == d)
+				? c
+				: AverageQuarters3_1(c, d);
+
+			// -- Row 2 --
+			// All pixels in this row are blended from the two rows.
+			uint32_t e = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch    )),
+			         f = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 2)),
+			         g = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + 4)),
+			         h = bgr555_to_rgb565_16(*(uint16_t*) ((uint8_t*) from + src_pitch + rightCol));
+
+			// -- Row 2 pixel 1 (X = 0) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch) = likely(a == e)
+				? a
+				: Average(a, e);
+
+			// -- Row 2 pixel 2 (X = 0.75) --
+			uint16_t e1f3 = likely(e == f)
+				? e
+				: AverageQuarters3_1(f, e);
+			uint16_t a1b3 = likely(a == b)
+				? a
+				: AverageQuarters3_1(b, a);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 2) = likely(a1b3 == e1f3)
+				? a1b3
+				: Average(a1b3, e1f3);
+
+			// -- Row 2 pixel 3 (X = 1.5) --
+			uint16_t fg = likely(f == g)
+				? f
+				: Average(f, g);
+			uint16_t bc = likely(b == c)
+				? b
+				: Average(b, c);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 4) = likely(bc == fg)
+				? bc
+				: Average(bc, fg);
+
+			// -- Row 2 pixel 4 (X = 2.25) --
+			uint16_t g3h1 = likely(g == h)
+				? g
+				: AverageQuarters3_1(g, h);
+			uint16_t c3d1 = likely(c == d)
+				? c
+				: AverageQuarters3_1(c, d);
+			*(uint16_t*) ((uint8_t*) to + dst_pitch + 6) = /* in Y */ likely(g3h1 == c3d1)
+				? c3d1
+				: Average(c3d1, g3h1);
+
+			// -- Row 3 --
+
+			// -- Row 3 pixel 1 (X = 0) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2) = e;
+
+			// -- Row 3 pixel 2 (X = 0.75) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 2) = likely(e == f)
+				? e
+				: AverageQuarters3_1(f, e);
+
+			// -- Row 3 pixel 3 (X = 1.5) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 4) = likely(f == g)
+				? f
+				: Average(f, g);
+
+			// -- Row 3 pixel 4 (X = 2.25) --
+			*(uint16_t*) ((uint8_t*) to + dst_pitch * 2 + 6) = likely(g == h)
+				? g
+				: AverageQuarters3_1(g, h);
+
+			from += 3;
+			to   += 4;
+		}
+
+		// Skip past the waste at the end of the first line, if any,
+		// then past 1 whole lines of source and 2 of destination.
+		from = (uint16_t*) ((uint8_t*) from + src_skip + 1 * src_pitch);
+		to   = (uint16_t*) ((uint8_t*) to   + dst_skip + 2 * dst_pitch);
+	}
+}
@@ -0,0 +1,142 @@
+/*
+ * Prints an event trace saved by ReGBA (see trace.h) as text.
+ *
+ * Build on the host with:  cc -o tracedump tracedump.c
+ * usage: ./tracedump TRACE_FILE
+ *
+ * The trace must have been saved by a processor of the same byte order as
+ * the host's; every device ReGBA runs on is little-endian.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TRACE_DECODER
+#include "../trace.h"
+
+static const char* METADATA_AREA_NAMES[] = {
+	"BIOS", "EWRAM", "IWRAM", "VRAM", "ROM"
+};
+static const char* CODE_CACHE_NAMES[] = {
+	"read-only", "writable"
+};
+static const char* CLEAR_REASON_NAMES[] = {
+	"Initialising",
+	"Loading a new ROM",
+	"Invalidating native branches",
+	"Code cache full",
+	"Last tag reached",
+	"Loading a saved state"
+};
+static const char* FLUSH_REASON_NAMES[] = {
+	"Initialising",
+	"Loading a new ROM",
+	"Invalidating native branches",
+	"Code cache full"
+};
+
+#define NAME(table, index) \
+	((index) < sizeof(table) / sizeof(table[0]) ? table[index] : "?")
+
+static void print_event(const struct TraceEvent* Event, uint64_t Start)
+{
+	const uint32_t* Args = Event->Args;
+
+	printf("%12.6f ", (double) (Event->Time - Start) / 1000000000.0);
+	switch (Event->Event)
+	{
+		case TRACE_EVENT_TRANSLATE_ARM:
+		case TRACE_EVENT_TRANSLATE_THUMB:
+			printf("Translate %s block at %08X, %u bytes, hash %08X\n",
+				Event->Event == TRACE_EVENT_TRANSLATE_ARM ? "ARM" : "Thumb",
+				Args[0], Args[1], Args[2]);
+			break;
+		case TRACE_EVENT_REUSE_ARM:
+		case TRACE_EVENT_REUSE_THUMB:
+			printf("Reuse %s block at %08X, %u bytes, hash %08X\n",
+				Event->Event == TRACE_EVENT_REUSE_ARM ? "ARM" : "Thumb",
+				Args[0], Args[1], Args[2]);
+			break;
+		case TRACE_EVENT_TRANSLATION_REQUEST:
+			printf("Translation requested at %08X\n", Args[0]);
+			break;
+		case TRACE_EVENT_CODE_CACHE_FLUSH:
+			printf("Flush %s code cache (%u bytes): %s\n",
+				NAME(CODE_CACHE_NAMES, Args[0]), Args[2],
+				NAME(FLUSH_REASON_NAMES, Args[1]));
+			break;
+		case TRACE_EVENT_METADATA_CLEAR:
+			printf("Clear %s metadata: %s\n",
+				NAME(METADATA_AREA_NAMES, Args[0]),
+				NAME(CLEAR_REASON_NAMES, Args[1]));
+			break;
+		case TRACE_EVENT_GAMEPAK_PAGE_LOAD:
+			printf("Load Game Pak page %u (%08X..%08X) into slot %u\n",
+				Args[0], 0x08000000 + Args[0] * 0x8000,
+				0x08000000 + Args[0] * 0x8000 + 0x7FFF, Args[1]);
+			break;
+		case TRACE_EVENT_GAMEPAK_PAGE_EVICT:
+			printf("Evict Game Pak page %u from slot %u\n", Args[1], Args[0]);
+			break;
+		case TRACE_EVENT_DMA:
+			printf("DMA %u from %08X to %08X\n", Args[0], Args[1], Args[2]);
+			break;
+		case TRACE_EVENT_IRQ:
+			printf("IRQ %04X raised, IE %04X, IF %04X\n", Args[0], Args[1], Args[2]);
+			break;
+		case TRACE_EVENT_FRAME_END:
+			printf("End of frame %u (%u rendered so far)\n", Args[0], Args[1]);
+			break;
+		default:
+			printf("Unknown event %04X: %08X %08X %08X\n", Event->Event,
+				Args[0], Args[1], Args[2]);
+			break;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	FILE* fp;
+	char Magic[8];
+	uint32_t Count, i;
+	struct TraceEvent Event;
+	uint64_t Start = 0;
+
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: %s TRACE_FILE\n", argv[0]);
+		return 2;
+	}
+
+	fp = fopen(argv[1], "rb");
+	if (fp == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+
+	if (fread(Magic, 1, sizeof(Magic), fp) != sizeof(Magic)
+	 || memcmp(Magic, TRACE_FILE_MAGIC, sizeof(Magic)) != 0
+	 || fread(&Count, sizeof(Count), 1, fp) != 1)
+	{
+		fprintf(stderr, "%s: not a ReGBA event trace\n", argv[1]);
+		fclose(fp);
+		return 1;
+	}
+
+	for (i = 0; i < Count; i++)
+	{
+		if (fread(&Event, sizeof(Event), 1, fp) != 1)
+		{
+			fprintf(stderr, "%s: truncated after %u of %u events\n", argv[1], i, Count);
+			fclose(fp);
+			return 1;
+		}
+		if (i == 0)
+			Start = Event.Time;
+		print_event(&Event, Start);
+	}
+
+	fclose(fp);
+	return 0;
+}
@@ -0,0 +1,86 @@
+/* Binary event tracing for ReGBA
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "common.h"
+#include "trace.h"
+
+// 16384 events of 24 bytes = 384 KiB. This must be a power of two.
+#define TRACE_RING_SIZE 16384
+
+uint32_t trace_categories = 0;
+
+static struct TraceEvent* TraceRing = NULL;
+static uint32_t TraceNext = 0;
+static bool TraceWrapped = false;
+
+void trace_record(uint32_t Event, uint32_t Arg0, uint32_t Arg1, uint32_t Arg2)
+{
+	struct TraceEvent* Entry = &TraceRing[TraceNext];
+	Entry->Time = ReGBA_GetMonotonicTime();
+	Entry->Event = Event;
+	Entry->Args[0] = Arg0;
+	Entry->Args[1] = Arg1;
+	Entry->Args[2] = Arg2;
+
+	TraceNext = (TraceNext + 1) & (TRACE_RING_SIZE - 1);
+	if (TraceNext == 0)
+		TraceWrapped = true;
+}
+
+bool trace_set_categories(uint32_t Categories)
+{
+	if (Categories != 0 && TraceRing == NULL)
+	{
+		TraceRing = malloc(TRACE_RING_SIZE * sizeof(struct TraceEvent));
+		if (TraceRing == NULL)
+		{
+			ReGBA_Trace("W: Failed to allocate the event trace ring");
+			trace_categories = 0;
+			return false;
+		}
+	}
+	trace_categories = Categories & TRACE_CATEGORIES_ALL;
+	return true;
+}
+
+bool trace_save(const char* Filename)
+{
+	FILE_TAG_TYPE fd;
+	uint32_t Count = TraceWrapped ? TRACE_RING_SIZE : TraceNext;
+	bool Result;
+
+	FILE_OPEN(fd, Filename, WRITE);
+	if (!FILE_CHECK_VALID(fd))
+		return false;
+
+	Result = FILE_WRITE(fd, TRACE_FILE_MAGIC, 8) == 8
+	      && FILE_WRITE(fd, &Count, sizeof(Count)) == sizeof(Count);
+
+	if (Result && TraceWrapped)
+	{
+		// The oldest events are after the next one to be written.
+		uint32_t Older = TRACE_RING_SIZE - TraceNext;
+		Result = FILE_WRITE(fd, &TraceRing[TraceNext], Older * sizeof(struct TraceEvent))
+			== Older * sizeof(struct TraceEvent);
+	}
+	if (Result && TraceNext != 0)
+		Result = FILE_WRITE(fd, TraceRing, TraceNext * sizeof(struct TraceEvent))
+			== TraceNext * sizeof(struct TraceEvent);
+
+	FILE_CLOSE(fd);
+	return Result;
+}
@@ -0,0 +1,130 @@
+/* Binary event tracing for ReGBA
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * Events are recorded into a ring in memory, overwriting the oldest events
+ * when it is full, and written to a file on request. tools/tracedump.c turns
+ * such a file into text.
+ *
+ * Each event belongs to a category, which can be enabled or disabled while
+ * the emulator runs. When an event's category is disabled, recording it costs
+ * one load and one branch, so events can stay in release builds.
+ *
+ * This header is also included by tools/tracedump.c, so it must not depend on
+ * the rest of the emulator.
+ */
+
+#define TRACE_CATEGORY_TRANSLATION    0  /* Blocks translated and reused */
+#define TRACE_CATEGORY_FLUSH          1  /* Code cache flushes, metadata clears */
+#define TRACE_CATEGORY_GAMEPAK_PAGE   2  /* Game Pak pages loaded on demand */
+#define TRACE_CATEGORY_DMA            3
+#define TRACE_CATEGORY_IRQ            4
+#define TRACE_CATEGORY_FRAME          5
+#define TRACE_CATEGORY_COUNT          6
+
+#define TRACE_CATEGORIES_ALL          ((1 << TRACE_CATEGORY_COUNT) - 1)
+
+/*
+ * The category of an event is in the upper bits of its number, so that
+ * trace_event can find the category at compile time.
+ */
+#define TRACE_EVENT_NUMBER(category, index) (((category) << 8) | (index))
+#define TRACE_EVENT_CATEGORY(event)         ((event) >> 8)
+
+enum TraceEventType {
+	/* Args: GBA address, size in bytes, low 32 bits of the hash */
+	TRACE_EVENT_TRANSLATE_ARM     = TRACE_EVENT_NUMBER(TRACE_CATEGORY_TRANSLATION, 0),
+	TRACE_EVENT_TRANSLATE_THUMB   = TRACE_EVENT_NUMBER(TRACE_CATEGORY_TRANSLATION, 1),
+	TRACE_EVENT_REUSE_ARM         = TRACE_EVENT_NUMBER(TRACE_CATEGORY_TRANSLATION, 2),
+	TRACE_EVENT_REUSE_THUMB       = TRACE_EVENT_NUMBER(TRACE_CATEGORY_TRANSLATION, 3),
+	/* Args: GBA address */
+	TRACE_EVENT_TRANSLATION_REQUEST = TRACE_EVENT_NUMBER(TRACE_CATEGORY_TRANSLATION, 4),
+
+	/* Args: TRANSLATION_REGION_TYPE, CACHE_FLUSH_REASON_TYPE, bytes flushed */
+	TRACE_EVENT_CODE_CACHE_FLUSH  = TRACE_EVENT_NUMBER(TRACE_CATEGORY_FLUSH, 0),
+	/* Args: METADATA_AREA_TYPE, METADATA_CLEAR_REASON_TYPE */
+	TRACE_EVENT_METADATA_CLEAR    = TRACE_EVENT_NUMBER(TRACE_CATEGORY_FLUSH, 1),
+
+	/* Args: physical page index, virtual page index */
+	TRACE_EVENT_GAMEPAK_PAGE_LOAD = TRACE_EVENT_NUMBER(TRACE_CATEGORY_GAMEPAK_PAGE, 0),
+	/* Args: virtual page index, physical page index being evicted */
+	TRACE_EVENT_GAMEPAK_PAGE_EVICT = TRACE_EVENT_NUMBER(TRACE_CATEGORY_GAMEPAK_PAGE, 1),
+
+	/* Args: DMA channel, source address, destination address */
+	TRACE_EVENT_DMA               = TRACE_EVENT_NUMBER(TRACE_CATEGORY_DMA, 0),
+
+	/* Args: IRQ_TYPE raised, IE, IF after raising it */
+	TRACE_EVENT_IRQ               = TRACE_EVENT_NUMBER(TRACE_CATEGORY_IRQ, 0),
+
+	/* Args: frames emulated so far, frames rendered so far */
+	TRACE_EVENT_FRAME_END         = TRACE_EVENT_NUMBER(TRACE_CATEGORY_FRAME, 0),
+};
+
+struct TraceEvent {
+	/* ReGBA_GetMonotonicTime at the time of the event, in nanoseconds. */
+	uint64_t Time;
+	uint32_t Event;
+	uint32_t Args[3];
+};
+
+/*
+ * A trace file is made of TRACE_FILE_MAGIC, then a uint32_t saying how many
+ * events follow, then the events from oldest to newest, in the byte order of
+ * the emulator.
+ */
+#define TRACE_FILE_MAGIC "ReGBATr1"
+
+#ifndef TRACE_DECODER
+
+/*
+ * Which categories are being recorded, as a bitmask of (1 << category).
+ * Use trace_set_categories to change it.
+ */
+extern uint32_t trace_categories;
+
+extern void trace_record(uint32_t Event, uint32_t Arg0, uint32_t Arg1, uint32_t Arg2);
+
+#define trace_event(event, arg0, arg1, arg2)                                  \
+  do                                                                          \
+  {                                                                           \
+    if (unlikely(trace_categories & (1 << TRACE_EVENT_CATEGORY(event))))      \
+      trace_record(event, arg0, arg1, arg2);                                  \
+  } while (0)                                                                 \
+
+/*
+ * Starts recording the given categories, and stops recording the others. The
+ * ring of events is allocated the first time a category is enabled, and
+ * events that are already in it are kept.
+ * Returns:
+ *   false if the ring could not be allocated, in which case no category is
+ *   being recorded; true otherwise.
+ */
+extern bool trace_set_categories(uint32_t Categories);
+
+/*
+ * Writes the events in the ring to a file, which tools/tracedump.c can read.
+ * Returns:
+ *   true if the file was written; false otherwise.
+ */
+extern bool trace_save(const char* Filename);
+
+#endif /* !TRACE_DECODER */
+
+#endif /* TRACE_H */
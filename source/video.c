@@ -812,7 +812,7 @@ void render_scanline_conditional_bitmap(uint32_t start, uint32_t end, uint16_t *
 {                                                                             \
   uint32_t vertical_pixel_offset = (vertical_offset % 8) *                    \
    tile_width_##color_depth;                                                  \
-  uint32_t vertical_pixel_flip =                                              \
+  int32_t vertical_pixel_flip =                                               \
    ((tile_size_##color_depth - tile_width_##color_depth) -                    \
    vertical_pixel_offset) - vertical_pixel_offset;                            \
   tile_extra_variables_##color_depth();                                       \
@@ -1066,42 +1066,59 @@ int32_t affine_reference_y[2];
     tile_ptr = tile_base + (map_base[map_offset] * 64);                       \
     last_map_offset = map_offset;                                             \
   }                                                                           \
-  tile_ptr = tile_base + (map_base[(pixel_x / 8)] * 64);                      \
   current_pixel = tile_ptr[(pixel_x % 8)];                                    \
   tile_8bpp_draw_##combine_op(0, none, 0, alpha_op);                          \
   affine_render_next(combine_op)                                              \
 
+#define affine_render_rotate_pixel(combine_op, alpha_op)                      \
+  map_offset = (pixel_x / 8) + ((pixel_y / 8) << map_pitch);                  \
+  if(map_offset != last_map_offset)                                           \
+  {                                                                           \
+    tile_ptr = tile_base + (map_base[map_offset] * 64);                       \
+    last_map_offset = map_offset;                                             \
+  }                                                                           \
+                                                                              \
+  current_pixel = tile_ptr[(pixel_x % 8) + ((pixel_y % 8) * 8)];              \
+  tile_8bpp_draw_##combine_op(0, none, 0, alpha_op);                          \
+  affine_render_next(combine_op)                                              \
+
+// For backgrounds that don't wrap, the pixels that fall inside the map are
+// worked out up front with affine_clip_span. The ones before them are filled
+// with the backdrop (or skipped, if transparent) without looking at the map,
+// the ones inside are drawn without bounds checks, and the ones after them
+// are the remainder.
+
+#define affine_render_clip()                                                  \
+  uint32_t visible_start = 0, visible_end = end;                              \
+  affine_clip_span(source_x, dx, width_height, &visible_start, &visible_end); \
+  affine_clip_span(source_y, dy, width_height, &visible_start, &visible_end)  \
+
+#define affine_render_outside(combine_op, alpha_op)                           \
+  affine_render_bg_pixel_##combine_op(alpha_op);                              \
+  for(i = 0; i < visible_start; i++)                                          \
+  {                                                                           \
+    affine_render_bg_##combine_op(alpha_op);                                  \
+    advance_dest_ptr_##combine_op(1);                                         \
+  }                                                                           \
+  source_x += visible_start * dx;                                             \
+  source_y += visible_start * dy                                              \
+
 #define affine_render_scale(combine_op, alpha_op)                             \
 {                                                                             \
-  pixel_y = source_y >> 8;                                                    \
-  uint32_t i = 0;                                                             \
-  affine_render_bg_pixel_##combine_op(alpha_op);                              \
-  if((uint32_t)pixel_y < (uint32_t)width_height)                              \
+  affine_render_clip();                                                       \
+  affine_render_outside(combine_op, alpha_op);                                \
+                                                                              \
+  if(visible_start < visible_end)                                             \
   {                                                                           \
+    pixel_y = source_y >> 8;                                                  \
     affine_render_scale_offset();                                             \
-    for(; i < end; i++)                                                       \
-    {                                                                         \
-      pixel_x = source_x >> 8;                                                \
-                                                                              \
-      if((uint32_t)pixel_x < (uint32_t)width_height)                          \
-      {                                                                       \
-        break;                                                                \
-      }                                                                       \
-                                                                              \
-      affine_render_bg_##combine_op(alpha_op);                                \
-      affine_render_next(combine_op);                                         \
-    }                                                                         \
-                                                                              \
-    for(; i < end; i++)                                                       \
+    for(; i < visible_end; i++)                                               \
     {                                                                         \
       pixel_x = source_x >> 8;                                                \
-                                                                              \
-      if((uint32_t)pixel_x >= (uint32_t)width_height)                         \
-        break;                                                                \
-                                                                              \
       affine_render_scale_pixel(combine_op, alpha_op);                        \
     }                                                                         \
   }                                                                           \
+                                                                              \
   affine_render_bg_remainder_##combine_op(alpha_op);                          \
 }                                                                             \
 
@@ -1109,61 +1126,27 @@ int32_t affine_reference_y[2];
 {                                                                             \
   uint32_t wrap_mask = width_height - 1;                                      \
   pixel_y = (source_y >> 8) & wrap_mask;                                      \
-  if((uint32_t)pixel_y < (uint32_t)width_height)                              \
+  affine_render_scale_offset();                                               \
+  for(i = 0; i < end; i++)                                                    \
   {                                                                           \
-    affine_render_scale_offset();                                             \
-    for(i = 0; i < end; i++)                                                  \
-    {                                                                         \
-      pixel_x = (source_x >> 8) & wrap_mask;                                  \
-      affine_render_scale_pixel(combine_op, alpha_op);                        \
-    }                                                                         \
+    pixel_x = (source_x >> 8) & wrap_mask;                                    \
+    affine_render_scale_pixel(combine_op, alpha_op);                          \
   }                                                                           \
 }                                                                             \
 
-
-#define affine_render_rotate_pixel(combine_op, alpha_op)                      \
-  map_offset = (pixel_x / 8) + ((pixel_y / 8) << map_pitch);                  \
-  if(map_offset != last_map_offset)                                           \
-  {                                                                           \
-    tile_ptr = tile_base + (map_base[map_offset] * 64);                       \
-    last_map_offset = map_offset;                                             \
-  }                                                                           \
-                                                                              \
-  current_pixel = tile_ptr[(pixel_x % 8) + ((pixel_y % 8) * 8)];              \
-  tile_8bpp_draw_##combine_op(0, none, 0, alpha_op);                          \
-  affine_render_next(combine_op)                                              \
-
 #define affine_render_rotate(combine_op, alpha_op)                            \
 {                                                                             \
-  affine_render_bg_pixel_##combine_op(alpha_op);                              \
-  for(i = 0; i < end; i++)                                                    \
-  {                                                                           \
-    pixel_x = source_x >> 8;                                                  \
-    pixel_y = source_y >> 8;                                                  \
-                                                                              \
-    if(((uint32_t)pixel_x < (uint32_t)width_height) &&                        \
-     ((uint32_t)pixel_y < (uint32_t)width_height))                            \
-    {                                                                         \
-      break;                                                                  \
-    }                                                                         \
-    affine_render_bg_##combine_op(alpha_op);                                  \
-    affine_render_next(combine_op);                                           \
-  }                                                                           \
+  affine_render_clip();                                                       \
+  affine_render_outside(combine_op, alpha_op);                                \
                                                                               \
-  for(; i < end; i++)                                                         \
+  for(; i < visible_end; i++)                                                 \
   {                                                                           \
     pixel_x = source_x >> 8;                                                  \
     pixel_y = source_y >> 8;                                                  \
-                                                                              \
-    if(((uint32_t)pixel_x >= (uint32_t)width_height) ||                       \
-     ((uint32_t)pixel_y >= (uint32_t)width_height))                           \
-    {                                                                         \
-      affine_render_bg_remainder_##combine_op(alpha_op);                      \
-      break;                                                                  \
-    }                                                                         \
-                                                                              \
     affine_render_rotate_pixel(combine_op, alpha_op);                         \
   }                                                                           \
+                                                                              \
+  affine_render_bg_remainder_##combine_op(alpha_op);                          \
 }                                                                             \
 
 #define affine_render_rotate_wrap(combine_op, alpha_op)                       \
@@ -1178,6 +1161,53 @@ int32_t affine_reference_y[2];
   }                                                                           \
 }                                                                             \
 
+// Narrows [*visible_start, *visible_end) to the pixels i for which the
+// affine coordinate source + (i * delta), in 24.8 fixed point, falls within
+// [0, limit). Coordinates are linear in i, so those pixels are contiguous.
+static void affine_clip_span(int32_t source, int32_t delta, uint32_t limit,
+ uint32_t *visible_start, uint32_t *visible_end)
+{
+  int32_t fixed_limit = limit << 8;
+  int32_t first, last;
+
+  if(delta == 0)
+  {
+    if((source < 0) || (source >= fixed_limit))
+      *visible_end = *visible_start;
+    return;
+  }
+
+  if(delta > 0)
+  {
+    // source + i * delta >= 0 and < fixed_limit
+    first = (source >= 0) ? 0 : ((-source + delta - 1) / delta);
+    last = (source >= fixed_limit) ? 0 :
+     ((fixed_limit - source + delta - 1) / delta);
+  }
+  else
+  {
+    delta = -delta;
+    // source - i * delta < fixed_limit and >= 0
+    first = (source < fixed_limit) ? 0 :
+     ((source - fixed_limit) / delta + 1);
+    last = (source < 0) ? 0 : (source / delta + 1);
+  }
+
+  // Only ever narrow the span, so that it stays within the scanline even if
+  // the map starts or ends beyond it.
+  if((uint32_t)first < *visible_start)
+    first = *visible_start;
+  if((uint32_t)first > *visible_end)
+    first = *visible_end;
+  if((uint32_t)last > *visible_end)
+    last = *visible_end;
+  if(last < first)
+    last = first;
+
+  *visible_start = first;
+  *visible_end = last;
+}
+
 
 // Build affine background renderers.
 
@@ -1737,11 +1767,11 @@ bitmap_layer_render_struct bitmap_mode_renderers[3] =
 
 #define obj_render_affine(combine_op, color_depth, alpha_op, map_space)       \
 {                                                                             \
-  int16_t *params = (int16_t *)(oam_ram + (((obj_attribute_1 >> 9) & 0x1F) * 16)); \
-  int32_t dx = params[3];                                                     \
-  int32_t dmx = params[7];                                                    \
-  int32_t dy = params[11];                                                    \
-  int32_t dmy = params[15];                                                   \
+  obj_affine_struct *params = obj_affine_params + ((obj_attribute_1 >> 9) & 0x1F); \
+  int32_t dx = params->dx;                                                    \
+  int32_t dmx = params->dmx;                                                  \
+  int32_t dy = params->dy;                                                    \
+  int32_t dmy = params->dmy;                                                  \
   int32_t source_x, source_y;                                                 \
   int32_t tile_x, tile_y;                                                     \
   /*uint32_t tile_offset;*/                                                   \
@@ -1810,6 +1840,32 @@ FULLY_UNINITIALIZED(uint8_t obj_priority_list[5][160][128]);
 uint8_t obj_priority_count[5][160];
 uint8_t obj_alpha_count[160];
 
+// OAM, decoded by order_obj for the renderers. Only the entries of OBJs that
+// made it into obj_priority_list are filled in; the affine parameters are
+// decoded for all 32 groups.
+
+typedef struct
+{
+  int16_t x;
+  int16_t y;
+  uint8_t width;
+  uint8_t height;
+  uint16_t attribute_0;
+  uint16_t attribute_1;
+  uint16_t attribute_2;
+} obj_record_struct;
+
+typedef struct
+{
+  int32_t dx;
+  int32_t dmx;
+  int32_t dy;
+  int32_t dmy;
+} obj_affine_struct;
+
+obj_record_struct obj_records[128];
+obj_affine_struct obj_affine_params[32];
+
 
 // Build obj rendering functions
 
@@ -1955,7 +2011,6 @@ void render_scanline_obj_##alpha_op##_##map_space(uint32_t priority,          \
   render_scanline_obj_extra_variables_##alpha_op(map_space);                  \
   int32_t obj_num, i;                                                         \
   int32_t obj_x, obj_y;                                                       \
-  int32_t obj_size;                                                           \
   int32_t obj_width, obj_height;                                              \
   uint32_t obj_attribute_0, obj_attribute_1, obj_attribute_2;                 \
   int32_t vcount = io_registers[REG_VCOUNT];                                  \
@@ -1966,7 +2021,7 @@ void render_scanline_obj_##alpha_op##_##map_space(uint32_t priority,          \
   uint32_t vertical_offset;                                                   \
   uint32_t partial_tile_run, partial_tile_offset;                             \
   uint32_t pixel_run;                                                         \
-  uint16_t *oam_ptr;                                                          \
+  obj_record_struct *record;                                                  \
   render_scanline_dest_##alpha_op *dest_ptr;                                  \
   uint8_t *tile_base = vram + 0x10000;                                        \
   uint8_t *tile_ptr;                                                          \
@@ -1975,23 +2030,18 @@ void render_scanline_obj_##alpha_op##_##map_space(uint32_t priority,          \
                                                                               \
   for(obj_num = 0; obj_num < obj_count; obj_num++)                            \
   {                                                                           \
-    oam_ptr = oam_ram + (obj_list[obj_num] * 4);                              \
-    obj_attribute_0 = oam_ptr[0];                                             \
-    obj_attribute_1 = oam_ptr[1];                                             \
-    obj_attribute_2 = oam_ptr[2];                                             \
-    obj_size = ((obj_attribute_0 >> 12) & 0x0C) | (obj_attribute_1 >> 14);    \
+    record = obj_records + obj_list[obj_num];                                 \
+    obj_attribute_0 = record->attribute_0;                                    \
+    obj_attribute_1 = record->attribute_1;                                    \
+    obj_attribute_2 = record->attribute_2;                                    \
                                                                               \
-    obj_x = (int32_t)(obj_attribute_1 << 23) >> 23;                           \
-    obj_width = (int32_t)obj_width_table[obj_size];                           \
+    obj_x = record->x;                                                        \
+    obj_width = record->width;                                                \
                                                                               \
     render_scanline_obj_prologue_##combine_op(alpha_op);                      \
                                                                               \
-    obj_y = obj_attribute_0 & 0xFF;                                           \
-                                                                              \
-    if(obj_y > 160)                                                           \
-      obj_y -= 256;                                                           \
-                                                                              \
-    obj_height = obj_height_table[obj_size];                                  \
+    obj_y = record->y;                                                        \
+    obj_height = record->height;                                              \
     render_scanline_obj_##partial_alpha_op(combine_op, alpha_op, map_space);  \
   }                                                                           \
 }                                                                             \
@@ -2029,6 +2079,15 @@ void order_obj(uint32_t video_mode)
   memset( obj_priority_count, 0, sizeof(obj_priority_count) );
   memset( obj_alpha_count, 0, sizeof(obj_alpha_count) );
 
+  for(obj_num = 0; obj_num < 32; obj_num++)
+  {
+    int16_t *params = (int16_t *)(oam_ram + (obj_num * 16));
+    obj_affine_params[obj_num].dx = params[3];
+    obj_affine_params[obj_num].dmx = params[7];
+    obj_affine_params[obj_num].dy = params[11];
+    obj_affine_params[obj_num].dmy = params[15];
+  }
+
   for(obj_num = 127; obj_num >= 0; obj_num--, oam_ptr -= 4)
   {
     obj_attribute_0 = oam_ptr[0];
@@ -2061,6 +2120,15 @@ void order_obj(uint32_t video_mode)
 
         if(((obj_x + obj_width) > 0) && (obj_x < 240))
         {
+          obj_record_struct *record = obj_records + obj_num;
+          record->x = obj_x;
+          record->y = obj_y;
+          record->width = obj_width_table[obj_size];
+          record->height = obj_height_table[obj_size];
+          record->attribute_0 = obj_attribute_0;
+          record->attribute_1 = obj_attribute_1;
+          record->attribute_2 = obj_attribute_2;
+
           if(obj_y < 0)
           {
             obj_height += obj_y;
@@ -2618,6 +2686,41 @@ void render_scanline_tile(uint16_t *scanline, uint32_t dispcnt)
    render_condition_alpha, render_condition_fade, 0, 240);
 }
 
+// Renders a scanline in which BG2 is alone and has an identity matrix, with
+// its left edge at the left of the screen, as in FMV and GBA Video
+// cartridges. Mode 3 is then a copy of a line of VRAM, and mode 4 a palette
+// lookup per pixel; index 0 looks up the backdrop, as it should. Returns
+// non-zero if it could.
+static uint32_t render_scanline_bitmap_direct(uint16_t *scanline,
+ uint32_t dispcnt)
+{
+  int32_t pixel_y = affine_reference_y[0] >> 8;
+  uint8_t *src_ptr;
+  uint32_t i;
+
+  if((io_registers[REG_BG2PA] != 0x100) || (io_registers[REG_BG2PC] != 0) ||
+   ((affine_reference_x[0] >> 8) != 0) || ((uint32_t)pixel_y >= 160))
+    return 0;
+
+  switch(dispcnt & 0x07)
+  {
+    case 3:
+      memcpy(scanline, vram + (pixel_y * 240 * 2), 240 * 2);
+      return 1;
+
+    case 4:
+      src_ptr = vram + (pixel_y * 240);
+      if(dispcnt & 0x10)
+        src_ptr += 0xA000;
+
+      for(i = 0; i < 240; i++)
+        scanline[i] = palette_ram[src_ptr[i]];
+      return 1;
+  }
+
+  return 0;
+}
+
 // VIDEO MODE 3,4,5/非ウィンドウモード時の描画
 void render_scanline_bitmap(uint16_t *scanline, uint32_t dispcnt)
 {
@@ -2626,6 +2729,10 @@ void render_scanline_bitmap(uint16_t *scanline, uint32_t dispcnt)
   uint8_t current_layer;
   uint8_t layer_order_pos;
 
+  if((layer_count == 1) && (layer_order[0] == 2) &&
+   render_scanline_bitmap_direct(scanline, dispcnt))
+    return;
+
   fill_line_bg(normal, scanline, 0, 240);
 
   for(layer_order_pos = 0; layer_order_pos < layer_count; layer_order_pos++)
@@ -2785,300 +2892,194 @@ void render_scanline_conditional_bitmap(uint32_t start, uint32_t end, uint16_t *
 }
 
 
-#define window_x_coords(window_number)                                        \
-  window_##window_number##_x1 =                                               \
-   io_registers[REG_WIN##window_number##H] >> 8;                              \
-  window_##window_number##_x2 =                                               \
-   io_registers[REG_WIN##window_number##H] & 0xFF;                            \
-  window_##window_number##_enable =                                           \
-   (winin >> (window_number * 8)) & 0x3F;                                     \
-                                                                              \
-  if(window_##window_number##_x1 > 240)                                       \
-    window_##window_number##_x1 = 240;                                        \
-                                                                              \
-  if(window_##window_number##_x2 > 240)                                       \
-    window_##window_number##_x2 = 240                                         \
+// Windows are resolved into a list of spans, each of which is rendered with
+// one call to render_scanline_conditional_*. A span has the layer and color
+// effect enable flags of the window covering it (WININ or WINOUT), and spans
+// that are outside windows 0 and 1 also get the OBJ window drawn over them
+// if it is enabled. Adjacent spans with the same flags are merged.
+//
+// The spans only change when the windows' horizontal coordinates, their
+// vertical coverage of the line, WININ, WINOUT or the enabled windows do, so
+// the list is kept from one scanline to the next until one of those changes.
 
-#define window_coords(window_number)                                          \
-  uint32_t window_##window_number##_x1, window_##window_number##_x2;          \
-  uint32_t window_##window_number##_y1, window_##window_number##_y2;          \
-  uint32_t window_##window_number##_enable = 0;                               \
-  window_##window_number##_y1 =                                               \
-   io_registers[REG_WIN##window_number##V] >> 8;                              \
-  window_##window_number##_y2 =                                               \
-   io_registers[REG_WIN##window_number##V] & 0xFF;                            \
-                                                                              \
-  if(window_##window_number##_y1 > window_##window_number##_y2)               \
-  {                                                                           \
-    if((((vcount <= window_##window_number##_y2) ||                           \
-     (vcount > window_##window_number##_y1)) ||                               \
-     (window_##window_number##_y2 > 227)) &&                                  \
-     (window_##window_number##_y1 <= 227))                                    \
-    {                                                                         \
-      window_x_coords(window_number);                                         \
-    }                                                                         \
-    else                                                                      \
-    {                                                                         \
-      window_##window_number##_x1 = 240;                                      \
-      window_##window_number##_x2 = 240;                                      \
-    }                                                                         \
-  }                                                                           \
-  else                                                                        \
-  {                                                                           \
-    if((((vcount >= window_##window_number##_y1) &&                           \
-     (vcount < window_##window_number##_y2)) ||                               \
-     (window_##window_number##_y2 > 227)) &&                                  \
-     (window_##window_number##_y1 <= 227))                                    \
-    {                                                                         \
-      window_x_coords(window_number);                                         \
-    }                                                                         \
-    else                                                                      \
-    {                                                                         \
-      window_##window_number##_x1 = 240;                                      \
-      window_##window_number##_x2 = 240;                                      \
-    }                                                                         \
-  }                                                                           \
+typedef struct
+{
+  uint8_t start;
+  uint8_t end;
+  uint8_t enable;
+  uint8_t obj_window;
+} window_span_struct;
 
-#define render_window_segment(type, start, end, window_type)                  \
-  if(start != end)                                                            \
-  {                                                                           \
-    render_scanline_conditional_##type(start, end, scanline,                  \
-     window_##window_type##_enable, dispcnt, bldcnt, layer_renderers);        \
-  }                                                                           \
+typedef struct
+{
+  uint8_t x1[2];
+  uint8_t x2[2];
+  uint16_t winin;
+  uint8_t winout;
+  uint8_t windows;
+} window_config_struct;
+
+// At most 5 boundaries from two windows split the line into 5 spans.
+static window_span_struct window_spans[5];
+static uint32_t window_span_count;
+static window_config_struct window_spans_config;
+static uint32_t window_spans_valid;
+
+// Gets the horizontal coordinates of a window, or 240 for both if it doesn't
+// cover the current line.
+static void window_coords(window_config_struct *config,
+ uint32_t window_number, uint32_t vcount)
+{
+  uint32_t y1 = io_registers[REG_WIN0V + window_number] >> 8;
+  uint32_t y2 = io_registers[REG_WIN0V + window_number] & 0xFF;
+  uint32_t x1 = io_registers[REG_WIN0H + window_number] >> 8;
+  uint32_t x2 = io_registers[REG_WIN0H + window_number] & 0xFF;
+  uint32_t inside;
+
+  if(y1 > y2)
+    inside = (vcount <= y2) || (vcount > y1);
+  else
+    inside = (vcount >= y1) && (vcount < y2);
 
-#define render_window_segment_unequal(type, start, end, window_type)          \
-  render_scanline_conditional_##type(start, end, scanline,                    \
-   window_##window_type##_enable, dispcnt, bldcnt, layer_renderers)           \
+  if((inside || (y2 > 227)) && (y1 <= 227))
+  {
+    config->x1[window_number] = (x1 > 240) ? 240 : x1;
+    config->x2[window_number] = (x2 > 240) ? 240 : x2;
+  }
+  else
+  {
+    config->x1[window_number] = 240;
+    config->x2[window_number] = 240;
+  }
+}
 
-#define render_window_segment_clip(type, clip_start, clip_end, start, end,    \
- window_type)                                                                 \
-{                                                                             \
-  if(start != end)                                                            \
-  {                                                                           \
-    if(start < clip_start)                                                    \
-    {                                                                         \
-      if(end > clip_start)                                                    \
-      {                                                                       \
-        if(end > clip_end)                                                    \
-        {                                                                     \
-          render_window_segment_unequal(type, clip_start, clip_end,           \
-           window_type);                                                      \
-        }                                                                     \
-        else                                                                  \
-        {                                                                     \
-          render_window_segment_unequal(type, clip_start, end, window_type);  \
-        }                                                                     \
-      }                                                                       \
-    }                                                                         \
-    else                                                                      \
-                                                                              \
-    if(end > clip_end)                                                        \
-    {                                                                         \
-      if(start < clip_end)                                                    \
-        render_window_segment_unequal(type, start, clip_end, window_type);    \
-    }                                                                         \
-    else                                                                      \
-    {                                                                         \
-      render_window_segment_unequal(type, start, end, window_type);           \
-    }                                                                         \
-  }                                                                           \
-}                                                                             \
+static uint32_t window_contains(window_config_struct *config,
+ uint32_t window_number, uint32_t x)
+{
+  uint32_t x1 = config->x1[window_number];
+  uint32_t x2 = config->x2[window_number];
 
-#define render_window_clip_1(type, start, end)                                \
-  if(window_1_x1 != 240)                                                      \
-  {                                                                           \
-    if(window_1_x1 > window_1_x2)                                             \
-    {                                                                         \
-      render_window_segment_clip(type, start, end, 0, window_1_x2, 1);        \
-      render_window_segment_clip(type, start, end, window_1_x2, window_1_x1,  \
-       out);                                                                  \
-      render_window_segment_clip(type, start, end, window_1_x1, 240, 1);      \
-    }                                                                         \
-    else                                                                      \
-    {                                                                         \
-      render_window_segment_clip(type, start, end, 0, window_1_x1, out);      \
-      render_window_segment_clip(type, start, end, window_1_x1, window_1_x2,  \
-       1);                                                                    \
-      render_window_segment_clip(type, start, end, window_1_x2, 240, out);    \
-    }                                                                         \
-  }                                                                           \
-  else                                                                        \
-  {                                                                           \
-    render_window_segment(type, start, end, out);                             \
-  }                                                                           \
+  if(x1 > x2)
+    return (x < x2) || (x >= x1);
+  else
+    return (x >= x1) && (x < x2);
+}
 
-#define render_window_clip_obj(type, start, end);                             \
-  render_window_segment(type, start, end, out);                               \
-  if(dispcnt & 0x40)                                                          \
-    render_scanline_obj_copy_##type##_1D(4, start, end, scanline);            \
-  else                                                                        \
-    render_scanline_obj_copy_##type##_2D(4, start, end, scanline)             \
+static void update_window_spans(uint32_t dispcnt, uint32_t vcount)
+{
+  window_config_struct config;
+  uint8_t boundaries[6];
+  uint32_t boundary_count = 0;
+  uint32_t i, j;
 
+  memset(&config, 0, sizeof(config));
+  config.windows = dispcnt >> 13;
+  config.winin = io_registers[REG_WININ];
+  config.winout = io_registers[REG_WINOUT] & 0x3F;
 
-#define render_window_segment_clip_obj(type, clip_start, clip_end, start,     \
- end)                                                                         \
-{                                                                             \
-  if(start != end)                                                            \
-  {                                                                           \
-    if(start < clip_start)                                                    \
-    {                                                                         \
-      if(end > clip_start)                                                    \
-      {                                                                       \
-        if(end > clip_end)                                                    \
-        {                                                                     \
-          render_window_clip_obj(type, clip_start, clip_end);                 \
-        }                                                                     \
-        else                                                                  \
-        {                                                                     \
-          render_window_clip_obj(type, clip_start, end);                      \
-        }                                                                     \
-      }                                                                       \
-    }                                                                         \
-    else                                                                      \
-                                                                              \
-    if(end > clip_end)                                                        \
-    {                                                                         \
-      if(start < clip_end)                                                    \
-      {                                                                       \
-        render_window_clip_obj(type, start, clip_end);                        \
-      }                                                                       \
-    }                                                                         \
-    else                                                                      \
-    {                                                                         \
-      render_window_clip_obj(type, start, end);                               \
-    }                                                                         \
-  }                                                                           \
-}                                                                             \
+  for(i = 0; i < 2; i++)
+  {
+    if(config.windows & (1 << i))
+    {
+      window_coords(&config, i, vcount);
+      boundaries[boundary_count++] = config.x1[i];
+      boundaries[boundary_count++] = config.x2[i];
+    }
+  }
 
+  if(window_spans_valid &&
+   (memcmp(&config, &window_spans_config, sizeof(config)) == 0))
+    return;
 
-#define render_window_clip_1_obj(type, start, end)                            \
-  if(window_1_x1 != 240)                                                      \
-  {                                                                           \
-    if(window_1_x1 > window_1_x2)                                             \
-    {                                                                         \
-      render_window_segment_clip(type, start, end, 0, window_1_x2, 1);        \
-      render_window_segment_clip_obj(type, start, end, window_1_x2,           \
-       window_1_x1);                                                          \
-      render_window_segment_clip(type, start, end, window_1_x1, 240, 1);      \
-    }                                                                         \
-    else                                                                      \
-    {                                                                         \
-      render_window_segment_clip_obj(type, start, end, 0, window_1_x1);       \
-      render_window_segment_clip(type, start, end, window_1_x1, window_1_x2,  \
-       1);                                                                    \
-      render_window_segment_clip_obj(type, start, end, window_1_x2, 240);     \
-    }                                                                         \
-  }                                                                           \
-  else                                                                        \
-  {                                                                           \
-    render_window_clip_obj(type, start, end);                                 \
-  }                                                                           \
+  window_spans_config = config;
+  window_spans_valid = 1;
 
-#define render_window_single(type, window_number)                             \
-  uint32_t winin = io_registers[REG_WININ];                                   \
-  window_coords(window_number);                                               \
-  if(window_##window_number##_x1 > window_##window_number##_x2)               \
-  {                                                                           \
-    render_window_segment(type, 0, window_##window_number##_x2,               \
-     window_number);                                                          \
-    render_window_segment(type, window_##window_number##_x2,                  \
-     window_##window_number##_x1, out);                                       \
-    render_window_segment(type, window_##window_number##_x1, 240,             \
-     window_number);                                                          \
-  }                                                                           \
-  else                                                                        \
-  {                                                                           \
-    render_window_segment(type, 0, window_##window_number##_x1, out);         \
-    render_window_segment(type, window_##window_number##_x1,                  \
-     window_##window_number##_x2, window_number);                             \
-    render_window_segment(type, window_##window_number##_x2, 240, out);       \
-  }                                                                           \
+  // Sort the boundaries; there are at most 4.
+  for(i = 1; i < boundary_count; i++)
+  {
+    for(j = i; (j > 0) && (boundaries[j - 1] > boundaries[j]); j--)
+    {
+      uint8_t temp = boundaries[j];
+      boundaries[j] = boundaries[j - 1];
+      boundaries[j - 1] = temp;
+    }
+  }
+  boundaries[boundary_count++] = 240;
 
-#define render_window_multi(type, front, back)                                \
-  if(window_##front##_x1 > window_##front##_x2)                               \
-  {                                                                           \
-    render_window_segment(type, 0, window_##front##_x2, front);               \
-    render_window_clip_##back(type, window_##front##_x2,                      \
-     window_##front##_x1);                                                    \
-    render_window_segment(type, window_##front##_x1, 240, front);             \
-  }                                                                           \
-  else                                                                        \
-  {                                                                           \
-    render_window_clip_##back(type, 0, window_##front##_x1);                  \
-    render_window_segment(type, window_##front##_x1, window_##front##_x2,     \
-     front);                                                                  \
-    render_window_clip_##back(type, window_##front##_x2, 240);                \
-  }                                                                           \
+  window_span_count = 0;
+
+  uint32_t start = 0;
+  for(i = 0; i < boundary_count; i++)
+  {
+    uint32_t end = boundaries[i];
+    uint32_t enable, obj_window;
+
+    if(end <= start)
+      continue;
+
+    // Window 0 has priority over window 1, and both over the OBJ window.
+    if((config.windows & 0x01) && window_contains(&config, 0, start))
+    {
+      enable = config.winin & 0x3F;
+      obj_window = 0;
+    }
+    else
+
+    if((config.windows & 0x02) && window_contains(&config, 1, start))
+    {
+      enable = (config.winin >> 8) & 0x3F;
+      obj_window = 0;
+    }
+    else
+    {
+      enable = config.winout;
+      obj_window = (config.windows & 0x04) != 0;
+    }
+
+    if((window_span_count != 0) &&
+     (window_spans[window_span_count - 1].enable == enable) &&
+     (window_spans[window_span_count - 1].obj_window == obj_window))
+    {
+      window_spans[window_span_count - 1].end = end;
+    }
+    else
+    {
+      window_spans[window_span_count].start = start;
+      window_spans[window_span_count].end = end;
+      window_spans[window_span_count].enable = enable;
+      window_spans[window_span_count].obj_window = obj_window;
+      window_span_count++;
+    }
+
+    start = end;
+  }
+}
 
 #define render_scanline_window_builder(type)                                  \
 void render_scanline_window_##type(uint16_t *scanline, uint32_t dispcnt)      \
 {                                                                             \
   uint32_t vcount = io_registers[REG_VCOUNT];                                 \
-  uint32_t winout = io_registers[REG_WINOUT];                                 \
   uint32_t bldcnt = io_registers[REG_BLDCNT];                                 \
-  uint32_t window_out_enable = winout & 0x3F;                                 \
+  uint32_t i;                                                                 \
                                                                               \
   render_scanline_layer_functions_##type();                                   \
                                                                               \
-  switch(dispcnt >> 13)                                                       \
-  {                                                                           \
-    /* Just window 0 */                                                       \
-    case 0x01:                                                                \
-    {                                                                         \
-      render_window_single(type, 0);                                          \
-      break;                                                                  \
-    }                                                                         \
+  update_window_spans(dispcnt, vcount);                                       \
                                                                               \
-    /* Just window 1 */                                                       \
-    case 0x02:                                                                \
-    {                                                                         \
-      render_window_single(type, 1);                                          \
-      break;                                                                  \
-    }                                                                         \
-                                                                              \
-    /* Windows 1 and 2 */                                                     \
-    case 0x03:                                                                \
-    {                                                                         \
-      uint32_t winin = io_registers[REG_WININ];                               \
-      window_coords(0);                                                       \
-      window_coords(1);                                                       \
-      render_window_multi(type, 0, 1);                                        \
-      break;                                                                  \
-    }                                                                         \
-                                                                              \
-    /* Just OBJ windows */                                                    \
-    case 0x04:                                                                \
-    {                                                                         \
-      render_window_clip_obj(type, 0, 240);                                   \
-      break;                                                                  \
-    }                                                                         \
-                                                                              \
-    /* Window 0 and OBJ window */                                             \
-    case 0x05:                                                                \
-    {                                                                         \
-      uint32_t winin = io_registers[REG_WININ];                               \
-      window_coords(0);                                                       \
-      render_window_multi(type, 0, obj);                                      \
-      break;                                                                  \
-    }                                                                         \
+  for(i = 0; i < window_span_count; i++)                                      \
+  {                                                                           \
+    uint32_t start = window_spans[i].start;                                   \
+    uint32_t end = window_spans[i].end;                                       \
                                                                               \
-    /* Window 1 and OBJ window */                                             \
-    case 0x06:                                                                \
-    {                                                                         \
-      uint32_t winin = io_registers[REG_WININ];                               \
-      window_coords(1);                                                       \
-      render_window_multi(type, 1, obj);                                      \
-      break;                                                                  \
-    }                                                                         \
+    render_scanline_conditional_##type(start, end, scanline,                  \
+     window_spans[i].enable, dispcnt, bldcnt, layer_renderers);               \
                                                                               \
-    /* Window 0, 1, and OBJ window */                                         \
-    case 0x07:                                                                \
+    if(window_spans[i].obj_window)                                            \
     {                                                                         \
-      uint32_t winin = io_registers[REG_WININ];                               \
-      window_coords(0);                                                       \
-      window_coords(1);                                                       \
-      render_window_multi(type, 0, 1_obj);                                    \
-      break;                                                                  \
+      if(dispcnt & 0x40)                                                      \
+        render_scanline_obj_copy_##type##_1D(4, start, end, scanline);        \
+      else                                                                    \
+        render_scanline_obj_copy_##type##_2D(4, start, end, scanline);        \
     }                                                                         \
   }                                                                           \
 }                                                                             \
@@ -3091,22 +3092,244 @@ const uint8_t active_layers[6] = { 0x1F, 0x17, 0x1C, 0x14, 0x14, 0x14 };
 
 // uint32_t resolution_width, resolution_height;
 
-// 渲染一行图像
-void update_scanline()
+// Everything a scanline's pixels depend on, apart from video memory.
+typedef struct
 {
-  if (!ReGBA_IsRenderingNextFrame())
-    return;
-  uint32_t  dispcnt = io_registers[REG_DISPCNT];
-  uint32_t  vcount = io_registers[REG_VCOUNT];              // (0~277)
+  int32_t affine_reference_x[2];
+  int32_t affine_reference_y[2];
+  uint16_t dispcnt;
+  uint16_t registers[REG_BLDY - REG_BG0CNT + 1];  // BG, window and blending
+} scanline_state_struct;
+
+// A scanline to be rendered, or as it was last rendered. Video memory is
+// too large to keep in each record, so it is covered by generations.
+// vram_generation changes whenever VRAM is written (vram_update). Palette RAM
+// and OAM are compared with their copies below when they are written
+// (palette_update, oam_update), and their generations only change if their
+// contents did, so games that copy the same palette and sprites over in
+// every VBlank still skip lines.
+typedef struct
+{
+  uint16_t *screen_offset;
+  uint32_t vram_generation;
+  uint32_t palette_generation;
+  uint32_t oam_generation;      // 0 if neither OBJ nor the OBJ window is on
+  scanline_state_struct state;
+} scanline_record_struct;
+
+// If a scanline comes up with the same record it was last rendered with, and
+// so in the same place in GBAScreen, the pixels there are already right and
+// the line can be skipped. This makes static screens (menus, text boxes,
+// pauses) nearly free.
+//
+// Ports that flip between screen buffers (dstwo) draw each line in a
+// different place every frame, so each line keeps a record for each of
+// SCANLINE_RECORD_SETS buffers, and the one for the buffer it was rendered
+// into least recently is replaced.
+#define SCANLINE_RECORD_SETS 2
+
+static scanline_record_struct
+ scanline_records[SCANLINE_RECORD_SETS][GBA_SCREEN_HEIGHT];
+static uint8_t scanline_record_last_set[GBA_SCREEN_HEIGHT];
+
+static uint32_t vram_generation = 1;
+static uint32_t palette_generation = 1;
+static uint32_t oam_generation = 1;
+static uint16_t palette_ram_compared[0x200];
+static uint16_t oam_ram_compared[0x200];
+
+static uint32_t obj_order_stale = 1;
+static uint32_t obj_order_video_mode;
+
+// Deferred rendering. Instead of rendering each scanline at its HBlank, in
+// between bits of CPU emulation, update_scanline only logs its record, and
+// the whole frame is rendered in one pass at the last visible line. This
+// keeps the renderers and their data in the host's caches.
+//
+// Writes to video memory in the middle of a frame would make the logged
+// lines render with the wrong data, so video memory is copied right before
+// the first such write, through prepare_video_memory_write. Most frames
+// don't write to video memory while it is displayed, and never pay for the
+// copy. If a frame does, the lines logged so far are rendered against the
+// copy, and the rest of the frame is rendered line by line. Frames that
+// follow a frame with such writes aren't deferred, so games with raster
+// effects don't keep copying video memory.
+uint32_t deferred_rendering = 0;
+uint32_t video_snapshot_pending = 0;
+
+static scanline_record_struct deferred_lines[GBA_SCREEN_HEIGHT];
+static uint32_t deferred_line_count;
+static uint32_t deferring_frame;
+static uint32_t mid_frame_writes;
+static uint32_t video_snapshot_taken;
+
+// Headless mode. Scanlines are not rendered, except for whole frames asked
+// for with request_headless_frame, which start at the next line 0. Lines that
+// are skipped leave vram_update, palette_update and oam_update set, so the
+// next frame that is rendered still sees that video memory changed.
+uint32_t headless_mode = 0;
+uint32_t headless_frames_rendered = 0;
+
+static uint32_t headless_frame_requested;
+static uint32_t headless_frame_rendering;
+
+void request_headless_frame()
+{
+  headless_frame_requested = 1;
+}
+
+// PPU state dump asked for with ppu_dump_open. It is written while
+// ppu_dump_active is set, one line at a time, as the lines are rendered.
+static FILE *ppu_dump_file;
+static uint32_t ppu_dump_frames;
+static uint32_t ppu_dump_active;
+
+bool ppu_dump_open(const char *path, uint32_t frames)
+{
+  if(ppu_dump_file != NULL)
+    fclose(ppu_dump_file);
+
+  ppu_dump_file = fopen(path, "wb");
+  ppu_dump_frames = frames;
+  ppu_dump_active = 0;
+  return ppu_dump_file != NULL;
+}
+
+static void ppu_dump_scanline(uint32_t vcount)
+{
+  ppu_dump_line_struct line;
+
+  if(vcount == 0)
+  {
+    fwrite(PPU_DUMP_MAGIC, 1, 16, ppu_dump_file);
+    fwrite(palette_ram, 1, sizeof(palette_ram), ppu_dump_file);
+    fwrite(oam_ram, 1, sizeof(oam_ram), ppu_dump_file);
+    fwrite(vram, 1, sizeof(vram), ppu_dump_file);
+    fwrite(io_registers, 1, 0x400, ppu_dump_file);
+  }
+
+  memset(&line, 0, sizeof(line));
+  memcpy(line.affine_reference_x, affine_reference_x,
+   sizeof(line.affine_reference_x));
+  memcpy(line.affine_reference_y, affine_reference_y,
+   sizeof(line.affine_reference_y));
+  memcpy(line.registers, io_registers, sizeof(line.registers));
+  fwrite(&line, 1, sizeof(line), ppu_dump_file);
+
+  if(vcount == (GBA_SCREEN_HEIGHT - 1))
+  {
+    fclose(ppu_dump_file);
+    ppu_dump_file = NULL;
+    ppu_dump_active = 0;
+  }
+}
+
+static uint16_t palette_ram_copy[0x200];
+static uint16_t oam_ram_copy[0x200];
+static uint8_t  vram_copy[0x18000];
+
+static void save_scanline_state(scanline_state_struct *state)
+{
+  state->affine_reference_x[0] = affine_reference_x[0];
+  state->affine_reference_y[0] = affine_reference_y[0];
+  state->affine_reference_x[1] = affine_reference_x[1];
+  state->affine_reference_y[1] = affine_reference_y[1];
+  state->dispcnt = io_registers[REG_DISPCNT];
+  memcpy(state->registers, &io_registers[REG_BG0CNT],
+   sizeof(state->registers));
+}
+
+static void load_scanline_state(const scanline_state_struct *state)
+{
+  affine_reference_x[0] = state->affine_reference_x[0];
+  affine_reference_y[0] = state->affine_reference_y[0];
+  affine_reference_x[1] = state->affine_reference_x[1];
+  affine_reference_y[1] = state->affine_reference_y[1];
+  io_registers[REG_DISPCNT] = state->dispcnt;
+  memcpy(&io_registers[REG_BG0CNT], state->registers,
+   sizeof(state->registers));
+}
+
+// Copies video memory as the logged lines need it, before the first write
+// to it in a deferred frame.
+void take_video_snapshot()
+{
+  memcpy(palette_ram_copy, palette_ram, sizeof(palette_ram_copy));
+  memcpy(oam_ram_copy, oam_ram, sizeof(oam_ram_copy));
+  memcpy(vram_copy, vram, sizeof(vram_copy));
+  video_snapshot_pending = 0;
+  video_snapshot_taken = 1;
+}
+
+static void swap_words(uint32_t *a, uint32_t *b, uint32_t size)
+{
+  uint32_t i;
+
+  for(i = 0; i < size / 4; i++)
+  {
+    uint32_t temp = a[i];
+    a[i] = b[i];
+    b[i] = temp;
+  }
+}
+
+// Exchanges video memory with the copy taken by take_video_snapshot.
+static void swap_video_memory()
+{
+  swap_words((uint32_t *)palette_ram, (uint32_t *)palette_ram_copy,
+   sizeof(palette_ram_copy));
+  swap_words((uint32_t *)oam_ram, (uint32_t *)oam_ram_copy,
+   sizeof(oam_ram_copy));
+  swap_words((uint32_t *)vram, (uint32_t *)vram_copy, sizeof(vram_copy));
+  obj_order_stale = 1;
+}
+
+// Renders a scanline according to its record, unless that is the record it
+// was last rendered with. The state it describes must be loaded.
+static void render_scanline_record(uint32_t vcount,
+ const scanline_record_struct *record)
+{
+  scanline_record_struct *last;
+  uint32_t  dispcnt = record->state.dispcnt;
   uint32_t  video_mode = dispcnt & 0x07;                    // (0~5)
-  uint32_t  pitch = GBAScreenPitch;
-  uint16_t* screen_offset = GBAScreen + (vcount * pitch);
+  uint16_t* screen_offset = record->screen_offset;
+  uint32_t  set;
+
+  for(set = 0; set < SCANLINE_RECORD_SETS; set++)
+  {
+    if(scanline_records[set][vcount].screen_offset == screen_offset)
+      break;
+  }
+
+  if(set == SCANLINE_RECORD_SETS)
+    set = (scanline_record_last_set[vcount] + 1) % SCANLINE_RECORD_SETS;
+
+  scanline_record_last_set[vcount] = set;
+  last = &scanline_records[set][vcount];
+
+  if((last->screen_offset == screen_offset) &&
+   (last->vram_generation == record->vram_generation) &&
+   (last->palette_generation == record->palette_generation) &&
+   (last->oam_generation == record->oam_generation) &&
+   (memcmp(&last->state, &record->state, sizeof(record->state)) == 0))
+  {
+    if(unlikely(PerformanceCounters))
+      Stats.ScanlinesSkipped++;
+    return;
+  }
+
+  *last = *record;
+
+  uint64_t render_start = 0;
+  if(unlikely(PerformanceCounters))
+    render_start = ReGBA_GetMonotonicTime();
 
   // 如果 OAM 有变化，对其维护，排序
-  if(oam_update)
+  if(obj_order_stale || (video_mode != obj_order_video_mode))
   {
     order_obj(video_mode);
-    oam_update = 0;
+    obj_order_stale = 0;
+    obj_order_video_mode = video_mode;
   }
 
   // 重新排列图层
@@ -3145,10 +3368,218 @@ void update_scanline()
     }
   }
 
+  if(unlikely(PerformanceCounters))
+  {
+    Stats.ScanlineRenderTime[video_mode] +=
+     ReGBA_GetMonotonicTime() - render_start;
+    Stats.ScanlinesRendered[video_mode]++;
+  }
+}
+
+// Renders the scanlines logged so far in the current frame.
+static void render_deferred_lines()
+{
+  scanline_state_struct live_state;
+  uint16_t live_vcount = io_registers[REG_VCOUNT];
+  uint32_t i;
+
+  save_scanline_state(&live_state);
+
+  for(i = 0; i < deferred_line_count; i++)
+  {
+    load_scanline_state(&deferred_lines[i].state);
+    io_registers[REG_VCOUNT] = i;
+    render_scanline_record(i, &deferred_lines[i]);
+  }
+
+  load_scanline_state(&live_state);
+  io_registers[REG_VCOUNT] = live_vcount;
+  deferred_line_count = 0;
+}
+
+static void stop_deferring()
+{
+  deferring_frame = 0;
+  video_snapshot_pending = 0;
+}
+
+// Bumps generation if memory differs from the copy taken when it last did.
+static uint32_t compare_video_memory(uint16_t *copy, const uint16_t *memory,
+ uint32_t *generation)
+{
+  if(memcmp(copy, memory, 0x400) == 0)
+    return 0;
+
+  memcpy(copy, memory, 0x400);
+  (*generation)++;
+  return 1;
+}
+
+// Forgets all scanline records. Ports call this after drawing over GBAScreen
+// themselves, so that the next frame is rendered in full.
+void invalidate_scanline_records()
+{
+  memset(scanline_records, 0, sizeof(scanline_records));
+}
+
+// 渲染一行图像
+static void update_scanline_untimed()
+{
+  uint32_t  vcount = io_registers[REG_VCOUNT];              // (0~277)
+  uint32_t  pitch = GBAScreenPitch;
+  uint32_t  video_memory_written = 0;
+  scanline_record_struct record;
+
+  if(vcount >= GBA_SCREEN_HEIGHT)
+    return;
+
+  if((vcount == 0) && (ppu_dump_file != NULL))
+  {
+    if(ppu_dump_frames == 0)
+    {
+      ppu_dump_active = 1;
+      if(headless_mode)
+        headless_frame_requested = 1;
+    }
+    else
+      ppu_dump_frames--;
+  }
+
+  if(headless_mode)
+  {
+    if(!headless_frame_rendering)
+    {
+      if((vcount != 0) || !headless_frame_requested)
+        return;
+      headless_frame_requested = 0;
+      headless_frame_rendering = 1;
+    }
+  }
+  else
+
+  if(!ReGBA_IsRenderingNextFrame())
+    return;
+
+  if(oam_update)
+  {
+    oam_update = 0;
+    if(compare_video_memory(oam_ram_compared, oam_ram, &oam_generation))
+    {
+      obj_order_stale = 1;
+      video_memory_written = 1;
+    }
+  }
+
+  if(palette_update)
+  {
+    palette_update = 0;
+    video_memory_written |=
+     compare_video_memory(palette_ram_compared, palette_ram,
+     &palette_generation);
+  }
+
+  if(vram_update)
+  {
+    vram_update = 0;
+    vram_generation++;
+    video_memory_written = 1;
+  }
+
+  if(vcount == 0)
+  {
+    deferring_frame = deferred_rendering && !mid_frame_writes;
+    deferred_line_count = 0;
+    mid_frame_writes = 0;
+    video_snapshot_pending = deferring_frame;
+    video_snapshot_taken = 0;
+  }
+  else
+
+  if(video_memory_written)
+  {
+    mid_frame_writes = 1;
+    if(deferring_frame)
+    {
+      // The lines logged so far were displayed before the write, so render
+      // them against the copy taken just before it.
+      if(video_snapshot_taken)
+      {
+        swap_video_memory();
+        render_deferred_lines();
+        swap_video_memory();
+      }
+      else
+      {
+        // Something wrote to video memory without
+        // prepare_video_memory_write, and the lines will show its data.
+        ReGBA_Trace("E: Video memory written without a snapshot before "
+         "line %u", (unsigned int) vcount);
+        render_deferred_lines();
+      }
+      stop_deferring();
+    }
+  }
+
+  record.screen_offset = GBAScreen + (vcount * pitch);
+  record.vram_generation = vram_generation;
+  record.palette_generation = palette_generation;
+  record.oam_generation =
+   (io_registers[REG_DISPCNT] & 0x9000) ? oam_generation : 0;
+  save_scanline_state(&record.state);
+
+  if(ppu_dump_active)
+    ppu_dump_scanline(vcount);
+
+  if(deferring_frame && (vcount == deferred_line_count))
+  {
+    deferred_lines[vcount] = record;
+    deferred_line_count++;
+    if(deferred_line_count == GBA_SCREEN_HEIGHT)
+    {
+      render_deferred_lines();
+      stop_deferring();
+    }
+  }
+  else
+  {
+    // A line was missed; render what was logged and stop deferring.
+    if(deferring_frame)
+    {
+      render_deferred_lines();
+      stop_deferring();
+    }
+    render_scanline_record(vcount, &record);
+  }
+
   affine_reference_x[0] += (int16_t)io_registers[REG_BG2PB];
   affine_reference_y[0] += (int16_t)io_registers[REG_BG2PD];
   affine_reference_x[1] += (int16_t)io_registers[REG_BG3PB];
   affine_reference_y[1] += (int16_t)io_registers[REG_BG3PD];
+
+  if(headless_frame_rendering && (vcount == (GBA_SCREEN_HEIGHT - 1)))
+  {
+    headless_frame_rendering = 0;
+    headless_frames_rendered++;
+  }
+
+  if(unlikely(PerformanceCounters) && (vcount == (GBA_SCREEN_HEIGHT - 1)))
+  {
+    uint32_t mode;
+    for(mode = 0; mode < 8; mode++)
+    {
+      if(Stats.ScanlinesRendered[mode] != 0)
+        Stats.ScanlineRenderAverage[mode] = Stats.ScanlineRenderTime[mode] /
+         Stats.ScanlinesRendered[mode];
+    }
+  }
+}
+
+void update_scanline()
+{
+  enum FrameTimeCategory previous_time_category =
+   StatsEnterFrameTime(FRAME_TIME_PPU);
+  update_scanline_untimed();
+  StatsEnterFrameTime(previous_time_category);
 }
 
 #define video_savestate_body(type)                                            \
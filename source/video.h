@@ -29,6 +29,48 @@
 #define GBA_BLUE_MASK  0x7C00
 
 void update_scanline();
+void invalidate_scanline_records();
+
+// Non-zero to render each frame in one pass after its last visible line
+// rather than line by line; see video.c. Ports may set this at any time.
+extern uint32_t deferred_rendering;
+
+// Non-zero while a deferred frame needs video memory to be copied before it
+// is written to. Anything that writes to palette RAM, VRAM or OAM must use
+// prepare_video_memory_write first; the MIPS store handlers check it too.
+extern uint32_t video_snapshot_pending;
+void take_video_snapshot();
+
+#define prepare_video_memory_write()                                          \
+  if(unlikely(video_snapshot_pending))                                        \
+    take_video_snapshot()                                                     \
+
+// Non-zero to run without rendering frames or synthesising audio, for batch
+// runs and bots; see video.c. Ports should not present frames either.
+// Only the OpenDingux port sets it, from its command line.
+extern uint32_t headless_mode;
+// In headless mode, incremented each time a frame asked for with
+// request_headless_frame has been rendered into GBAScreen.
+extern uint32_t headless_frames_rendered;
+void request_headless_frame();
+
+// PPU state dumps, for tools/ppureplay.c. A dump starts with
+// PPU_DUMP_MAGIC, then holds palette RAM, OAM, VRAM and the first 0x400 bytes
+// of I/O registers as they were at the first visible line of a frame, then
+// a ppu_dump_line_struct for each visible line. It is in the byte order of
+// the processor that saved it.
+#define PPU_DUMP_MAGIC "ReGBA PPU dump 1"   // 16 bytes; 1 is the version
+
+typedef struct
+{
+  int32_t affine_reference_x[2];
+  int32_t affine_reference_y[2];
+  uint16_t registers[REG_BLDY + 1];  // DISPCNT to BLDY
+} ppu_dump_line_struct;
+
+// Dumps the first frame to be rendered once 'frames' more frames have
+// started. In headless mode, that frame is rendered for the dump.
+bool ppu_dump_open(const char *path, uint32_t frames);
 
 extern int32_t affine_reference_x[2];
 extern int32_t affine_reference_y[2];